@@ -0,0 +1,289 @@
+/*
+ * Copyright (c) 2010 NVIDIA, Corporation
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice (including the next
+ * paragraph) shall be included in all copies or substantial portions of the
+ * Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+/*
+ * nv-startup-benchmark.c - measure how long an nvidia-settings command
+ * line (e.g., `nvidia-settings --load-config-only`) takes to run, from
+ * fork(2) to exit, and compare it with a plain Xlib client that opens
+ * the display, queries the NV-CONTROL extension, and exits.
+ *
+ * nvidia-settings keeps its caches (the valid values of the
+ * NV-CONTROL attributes, and the parsed configuration file) in
+ * ~/.nvidia-settings-cache.  Each "cold" run is given an empty home
+ * directory, so it starts without those caches; the "warm" runs share
+ * a home directory that was prepared by one untimed run.  Pass an
+ * absolute --config path to nvidia-settings so that every run reads
+ * the same configuration file.  The kernel's page cache is not
+ * dropped between runs.
+ *
+ * Usage:
+ *
+ *   nv-startup-benchmark [-n runs] [-d display] -- nvidia-settings [args]
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <dirent.h>
+#include <sys/time.h>
+#include <sys/types.h>
+#include <sys/wait.h>
+
+#include <X11/Xlib.h>
+
+#include "NVCtrl.h"
+#include "NVCtrlLib.h"
+
+#define DEFAULT_RUNS 10
+#define CACHE_DIR ".nvidia-settings-cache"
+
+
+/*
+ * xlib_client() - the baseline: the least an NV-CONTROL client has to
+ * do.
+ */
+
+static int xlib_client(const char *display_name)
+{
+    Display *dpy;
+    int event_base, error_base, value;
+
+    dpy = XOpenDisplay(display_name);
+    if (!dpy) return 1;
+
+    if (!XNVCTRLQueryExtension(dpy, &event_base, &error_base) ||
+        !XNVCTRLQueryAttribute(dpy, DefaultScreen(dpy), 0,
+                               NV_CTRL_OPERATING_SYSTEM, &value)) {
+        XCloseDisplay(dpy);
+        return 1;
+    }
+
+    XCloseDisplay(dpy);
+
+    return 0;
+}
+
+
+static double now_ms(void)
+{
+    struct timeval tv;
+
+    gettimeofday(&tv, NULL);
+
+    return (tv.tv_sec * 1000.0) + (tv.tv_usec / 1000.0);
+}
+
+
+/*
+ * run() - run argv with the given home directory (if not NULL), and
+ * return how long it took in milliseconds, or -1 if it failed.
+ */
+
+static double run(char **argv, const char *home)
+{
+    double start;
+    pid_t pid;
+    int status, fd;
+
+    start = now_ms();
+
+    pid = fork();
+    if (pid == -1) return -1;
+
+    if (pid == 0) {
+        if (home) setenv("HOME", home, 1);
+        fd = open("/dev/null", O_WRONLY);
+        if (fd != -1) {
+            dup2(fd, STDOUT_FILENO);
+            dup2(fd, STDERR_FILENO);
+        }
+        execvp(argv[0], argv);
+        _exit(127);
+    }
+
+    if ((waitpid(pid, &status, 0) != pid) ||
+        !WIFEXITED(status) || (WEXITSTATUS(status) != 0)) {
+        return -1;
+    }
+
+    return now_ms() - start;
+}
+
+
+/*
+ * make_home() / remove_home() - create an empty home directory for a
+ * run, and remove it (and the caches written to it) afterwards.
+ */
+
+static char *make_home(void)
+{
+    char *dir = strdup("/tmp/nv-startup-benchmark-XXXXXX");
+
+    if (!dir || !mkdtemp(dir)) {
+        free(dir);
+        return NULL;
+    }
+
+    return dir;
+}
+
+static void remove_dir_files(const char *dir)
+{
+    DIR *d;
+    struct dirent *e;
+    char path[4096];
+
+    d = opendir(dir);
+    if (!d) return;
+
+    while ((e = readdir(d))) {
+        if (!strcmp(e->d_name, ".") || !strcmp(e->d_name, "..")) continue;
+        snprintf(path, sizeof(path), "%s/%s", dir, e->d_name);
+        unlink(path);
+    }
+
+    closedir(d);
+}
+
+static void remove_home(char *home)
+{
+    char cache[4096];
+
+    snprintf(cache, sizeof(cache), "%s/%s", home, CACHE_DIR);
+
+    remove_dir_files(cache);
+    rmdir(cache);
+    remove_dir_files(home);
+    rmdir(home);
+    free(home);
+}
+
+
+static int compare_doubles(const void *a, const void *b)
+{
+    double da = *(const double *) a, db = *(const double *) b;
+
+    return (da < db) ? -1 : (da > db);
+}
+
+static void report(const char *name, double *times, int n)
+{
+    qsort(times, n, sizeof(double), compare_doubles);
+
+    printf("%-12s runs %3d   min %8.2f ms   median %8.2f ms   "
+           "max %8.2f ms\n", name, n, times[0], times[n / 2], times[n - 1]);
+}
+
+
+int main(int argc, char *argv[])
+{
+    char *display_name = NULL, *self[4], *home;
+    char **command;
+    double *times;
+    int runs = DEFAULT_RUNS, i, c;
+
+    if ((argc == 3) && !strcmp(argv[1], "--xlib-client")) {
+        return xlib_client(argv[2][0] ? argv[2] : NULL);
+    }
+
+    while ((c = getopt(argc, argv, "n:d:")) != -1) {
+        switch (c) {
+        case 'n': runs = atoi(optarg); break;
+        case 'd': display_name = optarg; break;
+        default: goto usage;
+        }
+    }
+
+    if ((optind >= argc) || (runs < 1)) goto usage;
+
+    command = &argv[optind];
+
+    if (display_name) setenv("DISPLAY", display_name, 1);
+
+    times = malloc(runs * sizeof(double));
+    if (!times) return 1;
+
+    /* the plain Xlib client */
+
+    self[0] = argv[0];
+    self[1] = "--xlib-client";
+    self[2] = display_name ? display_name : "";
+    self[3] = NULL;
+
+    for (i = 0; i < runs; i++) {
+        times[i] = run(self, NULL);
+        if (times[i] < 0) {
+            fprintf(stderr, "The Xlib client failed; is the NV-CONTROL "
+                    "extension available?\n");
+            return 1;
+        }
+    }
+    report("xlib-client", times, runs);
+
+    /* cold runs: a new, empty home directory for each run */
+
+    for (i = 0; i < runs; i++) {
+        home = make_home();
+        if (!home) return 1;
+        times[i] = run(command, home);
+        remove_home(home);
+        if (times[i] < 0) {
+            fprintf(stderr, "'%s' failed.\n", command[0]);
+            return 1;
+        }
+    }
+    report("cold", times, runs);
+
+    /* warm runs: the caches written by an untimed run are kept */
+
+    home = make_home();
+    if (!home) return 1;
+
+    if (run(command, home) < 0) {
+        fprintf(stderr, "'%s' failed.\n", command[0]);
+        remove_home(home);
+        return 1;
+    }
+
+    for (i = 0; i < runs; i++) {
+        times[i] = run(command, home);
+        if (times[i] < 0) {
+            fprintf(stderr, "'%s' failed.\n", command[0]);
+            remove_home(home);
+            return 1;
+        }
+    }
+    report("warm", times, runs);
+
+    remove_home(home);
+    free(times);
+
+    return 0;
+
+ usage:
+    fprintf(stderr, "usage: %s [-n runs] [-d display] -- "
+            "nvidia-settings [args]\n", argv[0]);
+    return 1;
+}
@@ -32,6 +32,7 @@
 
 #include "option-table.h"
 #include "query-assign.h"
+#include "query-format.h"
 #include "msg.h"
 #include "nvgetopt.h"
 #include "glxinfo.h"
@@ -53,6 +54,7 @@ static void print_help(void);
 int __verbosity = VERBOSITY_DEFAULT;
 int __terse = NV_FALSE;
 int __display_device_string = NV_FALSE;
+int __query_format = NV_QUERY_FORMAT_TEXT;
 /*
  * print_version() - print version information
  */
@@ -219,27 +221,167 @@ void print_help(void)
 } /* print_help() */
 
 
+/*
+ * find_option() - return the __options[] entry for the long option
+ * name of the given length, or NULL.  As with nvgetopt(), boolean
+ * options may be prefixed with "no-"; *negated is set if they are.
+ */
+
+static const NVGetoptOption *find_option(const char *name, size_t len,
+                                         int *negated)
+{
+    int i;
+
+    *negated = NV_FALSE;
+
+    for (i = 0; __options[i].name; i++) {
+        if ((strlen(__options[i].name) == len) &&
+            (strncmp(__options[i].name, name, len) == 0)) {
+            return &__options[i];
+        }
+    }
+
+    if ((len > 3) && (strncmp(name, "no-", 3) == 0)) {
+        for (i = 0; __options[i].name; i++) {
+            if ((__options[i].flags & (NVGETOPT_IS_BOOLEAN |
+                                       NVGETOPT_ALLOW_DISABLE)) &&
+                (strlen(__options[i].name) == len - 3) &&
+                (strncmp(__options[i].name, name + 3, len - 3) == 0)) {
+                *negated = NV_TRUE;
+                return &__options[i];
+            }
+        }
+    }
+
+    return NULL;
+
+} /* find_option() */
+
+
+
+static const NVGetoptOption *find_short_option(char c)
+{
+    int i;
+
+    for (i = 0; __options[i].name; i++) {
+        if (__options[i].val == c) return &__options[i];
+    }
+
+    return NULL;
+
+} /* find_short_option() */
+
+
+
+/*
+ * is_headless_option() - return whether the option is one that is
+ * processed without starting the gui: loading the configuration file
+ * only, or assigning or querying attributes.
+ */
+
+static int is_headless_option(const NVGetoptOption *o)
+{
+    return (o->val == 'l') || (o->val == 'a') || (o->val == 'q');
+
+} /* is_headless_option() */
+
+
+
+/*
+ * nv_command_line_is_headless() - scan the commandline, before the gui
+ * is initialized, for the options that make nvidia-settings exit
+ * without starting the gui (--load-config-only, --assign and
+ * --query).  The commandline is scanned the same way nvgetopt() will
+ * parse it later.
+ *
+ * Returns NV_FALSE if there are none, or if there is anything that
+ * nvidia-settings does not recognize: that may be one of the gui
+ * toolkit's options (e.g., --display), which only the toolkit can
+ * remove from argv.
+ */
+
+int nv_command_line_is_headless(int argc, char *argv[])
+{
+    const NVGetoptOption *o;
+    const char *name, *c;
+    size_t len;
+    int i, negated, headless = NV_FALSE;
+
+    for (i = 1; i < argc; i++) {
+
+        if (argv[i][0] != '-') return NV_FALSE;
+
+        name = argv[i] + 1;
+        if (name[0] == '-') name++;
+
+        len = strcspn(name, "=");
+
+        if (len == 0) return NV_FALSE;
+
+        if (len == 1) {
+            o = find_short_option(name[0]);
+            negated = NV_FALSE;
+        } else {
+            o = find_option(name, len, &negated);
+        }
+
+        if (!o) {
+
+            /* several short options together; none takes an argument */
+
+            for (c = name; c < name + len; c++) {
+                o = find_short_option(*c);
+                if (!o || (o->flags & NVGETOPT_HAS_ARGUMENT)) {
+                    return NV_FALSE;
+                }
+                if (is_headless_option(o)) headless = NV_TRUE;
+            }
+            continue;
+        }
+
+        if (is_headless_option(o)) headless = NV_TRUE;
+
+        /* skip the argument of the option, if it is in the next entry */
+
+        if ((o->flags & NVGETOPT_HAS_ARGUMENT) && !negated &&
+            (name[len] != '=')) {
+            if ((o->flags & NVGETOPT_ARGUMENT_IS_OPTIONAL) &&
+                ((i == argc - 1) || (argv[i + 1][0] == '-'))) {
+                continue;
+            }
+            i++;
+        }
+    }
+
+    return headless;
+
+} /* nv_command_line_is_headless() */
+
+
+
 /*
  * parse_command_line() - malloc an Options structure, initialize it
  * with defaults, and fill in any pertinent data from the commandline
- * arguments.  This must be called after the gui is initialized (so
- * that the gui can remove its commandline arguments from argv).
- *
- * XXX it's unfortunate that we need to init the gui before calling
- * this, because many of the commandline options will cause us to not
- * even use the gui.
+ * arguments.  Unless the commandline is headless (see
+ * nv_command_line_is_headless()), this must be called after the gui
+ * is initialized (so that the gui can remove its commandline
+ * arguments from argv).
  */
 
 Options *parse_command_line(int argc, char *argv[], char *dpy)
 {
     Options *op;
-    int n, c;
+    int n, c, intval;
     char *strval;
 
     op = malloc(sizeof(Options));
     memset(op, 0, sizeof (Options));
     
     op->config = DEFAULT_RC_FILE;
+    op->fanout.max_jobs = 1;
+    op->watch_interval = DEFAULT_WATCH_INTERVAL;
+    op->sample.interval = NV_SAMPLE_DEFAULT_INTERVAL;
+    op->sample.history = NV_SAMPLE_DEFAULT_HISTORY;
     
     /*
      * initialize the controlled display to the gui display name
@@ -251,7 +393,7 @@ Options *parse_command_line(int argc, char *argv[], char *dpy)
     while (1) {
         c = nvgetopt(argc, argv, __options, &strval,
                      NULL,  /* boolval */
-                     NULL,  /* intval */
+                     &intval,
                      NULL,  /* doubleval */
                      NULL); /* disable_val */
 
@@ -301,6 +443,66 @@ Options *parse_command_line(int argc, char *argv[], char *dpy)
         case 't': __terse = NV_TRUE; break;
         case 'd': __display_device_string = NV_TRUE; break;
         case 'e': print_attribute_help(strval); exit(0); break;
+        case TRANSACTION_OPTION: op->transaction = NV_TRUE; break;
+        case BATCH_OPTION: op->batch = strval; break;
+        case DELTA_APPLY_OPTION: op->delta_apply = NV_TRUE; break;
+        case 'j':
+            if (intval < 1) {
+                nv_error_msg("Invalid number of jobs %d; please run `%s "
+                             "--help` for usage information.\n",
+                             intval, argv[0]);
+                exit(0);
+            }
+            op->fanout.max_jobs = intval;
+            break;
+        case QUERY_FORMAT_OPTION:
+            __query_format = nv_query_format_from_string(strval);
+            if (__query_format < 0) {
+                nv_error_msg("Invalid output format '%s'.  Please run "
+                             "`%s --help` for usage information.\n",
+                             strval, argv[0]);
+                exit(0);
+            }
+            break;
+        case DISPLAY_TIMEOUT_OPTION:
+            if (intval < 0) {
+                nv_error_msg("Invalid display timeout %d; please run `%s "
+                             "--help` for usage information.\n",
+                             intval, argv[0]);
+                exit(0);
+            }
+            op->fanout.timeout = intval;
+            break;
+        case WATCH_OPTION: op->watch = strval; break;
+        case WATCH_INTERVAL_OPTION:
+            if (intval < 1) {
+                nv_error_msg("Invalid watch interval %d; please run `%s "
+                             "--help` for usage information.\n",
+                             intval, argv[0]);
+                exit(0);
+            }
+            op->watch_interval = intval;
+            break;
+        case SAMPLE_OPTION: op->sample.file = tilde_expansion(strval); break;
+        case SAMPLE_ATTRIBUTES_OPTION: op->sample.attributes = strval; break;
+        case SAMPLE_INTERVAL_OPTION:
+            if (intval < 10) {
+                nv_error_msg("Invalid sample interval %d; please run `%s "
+                             "--help` for usage information.\n",
+                             intval, argv[0]);
+                exit(0);
+            }
+            op->sample.interval = intval;
+            break;
+        case SAMPLE_HISTORY_OPTION:
+            if (intval < 1) {
+                nv_error_msg("Invalid sample history %d; please run `%s "
+                             "--help` for usage information.\n",
+                             intval, argv[0]);
+                exit(0);
+            }
+            op->sample.history = intval;
+            break;
         default:
             nv_error_msg("Invalid commandline, please run `%s --help` "
                          "for usage information.\n", argv[0]);
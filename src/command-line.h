@@ -27,8 +27,24 @@
 
 #include <NvCtrlAttributes.h>
 
+#include "fanout.h"
+#include "sampler.h"
+
 #define DEFAULT_RC_FILE "~/.nvidia-settings-rc"
 #define CONFIG_FILE_OPTION 1
+#define DISPLAY_TIMEOUT_OPTION 2
+#define QUERY_FORMAT_OPTION 3
+#define WATCH_OPTION 4
+#define WATCH_INTERVAL_OPTION 5
+#define SAMPLE_OPTION 6
+#define SAMPLE_INTERVAL_OPTION 7
+#define SAMPLE_ATTRIBUTES_OPTION 8
+#define SAMPLE_HISTORY_OPTION 9
+#define TRANSACTION_OPTION 10
+#define BATCH_OPTION 11
+#define DELTA_APPLY_OPTION 12
+
+#define DEFAULT_WATCH_INTERVAL 1000 /* milliseconds */
 
 
 #define VERBOSITY_ERROR    0 /* errors only */
@@ -88,6 +104,12 @@ typedef struct {
                           * The attributes are not sent to the X Server.
                           */
 
+    int delta_apply;     /*
+                          * If true, only send the configuration file
+                          * attributes whose values differ from the
+                          * current ones.
+                          */
+
     int rewrite;         /*
                           * If true, write the X server configuration
                           * to the configuration file and exit.
@@ -98,9 +120,46 @@ typedef struct {
                           * when started.
                           */
 
+    char *batch;         /*
+                          * File (or "-" for stdin) of queries and
+                          * assignments to process, one per line.
+                          */
+
+    int transaction;     /*
+                          * If true, apply the commandline assignments
+                          * as one transaction: all or nothing.
+                          */
+
+    NvFanoutOptions fanout; /*
+                             * How many X displays to process at once,
+                             * and how long to wait for each, when
+                             * processing commandline queries and
+                             * assignments or the configuration file.
+                             */
+
+    char *watch;         /*
+                          * Comma separated list of attributes to
+                          * watch for changes, instead of starting
+                          * the GUI.
+                          */
+
+    int watch_interval;  /*
+                          * How often, in milliseconds, to sample the
+                          * watched attributes that do not generate
+                          * events.
+                          */
+
+    NvSamplerOptions sample; /*
+                              * Where, what, and how often to sample
+                              * GPU telemetry, instead of starting the
+                              * GUI.
+                              */
+
 } Options;
 
 
+int nv_command_line_is_headless(int argc, char *argv[]);
+
 Options *parse_command_line(int argc, char *argv[], char *dpy);
 
 #endif /* __COMMAND_LINE_H__ */
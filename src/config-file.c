@@ -47,6 +47,7 @@
 #include <stdlib.h>
 #include <time.h>
 #include <locale.h>
+#include <limits.h>
 
 #include "NvCtrlAttributes.h"
 
@@ -54,23 +55,131 @@
 #include "query-assign.h"
 #include "parse.h"
 #include "msg.h"
+#include "fanout.h"
+#include "common-utils.h"
 
 
-typedef struct {
+typedef struct _ParsedAttributeWrapper {
     ParsedAttribute a;
     int line;
     CtrlHandles *h;
+    struct _ParsedAttributeWrapper *next;
 } ParsedAttributeWrapper;
 
 
-static ParsedAttributeWrapper *parse_config_file(char *buf,
-                                                 const char *file,
-                                                 const int length,
-                                                 ConfigProperties *);
+/*
+ * The ParsedAttributeWrappers, and the X Display names they refer to,
+ * are bump allocated from a ConfigArena while the config file is
+ * parsed, and are all freed at once when they are no longer needed.
+ */
+
+#define CONFIG_ARENA_BLOCK_SIZE (64 * 1024)
+
+typedef struct _ConfigArenaBlock {
+    struct _ConfigArenaBlock *next;
+    size_t used;
+    size_t size;
+} ConfigArenaBlock;
+
+typedef struct _ConfigDisplayName {
+    char *name;
+    struct _ConfigDisplayName *next;
+} ConfigDisplayName;
+
+typedef struct {
+    ConfigArenaBlock *blocks;
+    ConfigDisplayName *displays;
+} ConfigArena;
+
+
+
+/*
+ * The config property lines of the file (see parse_config_property()),
+ * in file order; collected while parsing so that they can be saved in
+ * the config cache.
+ */
+
+typedef struct _ConfigPropertyLine {
+    char *line;
+    struct _ConfigPropertyLine *next;
+} ConfigPropertyLine;
+
+
+/*
+ * The config cache is a compiled copy of a parsed config file, saved
+ * in CONFIG_CACHE_DIR and mmap(2)'ed by later runs in place of parsing
+ * the file.  It is keyed on the path, size, mtime and inode of the
+ * config file, and on the attribute table it was built with.
+ *
+ * The file is a ConfigCacheHeader, followed by num_records
+ * ConfigCacheRecords, num_properties string offsets of the config
+ * property lines, num_floats floats (the color space conversion
+ * matrices of the records that have one), and strings_size bytes of
+ * NUL-terminated strings.
+ */
+
+#define CONFIG_CACHE_DIR    "~/.nvidia-settings-cache"
+#define CONFIG_CACHE_MAGIC  0x4e565243 /* "NVRC" */
+#define CONFIG_CACHE_FORMAT 1
+
+#define CONFIG_CACHE_NONE       0xffffffff
+#define CONFIG_CACHE_CSC_FLOATS 15
+
+typedef struct {
+    uint32_t magic;
+    uint32_t format;
+    uint32_t record_size;
+    uint32_t table_signature;
+    uint64_t file_size;
+    int64_t file_mtime;
+    int64_t file_mtime_nsec;
+    uint64_t file_ino;
+    uint32_t path;            /* string offset of the config file path */
+    uint32_t num_records;
+    uint32_t num_properties;
+    uint32_t num_floats;
+    uint32_t strings_size;
+    uint32_t pad;
+} ConfigCacheHeader;
+
+typedef struct {
+    int32_t line;
+    uint32_t display;         /* string offset, or CONFIG_CACHE_NONE */
+    int32_t entry;            /* index in attributeTable */
+    int32_t target_type;
+    int32_t target_id;
+    int32_t val;
+    float fval;
+    uint32_t pfval;           /* float index, or CONFIG_CACHE_NONE */
+    uint32_t display_device_mask;
+    uint32_t flags;
+} ConfigCacheRecord;
+
+
+static void *arena_alloc(ConfigArena *arena, size_t size);
+static char *arena_intern_display(ConfigArena *arena, const char *name);
+static void arena_free(ConfigArena *arena);
+
+static char *config_cache_filename(const char *file, char **path);
+static int load_config_cache(const char *file, const struct stat *stat_buf,
+                             ConfigProperties *conf, ConfigArena *arena,
+                             ParsedAttributeWrapper **list);
+static void save_config_cache(const char *file, const struct stat *stat_buf,
+                              ConfigPropertyLine *props,
+                              ParsedAttributeWrapper *w);
+
+static int parse_config_file(char *buf, const char *file,
+                             const int length, ConfigProperties *conf,
+                             ConfigArena *arena,
+                             ParsedAttributeWrapper **list,
+                             ConfigPropertyLine **props);
 
 static int process_config_file_attributes(const char *file,
                                           ParsedAttributeWrapper *w,
-                                          const char *display_name);
+                                          const char *display_name,
+                                          ConfigArena *arena,
+                                          const NvFanoutOptions *fanout,
+                                          int delta_apply);
 
 static void save_gui_parsed_attributes(ParsedAttributeWrapper *w,
                                        ParsedAttribute *p);
@@ -78,9 +187,20 @@ static void save_gui_parsed_attributes(ParsedAttributeWrapper *w,
 static float get_color_value(int attr,
                              float c[3], float b[3], float g[3]);
 
-static int parse_config_property(const char *file, const char *line,
+static int parse_config_property(const char *file, char *line,
                                  ConfigProperties *conf);
 
+static FILE *open_config_file_for_writing(const char *filename,
+                                          char **target_filename,
+                                          char **tmp_filename);
+
+static int commit_config_file(FILE *stream, char *target_filename,
+                              char *tmp_filename);
+
+static void write_attribute_state(FILE *stream, CtrlHandleTarget *t,
+                                  const char *prefix,
+                                  const AttributeTableEntry *a);
+
 static void write_config_properties(FILE *stream, ConfigProperties *conf,
                                     char *locale);
 
@@ -90,12 +210,18 @@ static void write_config_properties(FILE *stream, ConfigProperties *conf,
  * list of attributes to send.  Once all attributes are read, send
  * them to the X server.
  *
- * mmap(2) the file into memory for easier manipulation.
+ * mmap(2) the file into memory for easier manipulation; the mapping
+ * is private, so that lines can be parsed in place.  The parsed file
+ * is saved in the config cache, which later runs load instead of
+ * parsing the file again, for as long as the file is unchanged.
  *
  * If an error occurs while parsing the configuration file, an error
  * message is printed to stderr, NV_FALSE is returned, and nothing is
  * sent to the X server.
  *
+ * If delta_apply is true, only the attributes whose values differ
+ * from the current ones are sent (see nv_delta_apply_init()).
+ *
  * NOTE: The conf->locale should have already been setup by calling
  *       init_config_properties() prior to calling this function.
  *
@@ -104,12 +230,15 @@ static void write_config_properties(FILE *stream, ConfigProperties *conf,
  */
 
 int nv_read_config_file(const char *file, const char *display_name,
-                        ParsedAttribute *p, ConfigProperties *conf)
+                        ParsedAttribute *p, ConfigProperties *conf,
+                        const NvFanoutOptions *fanout, int delta_apply)
 {
     int fd, ret, length;
     struct stat stat_buf;
     char *buf, *locale;
     ParsedAttributeWrapper *w = NULL;
+    ConfigPropertyLine *props = NULL;
+    ConfigArena arena;
 
     if (!file) {
         /*
@@ -147,43 +276,61 @@ int nv_read_config_file(const char *file, const char *display_name,
 
     length = stat_buf.st_size;
 
+    /* 
+     * save the current locale, parse the actual text in the file (or
+     * load it from the config cache) and restore the saved locale
+     * (could be changed).
+     */
+
+    locale = strdup(conf->locale);
+
+    memset(&arena, 0, sizeof(arena));
+
+    if (load_config_cache(file, &stat_buf, conf, &arena, &w)) {
+        close(fd);
+        goto parsed;
+    }
+
     /* map the file into memory */
 
-    buf = mmap(0, length, PROT_READ, MAP_SHARED, fd, 0);
+    buf = mmap(0, length, PROT_READ | PROT_WRITE, MAP_PRIVATE, fd, 0);
     if (buf == (void *) -1) {
         nv_error_msg("Unable to mmap file '%s' for reading (%s).",
                      file, strerror(errno));
+        free(locale);
         return NV_FALSE;
     }
 
-
-    /* 
-     * save the current locale, parse the actual text in the file
-     * and restore the saved locale (could be changed).
-     */
-
-    locale = strdup(conf->locale);
-
-    w = parse_config_file(buf, file, length, conf);
-
-    setlocale(LC_NUMERIC, locale);
-    free(locale);
+    ret = parse_config_file(buf, file, length, conf, &arena, &w, &props);
 
     /* unmap and close the file */
 
     if (munmap (buf, stat_buf.st_size) == -1) {
         nv_error_msg("Unable to unmap file '%s' after reading (%s).",
                      file, strerror(errno));
-        return NV_FALSE;
+        ret = NV_FALSE;
     }
 
     close(fd);
     
-    if (!w) return NV_FALSE;
+    if (!ret) {
+        setlocale(LC_NUMERIC, locale);
+        free(locale);
+        arena_free(&arena);
+        return NV_FALSE;
+    }
+
+    save_config_cache(file, &stat_buf, props, w);
+
+ parsed:
+
+    setlocale(LC_NUMERIC, locale);
+    free(locale);
 
     /* process the parsed attributes */
 
-    ret = process_config_file_attributes(file, w, display_name);
+    ret = process_config_file_attributes(file, w, display_name, &arena,
+                                         fanout, delta_apply);
 
     /*
      * add any relevant parsed attributes back to the list to be
@@ -192,7 +339,12 @@ int nv_read_config_file(const char *file, const char *display_name,
 
     save_gui_parsed_attributes(w, p);
     
-    if (w) free(w);
+    /*
+     * a display job that timed out may still be using the display
+     * names in the arena
+     */
+
+    if (ret) arena_free(&arena);
 
     return ret;
     
@@ -204,17 +356,20 @@ int nv_read_config_file(const char *file, const char *display_name,
  * nv_write_config_file() - write a configuration file to the
  * specified filename.
  *
- * XXX how should this be handled?  Currently, we just query all
- * writable attributes, writing their current value to file.
+ * The current value of every writable attribute is written to file.
+ * For X screens tracked with nv_track_config_file_attributes() (i.e.,
+ * by the gui), the values are taken from the session state of the
+ * handle, without querying the server; otherwise, they are queried.
  *
- * XXX should query first, and only once we know we can't fail, then
- * write the file (to avoid deleting the existing file).
+ * The file is written to a temporary file in the same directory,
+ * which then replaces the configuration file with rename(2), so that
+ * the existing file is left intact if anything goes wrong.
  */
 
 int nv_write_config_file(const char *filename, CtrlHandles *h,
                          ParsedAttribute *p, ConfigProperties *conf)
 {
-    int screen, ret, entry, bit, val;
+    int screen, entry, bit, val;
     FILE *stream;
     time_t now;
     AttributeTableEntry *a;
@@ -223,6 +378,7 @@ int nv_write_config_file(const char *filename, CtrlHandles *h,
     uint32 mask;
     CtrlHandleTarget *t;
     char *tmp_d_str, *prefix, scratch[4];
+    char *target_filename, *tmp_filename;
     const char *tmp;
     char *locale = "C";
 
@@ -231,9 +387,9 @@ int nv_write_config_file(const char *filename, CtrlHandles *h,
         return NV_FALSE;
     }
 
-    stream = fopen(filename, "w");
+    stream = open_config_file_for_writing(filename, &target_filename,
+                                          &tmp_filename);
     if (!stream) {
-        nv_error_msg("Unable to open file '%s' for writing.", filename);
         return NV_FALSE;
     }
     
@@ -281,7 +437,7 @@ int nv_write_config_file(const char *filename, CtrlHandles *h,
     
     for (screen = 0; screen < h->targets[X_SCREEN_TARGET].n; screen++) {
 
-        t = &h->targets[X_SCREEN_TARGET].t[screen];
+        t = nv_get_ctrl_handle_target(h, X_SCREEN_TARGET, screen);
 
         /* skip it if we don't have a handle for this screen */
 
@@ -328,6 +484,17 @@ int nv_write_config_file(const char *filename, CtrlHandles *h,
                         get_color_value(a->attr, c, b, g));
                 continue;
             }
+
+            /*
+             * the gui keeps track of the NV-CONTROL attributes, so
+             * their values need not be queried again
+             */
+
+            if ((a->attr <= NV_CTRL_LAST_ATTRIBUTE) &&
+                NvCtrlAttributeStateIsEnabled(t->h)) {
+                write_attribute_state(stream, t, prefix, a);
+                continue;
+            }
             
             for (bit = 0; bit < 24; bit++) {
                 
@@ -452,202 +619,1139 @@ int nv_write_config_file(const char *filename, CtrlHandles *h,
 
     setlocale(LC_NUMERIC, conf->locale);
 
-    /* close the configuration file */
+    /* close the temporary file, and move it into place */
 
-    ret = fclose(stream);
-    if (ret != 0) {
-        nv_error_msg("Failure while closing file '%s'.", filename);
-        return NV_FALSE;
-    }
-    
-    return NV_TRUE;
+    return commit_config_file(stream, target_filename, tmp_filename);
     
 } /* nv_write_config_file() */
 
+/*
+ * nv_track_config_file_attributes() - enable the session state of the
+ * handles of the X screens in h, and seed it with the value and
+ * permissions of every attribute that nv_write_config_file() would
+ * save, using one batch of queries per X screen.  From then on, the
+ * state is kept current by the assignments made through the handles
+ * and by the attribute events passed to them, so that the
+ * configuration file can be written without querying the server.
+ */
+
+void nv_track_config_file_attributes(CtrlHandles *h)
+{
+    NvCtrlBatchQuery *queries;
+    CtrlHandleTarget *t;
+    AttributeTableEntry *a;
+    uint32 first;
+    int screen, entry, bit, displays, n;
+
+    if (!h) return;
+
+    for (screen = 0; screen < h->targets[X_SCREEN_TARGET].n; screen++) {
+
+        t = nv_get_ctrl_handle_target(h, X_SCREEN_TARGET, screen);
+
+        if (!t || !t->h) continue;
+
+        NvCtrlAttributeStateEnable(t->h, True);
+
+        /*
+         * query the valid values (for the permissions) on the first
+         * enabled display device, and the value on each of them
+         */
+
+        first = 0;
+        displays = 0;
+        for (bit = 0; bit < 24; bit++) {
+            if (t->d & (1 << bit)) {
+                if (!first) first = 1 << bit;
+                displays++;
+            }
+        }
+        if (!displays) displays = 1;
+
+        for (entry = 0; attributeTable[entry].name; entry++);
+
+        queries = nvalloc(entry * (displays + 1) * sizeof(NvCtrlBatchQuery));
+        n = 0;
+
+        for (entry = 0; attributeTable[entry].name; entry++) {
+
+            a = &attributeTable[entry];
+
+            if (a->flags & (NV_PARSER_TYPE_NO_CONFIG_WRITE |
+                            NV_PARSER_TYPE_COLOR_ATTRIBUTE)) continue;
+            if (a->attr > NV_CTRL_LAST_ATTRIBUTE) continue;
+
+            queries[n].handle = t->h;
+            queries[n].query_type = NV_CTRL_BATCH_GET_VALID_VALUES;
+            queries[n].display_mask = first;
+            queries[n].attr = a->attr;
+            n++;
+
+            for (bit = 0; bit < 24; bit++) {
+                if (t->d && !(t->d & (1 << bit))) continue;
+
+                queries[n].handle = t->h;
+                queries[n].query_type = NV_CTRL_BATCH_GET_ATTRIBUTE;
+                queries[n].display_mask = t->d ? (1 << bit) : 0;
+                queries[n].attr = a->attr;
+                n++;
+
+                if (!t->d) break;
+            }
+        }
+
+        NvCtrlQueryBatch(queries, n);
+
+        free(queries);
+    }
+
+} /* nv_track_config_file_attributes() */
+
+
+
+
+/*
+ * resolve_config_file() - return the file that writing to 'filename'
+ * actually replaces: 'filename' itself or, if that is a symbolic link,
+ * the file that it points to, which may be on another filesystem, and
+ * need not exist yet.  The returned string should be freed by the
+ * caller.
+ */
+
+static char *resolve_config_file(const char *filename)
+{
+    struct stat stat_buf;
+    char *target, *link, *dir, *slash;
+    ssize_t len;
+
+    if ((lstat(filename, &stat_buf) != 0) || !S_ISLNK(stat_buf.st_mode)) {
+        return nvstrdup(filename);
+    }
+
+    target = realpath(filename, NULL);
+    if (target) {
+        return target;
+    }
+
+    /* a dangling link; create the file it names, as fopen(3) would */
+
+    link = nvalloc(PATH_MAX);
+
+    len = readlink(filename, link, PATH_MAX - 1);
+    if (len <= 0) {
+        free(link);
+        return nvstrdup(filename);
+    }
+    link[len] = '\0';
+
+    /* a relative link is relative to the directory of the link */
+
+    slash = strrchr(filename, '/');
+    if ((link[0] == '/') || !slash) {
+        return link;
+    }
+
+    dir = nvstrdup(filename);
+    dir[slash - filename + 1] = '\0';
+    target = nvstrcat(dir, link, NULL);
+    free(dir);
+    free(link);
+
+    return target;
+
+} /* resolve_config_file() */
+
+
+
+/*
+ * open_config_file_for_writing() - create a temporary file to write
+ * the new configuration to.  The file is created in the directory of
+ * the file that will be replaced (see resolve_config_file()), whose
+ * name is returned in 'target_filename', so that it can be renamed
+ * over that file; its own name is returned in 'tmp_filename'.
+ */
+
+static FILE *open_config_file_for_writing(const char *filename,
+                                          char **target_filename,
+                                          char **tmp_filename)
+{
+    struct stat stat_buf;
+    mode_t mode, mask;
+    FILE *stream;
+    char *target, *tmp;
+    int fd;
+
+    target = resolve_config_file(filename);
+    tmp = nvstrcat(target, ".XXXXXX", NULL);
+
+    fd = mkstemp(tmp);
+    if (fd == -1) {
+        nv_error_msg("Unable to open file '%s' for writing (%s).",
+                     filename, strerror(errno));
+        free(target);
+        free(tmp);
+        return NULL;
+    }
+
+    /*
+     * mkstemp(3) creates the file readable by the owner only; give it
+     * the mode of the file it replaces, or else the mode that
+     * fopen(3) would have created it with
+     */
+
+    if (stat(target, &stat_buf) == 0) {
+        mode = stat_buf.st_mode & 07777;
+    } else {
+        mask = umask(0);
+        umask(mask);
+        mode = 0666 & ~mask;
+    }
+    fchmod(fd, mode);
+
+    stream = fdopen(fd, "w");
+    if (!stream) {
+        nv_error_msg("Unable to open file '%s' for writing.", tmp);
+        close(fd);
+        unlink(tmp);
+        free(target);
+        free(tmp);
+        return NULL;
+    }
+
+    *target_filename = target;
+    *tmp_filename = tmp;
+
+    return stream;
+
+} /* open_config_file_for_writing() */
+
+
+
+/*
+ * commit_config_file() - flush and close the temporary file written
+ * by nv_write_config_file(), and rename it over 'target_filename', as
+ * returned by open_config_file_for_writing().  The temporary file is
+ * removed on failure.
+ */
+
+static int commit_config_file(FILE *stream, char *target_filename,
+                              char *tmp_filename)
+{
+    int ret = NV_TRUE;
+
+    if ((fflush(stream) != 0) || ferror(stream) ||
+        (fsync(fileno(stream)) != 0)) {
+        nv_error_msg("Failure while writing file '%s'.", tmp_filename);
+        ret = NV_FALSE;
+    }
+
+    if (fclose(stream) != 0) {
+        nv_error_msg("Failure while closing file '%s'.", tmp_filename);
+        ret = NV_FALSE;
+    }
+
+    if (ret && (rename(tmp_filename, target_filename) != 0)) {
+        nv_error_msg("Unable to replace file '%s' (%s).",
+                     target_filename, strerror(errno));
+        ret = NV_FALSE;
+    }
+
+    if (!ret) {
+        unlink(tmp_filename);
+    }
+
+    free(target_filename);
+    free(tmp_filename);
+
+    return ret;
+
+} /* commit_config_file() */
+
+
+
+/*
+ * write_attribute_state() - write the values of the given writable
+ * attribute of the X screen t, as recorded in the session state of
+ * its handle.  Attributes whose value or permissions were never seen
+ * are not written.
+ */
+
+static void write_attribute_state(FILE *stream, CtrlHandleTarget *t,
+                                  const char *prefix,
+                                  const AttributeTableEntry *a)
+{
+    unsigned int permissions;
+    uint32 mask;
+    int64_t val;
+    char *tmp_d_str;
+    int bit;
+
+    if (!NvCtrlAttributeStateLookupPermissions(t->h, a->attr, &permissions) ||
+        !(permissions & ATTRIBUTE_TYPE_WRITE)) {
+        return;
+    }
+
+    if (!(permissions & ATTRIBUTE_TYPE_DISPLAY)) {
+        if (NvCtrlAttributeStateLookup(t->h, 0, a->attr, &val)) {
+            fprintf(stream, "%s%c%s=%d\n", prefix,
+                    DISPLAY_NAME_SEPARATOR, a->name, (int) val);
+        }
+        return;
+    }
+
+    for (bit = 0; bit < 24; bit++) {
+
+        mask = 1 << bit;
+
+        if (((t->d & mask) == 0x0) && (t->d)) continue;
+
+        if (!NvCtrlAttributeStateLookup(t->h, mask, a->attr, &val)) continue;
+
+        tmp_d_str = display_device_mask_to_display_device_name(mask);
+
+        fprintf(stream, "%s%c%s[%s]=%d\n", prefix,
+                DISPLAY_NAME_SEPARATOR, a->name, tmp_d_str, (int) val);
+
+        free(tmp_d_str);
+    }
+
+} /* write_attribute_state() */
+
+
+
+/*
+ * arena_alloc() - bump allocate size bytes from the arena; a new block
+ * is started when the current one is full.  Memory is zeroed, and
+ * aligned for any of the structures allocated from the arena.
+ */
+
+static void *arena_alloc(ConfigArena *arena, size_t size)
+{
+    ConfigArenaBlock *b = arena->blocks;
+    size_t header, block_size;
+    void *p;
+
+    header = (sizeof(ConfigArenaBlock) + sizeof(double) - 1) &
+        ~(sizeof(double) - 1);
+    size = (size + sizeof(double) - 1) & ~(sizeof(double) - 1);
+
+    if (!b || (b->used + size > b->size)) {
+        block_size = CONFIG_ARENA_BLOCK_SIZE;
+        if (header + size > block_size) block_size = header + size;
+
+        b = malloc(block_size);
+        if (!b) return NULL;
+
+        b->next = arena->blocks;
+        b->used = header;
+        b->size = block_size;
+        arena->blocks = b;
+    }
+
+    p = (char *) b + b->used;
+    b->used += size;
+
+    memset(p, 0, size);
+
+    return p;
+
+} /* arena_alloc() */
+
+
+
+/*
+ * arena_intern_display() - return the arena's copy of the X Display
+ * name, making one the first time the name is seen.  A config file
+ * names very few distinct displays, so a list is searched, starting
+ * with the name added last.
+ */
+
+static char *arena_intern_display(ConfigArena *arena, const char *name)
+{
+    ConfigDisplayName *d;
+    size_t len;
+
+    if (!name) return NULL;
+
+    for (d = arena->displays; d; d = d->next) {
+        if (strcmp(d->name, name) == 0) return d->name;
+    }
+
+    len = strlen(name);
+
+    d = arena_alloc(arena, sizeof(ConfigDisplayName));
+    if (!d) return NULL;
+
+    d->name = arena_alloc(arena, len + 1);
+    if (!d->name) return NULL;
+
+    memcpy(d->name, name, len + 1);
+
+    d->next = arena->displays;
+    arena->displays = d;
+
+    return d->name;
+
+} /* arena_intern_display() */
+
+
+
+static void arena_free(ConfigArena *arena)
+{
+    ConfigArenaBlock *b, *next;
+
+    for (b = arena->blocks; b; b = next) {
+        next = b->next;
+        free(b);
+    }
+
+    arena->blocks = NULL;
+    arena->displays = NULL;
+}
+
+
+
+/*
+ * attribute_table_signature() - return a signature of the attribute
+ * table, and the number of entries in it; a config cache built against
+ * a different table (i.e., by a different nvidia-settings) is not
+ * used.
+ */
+
+static uint32_t attribute_table_signature(int *entries)
+{
+    static uint32_t signature = 0;
+    static int num_entries = -1;
+    int i;
+
+    if (num_entries < 0) {
+        for (i = 0; attributeTable[i].name; i++) {
+            signature = nv_attribute_name_hash(attributeTable[i].name,
+                                               signature ^
+                                               attributeTable[i].attr ^
+                                               attributeTable[i].flags);
+        }
+        num_entries = i;
+        signature ^= num_entries;
+    }
+
+    *entries = num_entries;
+
+    return signature;
+
+} /* attribute_table_signature() */
+
 
 
 /*
- * parse_config_file() - scan through the buffer; skipping comment
- * lines.  Non-comment lines with non-whitespace characters are passed
- * on to nv_parse_attribute_string for parsing.
+ * config_cache_filename() - return the name of the config cache file
+ * for the config file 'file', and the absolute path of the config
+ * file in 'path'.  Returns NULL if the path cannot be resolved.
+ */
+
+static char *config_cache_filename(const char *file, char **path)
+{
+    char *dir, *filename, *c;
+
+    *path = realpath(file, NULL);
+    if (!*path) return NULL;
+
+    dir = tilde_expansion(CONFIG_CACHE_DIR);
+    if (!dir) {
+        free(*path);
+        return NULL;
+    }
+
+    /* the path may not contain '/' in the file name */
+
+    filename = nvstrcat(dir, "/rc-", *path, NULL);
+    free(dir);
+
+    for (c = filename + strlen(filename) - strlen(*path); *c; c++) {
+        if (*c == '/') *c = '_';
+    }
+
+    return filename;
+
+} /* config_cache_filename() */
+
+
+
+/*
+ * load_config_cache() - if the config cache for the config file
+ * 'file' (whose stat(2) information is 'stat_buf') is up to date,
+ * build the list of ParsedAttributeWrappers from it, in the arena, and
+ * apply its config property lines to conf.  Returns NV_FALSE if the
+ * cache cannot be used, in which case the file should be parsed.
+ */
+
+static int load_config_cache(const char *file, const struct stat *stat_buf,
+                             ConfigProperties *conf, ConfigArena *arena,
+                             ParsedAttributeWrapper **list)
+{
+    const ConfigCacheHeader *header;
+    const ConfigCacheRecord *records, *r;
+    const uint32_t *props;
+    const float *floats;
+    const char *strings;
+    struct stat cache_stat;
+    ParsedAttributeWrapper *w, **tail;
+    char *filename, *path, *display = NULL, *line;
+    float *matrix;
+    uint32_t i, display_offset = CONFIG_CACHE_NONE, signature;
+    size_t size;
+    void *map;
+    int fd, entries, ret = NV_FALSE;
+
+    filename = config_cache_filename(file, &path);
+    if (!filename) return NV_FALSE;
+
+    fd = open(filename, O_RDONLY);
+    free(filename);
+
+    if (fd == -1) {
+        free(path);
+        return NV_FALSE;
+    }
+
+    if ((fstat(fd, &cache_stat) == -1) ||
+        (cache_stat.st_size < sizeof(ConfigCacheHeader))) {
+        close(fd);
+        free(path);
+        return NV_FALSE;
+    }
+
+    map = mmap(NULL, cache_stat.st_size, PROT_READ, MAP_SHARED, fd, 0);
+    close(fd);
+
+    if (map == MAP_FAILED) {
+        free(path);
+        return NV_FALSE;
+    }
+
+    /* check that the cache matches the config file and this build */
+
+    header = map;
+    records = (const ConfigCacheRecord *) (header + 1);
+    props = (const uint32_t *) (records + header->num_records);
+    floats = (const float *) (props + header->num_properties);
+    strings = (const char *) (floats + header->num_floats);
+
+    size = sizeof(ConfigCacheHeader) +
+        (size_t) header->num_records * sizeof(ConfigCacheRecord) +
+        (size_t) header->num_properties * sizeof(uint32_t) +
+        (size_t) header->num_floats * sizeof(float) +
+        header->strings_size;
+
+    signature = attribute_table_signature(&entries);
+
+    if ((header->magic != CONFIG_CACHE_MAGIC) ||
+        (header->format != CONFIG_CACHE_FORMAT) ||
+        (header->record_size != sizeof(ConfigCacheRecord)) ||
+        (header->table_signature != signature) ||
+        (cache_stat.st_size != size) ||
+        (header->file_size != stat_buf->st_size) ||
+        (header->file_mtime != stat_buf->st_mtime) ||
+        (header->file_mtime_nsec != stat_buf->st_mtim.tv_nsec) ||
+        (header->file_ino != stat_buf->st_ino) ||
+        (header->strings_size == 0) ||
+        (strings[header->strings_size - 1] != '\0') ||
+        (header->path >= header->strings_size) ||
+        (strcmp(strings + header->path, path) != 0)) {
+        goto done;
+    }
+
+    for (i = 0; i < header->num_records; i++) {
+        r = &records[i];
+        if ((r->entry < 0) || (r->entry >= entries) ||
+            ((r->display != CONFIG_CACHE_NONE) &&
+             (r->display >= header->strings_size)) ||
+            ((r->pfval != CONFIG_CACHE_NONE) &&
+             ((r->pfval > header->num_floats) ||
+              (header->num_floats - r->pfval < CONFIG_CACHE_CSC_FLOATS)))) {
+            goto done;
+        }
+    }
+
+    for (i = 0; i < header->num_properties; i++) {
+        if (props[i] >= header->strings_size) goto done;
+    }
+
+    /* build the list of ParsedAttributeWrappers */
+
+    *list = NULL;
+    tail = list;
+
+    for (i = 0; i < header->num_records; i++) {
+
+        r = &records[i];
+
+        w = arena_alloc(arena, sizeof(ParsedAttributeWrapper));
+        if (!w) goto nomem;
+
+        w->a.name = attributeTable[r->entry].name;
+        w->a.attr = attributeTable[r->entry].attr;
+        w->a.target_type = r->target_type;
+        w->a.target_id = r->target_id;
+        w->a.val = r->val;
+        w->a.fval = r->fval;
+        w->a.display_device_mask = r->display_device_mask;
+        w->a.flags = r->flags;
+
+        if (r->pfval != CONFIG_CACHE_NONE) {
+            matrix = arena_alloc(arena, CONFIG_CACHE_CSC_FLOATS *
+                                 sizeof(float));
+            if (!matrix) goto nomem;
+            memcpy(matrix, floats + r->pfval,
+                   CONFIG_CACHE_CSC_FLOATS * sizeof(float));
+            w->a.pfval = matrix;
+        }
+
+        if (r->display != CONFIG_CACHE_NONE) {
+            if (r->display != display_offset) {
+                display = arena_intern_display(arena, strings + r->display);
+                if (!display) goto nomem;
+                display_offset = r->display;
+            }
+            w->a.display = display;
+        }
+
+        w->line = r->line;
+        *tail = w;
+        tail = &w->next;
+    }
+
+    /* apply the config properties, in file order */
+
+    for (i = 0; i < header->num_properties; i++) {
+        line = strdup(strings + props[i]);
+        if (!line) goto nomem;
+        parse_config_property(file, line, conf);
+        free(line);
+    }
+
+    ret = NV_TRUE;
+    goto done;
+
+ nomem:
+
+    /* start over, and parse the file instead */
+
+    arena_free(arena);
+    *list = NULL;
+
+ done:
+
+    munmap(map, cache_stat.st_size);
+    free(path);
+
+    return ret;
+
+} /* load_config_cache() */
+
+
+
+typedef struct {
+    char *data;
+    uint32_t size;
+    uint32_t alloc;
+} ConfigCacheStrings;
+
+/*
+ * add_cache_string() - append str to the string table; returns its
+ * offset, or CONFIG_CACHE_NONE if out of memory.
+ */
+
+static uint32_t add_cache_string(ConfigCacheStrings *strings, const char *str)
+{
+    uint32_t len = strlen(str) + 1, offset;
+    char *tmp;
+
+    if (strings->size + len > strings->alloc) {
+        uint32_t n = strings->alloc ? (strings->alloc * 2) : 256;
+        while (n < strings->size + len) n *= 2;
+        tmp = realloc(strings->data, n);
+        if (!tmp) return CONFIG_CACHE_NONE;
+        strings->data = tmp;
+        strings->alloc = n;
+    }
+
+    offset = strings->size;
+    memcpy(strings->data + offset, str, len);
+    strings->size += len;
+
+    return offset;
+
+} /* add_cache_string() */
+
+
+
+/*
+ * save_config_cache() - save the parsed config file in the config
+ * cache.  The file is written under a temporary name and renamed into
+ * place, so that other nvidia-settings processes never map a partial
+ * file.  Failures are silently ignored; the config file is just
+ * parsed again next time.
+ */
+
+static void save_config_cache(const char *file, const struct stat *stat_buf,
+                              ConfigPropertyLine *props,
+                              ParsedAttributeWrapper *w)
+{
+    ConfigCacheHeader header;
+    ConfigCacheRecord *records = NULL, *r;
+    ConfigCacheStrings strings;
+    ConfigPropertyLine *prop;
+    ParsedAttributeWrapper *cur;
+    AttributeTableEntry *t;
+    uint32_t *prop_offsets = NULL, display_offset = CONFIG_CACHE_NONE;
+    float *floats = NULL;
+    const char *display = NULL;
+    char *filename, *path, *dir, *tmpname, pid[16];
+    int entries, num_records = 0, num_props = 0, num_floats = 0, ok = NV_FALSE;
+    FILE *fp;
+
+    filename = config_cache_filename(file, &path);
+    if (!filename) return;
+
+    memset(&strings, 0, sizeof(strings));
+    memset(&header, 0, sizeof(header));
+
+    header.magic = CONFIG_CACHE_MAGIC;
+    header.format = CONFIG_CACHE_FORMAT;
+    header.record_size = sizeof(ConfigCacheRecord);
+    header.table_signature = attribute_table_signature(&entries);
+    header.file_size = stat_buf->st_size;
+    header.file_mtime = stat_buf->st_mtime;
+    header.file_mtime_nsec = stat_buf->st_mtim.tv_nsec;
+    header.file_ino = stat_buf->st_ino;
+
+    header.path = add_cache_string(&strings, path);
+    if (header.path == CONFIG_CACHE_NONE) goto done;
+
+    for (cur = w; cur; cur = cur->next) {
+        num_records++;
+        if (cur->a.pfval) num_floats += CONFIG_CACHE_CSC_FLOATS;
+    }
+    for (prop = props; prop; prop = prop->next) num_props++;
+
+    records = calloc(num_records + 1, sizeof(ConfigCacheRecord));
+    prop_offsets = calloc(num_props + 1, sizeof(uint32_t));
+    floats = calloc(num_floats + 1, sizeof(float));
+    if (!records || !prop_offsets || !floats) goto done;
+
+    /* display names are interned, so each is only added once in a row */
+
+    num_floats = 0;
+
+    for (cur = w, r = records; cur; cur = cur->next, r++) {
+
+        t = nv_get_attribute_entry(cur->a.name);
+        if (!t) goto done;
+
+        r->line = cur->line;
+        r->entry = t - attributeTable;
+        r->target_type = cur->a.target_type;
+        r->target_id = cur->a.target_id;
+        r->val = cur->a.val;
+        r->fval = cur->a.fval;
+        r->display_device_mask = cur->a.display_device_mask;
+        r->flags = cur->a.flags;
+        r->pfval = CONFIG_CACHE_NONE;
+        r->display = CONFIG_CACHE_NONE;
+
+        if (cur->a.pfval) {
+            memcpy(floats + num_floats, cur->a.pfval,
+                   CONFIG_CACHE_CSC_FLOATS * sizeof(float));
+            r->pfval = num_floats;
+            num_floats += CONFIG_CACHE_CSC_FLOATS;
+        }
+
+        if (cur->a.display) {
+            if (cur->a.display != display) {
+                display = cur->a.display;
+                display_offset = add_cache_string(&strings, display);
+                if (display_offset == CONFIG_CACHE_NONE) goto done;
+            }
+            r->display = display_offset;
+        }
+    }
+
+    for (prop = props, num_props = 0; prop; prop = prop->next, num_props++) {
+        prop_offsets[num_props] = add_cache_string(&strings, prop->line);
+        if (prop_offsets[num_props] == CONFIG_CACHE_NONE) goto done;
+    }
+
+    header.num_records = num_records;
+    header.num_properties = num_props;
+    header.num_floats = num_floats;
+    header.strings_size = strings.size;
+
+    /* write the file */
+
+    dir = tilde_expansion(CONFIG_CACHE_DIR);
+    mkdir(dir, 0700);
+    free(dir);
+
+    snprintf(pid, sizeof(pid), ".%d", (int) getpid());
+    tmpname = nvstrcat(filename, pid, NULL);
+
+    fp = fopen(tmpname, "w");
+    if (fp) {
+        ok = (fwrite(&header, sizeof(header), 1, fp) == 1) &&
+            (fwrite(records, sizeof(ConfigCacheRecord), num_records, fp) ==
+             num_records) &&
+            (fwrite(prop_offsets, sizeof(uint32_t), num_props, fp) ==
+             num_props) &&
+            (fwrite(floats, sizeof(float), num_floats, fp) == num_floats) &&
+            (fwrite(strings.data, 1, strings.size, fp) == strings.size);
+
+        if ((fclose(fp) != 0) || !ok ||
+            (rename(tmpname, filename) != 0)) {
+            unlink(tmpname);
+        }
+    }
+
+    free(tmpname);
+
+ done:
+
+    free(records);
+    free(prop_offsets);
+    free(floats);
+    free(strings.data);
+    free(filename);
+    free(path);
+
+} /* save_config_cache() */
+
+
+
+/*
+ * parse_config_file() - scan through the buffer once; skipping comment
+ * lines.  White space is squeezed out of each line in place as it is
+ * scanned, and non-comment lines with non-whitespace characters are
+ * passed on to nv_parse_attribute_string_in_place() for parsing.
+ *
+ * The buffer must be writable.  The ParsedAttributeWrappers are
+ * allocated from the arena, and their display names are interned in
+ * the arena, so nothing points into the buffer once this returns.
  *
- * If an error occurs, an error message is printed and NULL is
- * returned.  If successful, a malloced array of
- * ParsedAttributeWrapper structs is returned.  The last
- * ParsedAttributeWrapper in the array has line == -1.  It is the
- * caller's responsibility to free the array.
+ * If an error occurs, an error message is printed and NV_FALSE is
+ * returned.  If successful, *list is set to the list of
+ * ParsedAttributeWrappers, and *props to the list of config property
+ * lines, in file order.
  */
 
-static ParsedAttributeWrapper *parse_config_file(char *buf, const char *file,
-                                                 const int length,
-                                                 ConfigProperties *conf)
+static int parse_config_file(char *buf, const char *file,
+                             const int length, ConfigProperties *conf,
+                             ConfigArena *arena,
+                             ParsedAttributeWrapper **list,
+                             ConfigPropertyLine **props)
 {
-    int line, has_data, current_tmp_len, len, n, ret;
-    char *cur, *c, *comment, *tmp;
-    ParsedAttributeWrapper *w;
-    
+    int line, comment, last, ret;
+    char *end, *cur, *c, *out, *tmp;
+    ParsedAttributeWrapper *w, **tail;
+    ConfigPropertyLine *prop, **prop_tail;
+
+    *list = NULL;
+    tail = list;
+
+    *props = NULL;
+    prop_tail = props;
+
+    end = buf + length;
     cur = buf;
     line = 1;
-    current_tmp_len = 0;
-    n = 0;
-    w = NULL;
-    tmp = NULL;
 
     while (cur) {
-        c = cur;
-        comment = NULL;
-        has_data = NV_FALSE;;
-        
-        while (((c - buf) < length) &&
-               (*c != '\n') &&
-               (*c != '\0') &&
-               (*c != EOF)) {
-            if (comment) { c++; continue; }
-            if (*c == '#') { comment = c; continue; }
-            if (!isspace(*c)) has_data = NV_TRUE;
-            c++;
+        out = cur;
+        comment = NV_FALSE;
+
+        for (c = cur; (c < end) && (*c != '\n') && (*c != '\0') &&
+                 (*c != EOF); c++) {
+            if (comment) continue;
+            if (*c == '#') { comment = NV_TRUE; continue; }
+            if (!isspace(*c)) *out++ = *c;
         }
-        
-        if (has_data) {
-            if (!comment) comment = c;
-            len = comment - cur;
-            
-            /* grow the tmp buffer if it's too small */
-            
-            if (len >= current_tmp_len) {
-                current_tmp_len = len + 1;
-                if (tmp) {
-                    free(tmp);
-                }
-                tmp = malloc(sizeof(char) * current_tmp_len);
-            }
 
-            strncpy (tmp, cur, len);
-            tmp[len] = '\0';
+        last = (c >= end) || (*c == '\0') || (*c == EOF);
+
+        if (out != cur) {
+
+            /*
+             * terminate the squeezed line in place; the last line of
+             * the file may have nowhere to put the terminator, so it is
+             * copied
+             */
+
+            if (c < end) {
+                *out = '\0';
+                tmp = cur;
+            } else {
+                tmp = arena_alloc(arena, out - cur + 1);
+                if (!tmp) goto nomem;
+                memcpy(tmp, cur, out - cur);
+            }
 
             /* first, see if this line is a config property */
 
-            if (!parse_config_property(file, tmp, conf)) {
-                
-                w = realloc(w, sizeof(ParsedAttributeWrapper) * (n+1));
-            
-                ret = nv_parse_attribute_string(tmp,
-                                                NV_PARSER_ASSIGNMENT,
-                                                &w[n].a);
+            if (parse_config_property(file, tmp, conf)) {
+
+                /*
+                 * keep a copy of the line for the config cache; the
+                 * first '=' was replaced by parse_config_property()
+                 */
+
+                prop = arena_alloc(arena, sizeof(ConfigPropertyLine));
+                if (!prop) goto nomem;
+
+                prop->line = arena_alloc(arena, out - cur + 1);
+                if (!prop->line) goto nomem;
+
+                memcpy(prop->line, tmp, out - cur);
+                prop->line[strlen(tmp)] = '=';
+
+                *prop_tail = prop;
+                prop_tail = &prop->next;
+
+            } else {
+
+                w = arena_alloc(arena, sizeof(ParsedAttributeWrapper));
+                if (!w) goto nomem;
+
+                ret = nv_parse_attribute_string_in_place(tmp,
+                                                         NV_PARSER_ASSIGNMENT,
+                                                         &w->a);
                 if (ret != NV_PARSER_STATUS_SUCCESS) {
                     nv_error_msg("Error parsing configuration file '%s' on "
                                  "line %d: '%s' (%s).",
                                  file, line, tmp, nv_parse_strerror(ret));
-                    goto failed;
+                    return NV_FALSE;
                 }
-            
-                w[n].line = line;
-                n++;
+
+                if (w->a.display) {
+                    w->a.display = arena_intern_display(arena, w->a.display);
+                    if (!w->a.display) goto nomem;
+                }
+
+                w->line = line;
+                *tail = w;
+                tail = &w->next;
             }
         }
 
-        if (((c - buf) >= length) || (*c == '\0') || (*c == EOF)) cur = NULL;
+        if (last) cur = NULL;
         else cur = c + 1;
         
         line++;
     }
-    free(tmp);
-    /* mark the end of the array */
 
-    w = realloc(w, sizeof(ParsedAttributeWrapper) * (n+1));
-    w[n].line = -1;
-    
-    return w;
+    return NV_TRUE;
 
- failed:
-    if (w) free(w);
-    free(tmp);
-    return NULL;
+ nomem:
+    nv_error_msg("Unable to allocate memory while parsing configuration "
+                 "file '%s'.", file);
+    return NV_FALSE;
 
 } /* parse_config_file() */
 
 
 
 
+/*
+ * The config file attributes for one X display; processed by one
+ * fan-out job.  The attributes are copied out of the list returned by
+ * parse_config_file(), so that a job that times out does not hold on
+ * to that list.
+ */
+
+typedef struct {
+    const char *file;
+    char *display;
+    ParsedAttributeWrapper *w;
+    int num;
+    int delta_apply;
+} ConfigFileDisplay;
+
+
+
+/*
+ * process_config_file_display() - open the display, and process each
+ * of its attributes.
+ */
+
+static int process_config_file_display(void *data)
+{
+    ConfigFileDisplay *d = data;
+    CtrlHandles *h;
+    NvDeltaApply *delta = NULL;
+    int i, sent, skipped;
+
+    h = nv_alloc_ctrl_handles(d->display);
+
+    if (d->delta_apply && h && h->dpy) {
+        delta = nv_delta_apply_init(h);
+    }
+
+    for (i = 0; i < d->num; i++) {
+
+        d->w[i].h = h;
+
+        if (delta) {
+            nv_delta_apply_add(delta, &d->w[i].a,
+                               "on line %d of configuration file '%s'",
+                               d->w[i].line, d->file);
+            continue;
+        }
+
+        nv_process_parsed_attribute(&d->w[i].a, h, NV_TRUE, NV_FALSE,
+                                    "on line %d of configuration file "
+                                    "'%s'", d->w[i].line, d->file);
+        /*
+         * We do not fail if processing the attribute failed.  If the
+         * GPU or the X config changed (for example stereo is
+         * disabled), some attributes written in the config file may
+         * not be advertised by the the NVCTRL extension (for example
+         * the control to force stereo)
+         */
+    }
+
+    if (delta) {
+        nv_delta_apply_finish(delta, &sent, &skipped);
+        nv_msg(NULL, "Configuration file '%s': %d assignment%s sent to "
+               "'%s'; %d skipped, as the values were already set.",
+               d->file, sent, (sent == 1) ? "" : "s",
+               DisplayString(h->dpy), skipped);
+    }
+
+    nv_free_ctrl_handles(h);
+
+    return NV_TRUE;
+
+} /* process_config_file_display() */
+
+
+
 /*
  * process_config_file_attributes() - process the list of
  * attributes to be assigned that we acquired in parsing the config
  * file.
+ *
+ * The attributes are grouped by X display, and each display is
+ * processed by one fan-out job (see fanout.h); within a display, the
+ * attributes are processed in the order in which they appear in the
+ * file.
  */
 
 static int process_config_file_attributes(const char *file,
                                           ParsedAttributeWrapper *w,
-                                          const char *display_name)
+                                          const char *display_name,
+                                          ConfigArena *arena,
+                                          const NvFanoutOptions *fanout,
+                                          int delta_apply)
 {
-    int i, j, ret, found, n = 0;
-    CtrlHandles **h = NULL;
-    
+    int j, ret, n = 0;
+    ConfigFileDisplay *d = NULL;
+    ParsedAttributeWrapper *cur;
+    NvFanoutJob *jobs;
+    char *default_display;
+
     /*
      * make sure that all ParsedAttributes have displays (this will do
-     * nothing if we already have a display name
+     * nothing if we already have a display name); the default display
+     * name is interned like the others, rather than copied for each
+     * attribute
      */
 
-    for (i = 0; w[i].line != -1; i++) {
-        nv_assign_default_display(&w[i].a, display_name);
+    default_display = arena_intern_display(arena, display_name);
+
+    for (cur = w; cur; cur = cur->next) {
+        if (!(cur->a.flags & NV_PARSER_HAS_X_DISPLAY)) {
+            cur->a.display = default_display;
+            cur->a.flags |= NV_PARSER_HAS_X_DISPLAY;
+        }
+        nv_assign_default_display(&cur->a, NULL);
     }
     
-    /* build the list of CtrlHandles */
+    /*
+     * build the list of displays, and count the attributes for each;
+     * then copy the attributes of each display into an array sized to
+     * fit
+     *
+     * XXX we should really also build a list of what subsystems each
+     * display needs, so that we don't have to pass
+     * NV_CTRL_ATTRIBUTES_ALL_SUBSYSTEMS to NvCtrlAttributeInit (done
+     * in nv_alloc_ctrl_handles()) unless we really need it.
+     */
     
-    for (i = 0; w[i].line != -1; i++) {
-        found = NV_FALSE;
+    for (cur = w; cur; cur = cur->next) {
         for (j = 0; j < n; j++) {
-            if (nv_strcasecmp(h[j]->display, w[i].a.display)) {
-                w[i].h = h[j];
-                found = NV_TRUE;
+            if ((d[j].display == cur->a.display) ||
+                nv_strcasecmp(d[j].display, cur->a.display)) {
                 break;
             }
         }
 
-        /*
-         * no handle found for this display, need to create a new
-         * handle.
-         *
-         * XXX we should really just build a list of what ctrl_handles
-         * we need, and what attributes on which ctrl_handles, so that
-         * we don't have to pass NV_CTRL_ATTRIBUTES_ALL_SUBSYSTEMS to
-         * NvCtrlAttributeInit (done in nv_alloc_ctrl_handles())
-         * unless we really need it.
-         */
-
-        if (!found) {
-            h = realloc(h, sizeof(CtrlHandles *) * (n + 1));
-            h[n] = nv_alloc_ctrl_handles(w[i].a.display);
-            w[i].h = h[n];
+        if (j == n) {
+            d = realloc(d, sizeof(ConfigFileDisplay) * (n + 1));
+            d[n].file = file;
+            d[n].display = cur->a.display;
+            d[n].w = NULL;
+            d[n].num = 0;
+            d[n].delta_apply = delta_apply;
             n++;
         }
+
+        d[j].num++;
     }
-    
-    /* now process each attribute, passing in the correct CtrlHandles */
 
-    for (i = 0; w[i].line != -1; i++) {
+    for (j = 0; j < n; j++) {
+        d[j].w = malloc(sizeof(ParsedAttributeWrapper) * d[j].num);
+        d[j].num = 0;
+    }
 
-        ret = nv_process_parsed_attribute(&w[i].a, w[i].h, NV_TRUE, NV_FALSE,
-                                          "on line %d of configuration file "
-                                          "'%s'", w[i].line, file);
-        /*
-         * We do not fail if processing the attribute failed.  If the
-         * GPU or the X config changed (for example stereo is
-         * disabled), some attributes written in the config file may
-         * not be advertised by the the NVCTRL extension (for example
-         * the control to force stereo)
-         */
+    for (cur = w; cur; cur = cur->next) {
+        for (j = 0; j < n; j++) {
+            if ((d[j].display == cur->a.display) ||
+                nv_strcasecmp(d[j].display, cur->a.display)) {
+                break;
+            }
+        }
+        d[j].w[d[j].num++] = *cur;
     }
-    
-    /* free all the CtrlHandles we allocated */
 
-    for (i = 0; i < n; i++) {
-        nv_free_ctrl_handles(h[i]);
+    if (n == 0) return NV_TRUE;
+
+    jobs = calloc(n, sizeof(NvFanoutJob));
+    if (!jobs) {
+        free(d);
+        return NV_FALSE;
     }
-    
-    if (h) free(h);
 
+    for (j = 0; j < n; j++) {
+        jobs[j].display = d[j].display;
+        jobs[j].func = process_config_file_display;
+        jobs[j].data = &d[j];
+    }
 
-    return NV_TRUE;
+    ret = nv_fanout_run(jobs, n, fanout);
+
+    /*
+     * free the per-display lists, except those still in use by a job
+     * that timed out
+     */
+
+    if (ret) {
+        for (j = 0; j < n; j++) {
+            free(d[j].w);
+        }
+        free(d);
+    }
+
+    free(jobs);
+
+    return ret;
     
 } /* process_config_file_attributes() */
 
@@ -656,17 +1760,19 @@ static int process_config_file_attributes(const char *file,
 /*
  * save_gui_parsed_attributes() - scan through the parsed attribute
  * wrappers, and save any relevant attributes to the attribute list to
- * be passed to the gui.
+ * be passed to the gui.  nv_parsed_attribute_add() walks the list to
+ * its end, so it is given the end of the list each time.
  */
 
 static void save_gui_parsed_attributes(ParsedAttributeWrapper *w,
                                        ParsedAttribute *p)
 {
-    int i;
+    while (p->next) p = p->next;
 
-    for (i = 0; w[i].line != -1; i++) {
-        if (w[i].a.flags & NV_PARSER_TYPE_GUI_ATTRIBUTE) {
-            nv_parsed_attribute_add(p, &w[i].a);            
+    for (; w; w = w->next) {
+        if (w->a.flags & NV_PARSER_TYPE_GUI_ATTRIBUTE) {
+            nv_parsed_attribute_add(p, &w->a);
+            p = p->next;
         }
     }
 } /* save_gui_parsed_attributes() */
@@ -720,27 +1826,25 @@ ConfigPropertiesTableEntry configPropertyTable[] = {
  * parse_config_property() - special case the config properties; if
  * the given line sets a config property, update conf as appropriate
  * and return NV_TRUE.  If the given line does not describe a config
- * property, return NV_FALSE.
+ * property, return NV_FALSE, leaving the line unchanged.
+ *
+ * The line must already have had its white space removed.
  */
 
-static int parse_config_property(const char *file, const char *line, ConfigProperties *conf)
+static int parse_config_property(const char *file, char *line, ConfigProperties *conf)
 {
-    char *no_spaces, *s;
+    char *no_spaces = line, *s, *equals;
     char *locale;
     ConfigPropertiesTableEntry *t;
-    char *timer, *token;
+    char *timer = NULL, *token;
     TimerConfigProperty *c = NULL;
     int interval;
     int ret = NV_FALSE;
     unsigned int flag;
     
-    no_spaces = remove_spaces(line);
-
-    if (!no_spaces) goto done;
-
-    s = strchr(no_spaces, '=');
+    s = equals = strchr(no_spaces, '=');
 
-    if (!s) goto done;
+    if (!s) return NV_FALSE;
 
     *s = '\0';
     
@@ -752,7 +1856,9 @@ static int parse_config_property(const char *file, const char *line, ConfigPrope
                            file, locale);
         }
     } else if (nv_strcasecmp(no_spaces, "Timer")) {
-        timer = ++s;
+        timer = strdup(s + 1);
+        if (!timer)
+            goto done;
 
         token = strtok(timer, ",");
         if (!token)
@@ -828,7 +1934,10 @@ static int parse_config_property(const char *file, const char *line, ConfigPrope
         free(c);
     }
 
-    if (no_spaces) free(no_spaces);
+    free(timer);
+
+    if (ret != NV_TRUE) *equals = '=';
+
     return ret;
     
 } /* parse_config_property() */
@@ -26,6 +26,7 @@
 #define __CONFIG_FILE_H__
 
 #include "query-assign.h"
+#include "fanout.h"
 
 
 /*
@@ -58,9 +59,12 @@ typedef struct {
 void init_config_properties(ConfigProperties *conf);
 
 int nv_read_config_file(const char *, const char *,
-                        ParsedAttribute *, ConfigProperties *);
+                        ParsedAttribute *, ConfigProperties *,
+                        const NvFanoutOptions *, int);
 
 int nv_write_config_file(const char *, CtrlHandles *,
                          ParsedAttribute *, ConfigProperties *);
 
+void nv_track_config_file_attributes(CtrlHandles *);
+
 #endif /* __CONFIG_FILE_H__ */
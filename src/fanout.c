@@ -0,0 +1,462 @@
+/*
+ * nvidia-settings: A tool for configuring the NVIDIA X driver on Unix
+ * and Linux systems.
+ *
+ * Copyright (C) 2004 NVIDIA Corporation.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of Version 2 of the GNU General Public
+ * License as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See Version 2
+ * of the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the:
+ *
+ *           Free Software Foundation, Inc.
+ *           59 Temple Place - Suite 330
+ *           Boston, MA 02111-1307, USA
+ *
+ */
+
+/*
+ * fanout.c - this source file contains the code that runs per-display
+ * jobs (command line queries and assignments, and config file
+ * attributes) in parallel worker threads; see fanout.h.
+ *
+ * Each worker gets its own pair of temporary files for its messages
+ * (see nv_msg_set_thread_streams()); they are copied to stdout and
+ * stderr in job order once every job has finished or timed out.  A job
+ * that times out is abandoned: its thread keeps running in the
+ * background, and frees its own state if it ever finishes.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+#include <sys/time.h>
+
+#include <X11/Xlib.h>
+
+#include "NvCtrlAttributes.h"
+
+#include "fanout.h"
+#include "msg.h"
+
+
+typedef struct {
+    pthread_mutex_t lock;
+    pthread_cond_t cond;
+    int refs;           /* main thread plus running workers */
+} FanoutRun;
+
+typedef struct {
+    NvFanoutFunc func;
+    void *data;
+    char *display;
+
+    FILE *out;
+    FILE *err;
+    struct timeval deadline;
+
+    int ret;
+    int lost_display;   /* an X connection of this worker went away */
+    int done;           /* protected by run->lock */
+    int abandoned;      /* protected by run->lock */
+    int collected;
+
+    FanoutRun *run;
+} FanoutWorker;
+
+
+static pthread_key_t worker_key;
+static pthread_once_t worker_key_once = PTHREAD_ONCE_INIT;
+
+static int (*prev_io_error_handler)(Display *) = NULL;
+
+
+static void create_worker_key(void)
+{
+    pthread_key_create(&worker_key, NULL);
+}
+
+
+
+/*
+ * io_error_handler() - when the connection of a Display is lost, Xlib
+ * calls the I/O error handler, and then the Display's I/O error exit
+ * handler, which by default exits the process.
+ *
+ * When one display of many goes away, only fail the worker that was
+ * talking to it: its Displays get an exit handler that simply returns
+ * (see nv_fanout_watch_display()), after which Xlib fails every
+ * further request on the lost Display, and the worker's job runs to
+ * the end, with errors.  libX11 before 1.7 has no exit handler, and
+ * always exits once the I/O error handler returns.
+ */
+
+static int io_error_handler(Display *dpy)
+{
+    FanoutWorker *w = pthread_getspecific(worker_key);
+
+    if (w) {
+        nv_error_msg("Lost the connection to display '%s'.", w->display);
+        w->lost_display = NV_TRUE;
+#ifdef HAVE_XSETIOERROREXITHANDLER
+        return 0;
+#endif
+    }
+
+    return prev_io_error_handler ? prev_io_error_handler(dpy) : 0;
+
+} /* io_error_handler() */
+
+
+
+#ifdef HAVE_XSETIOERROREXITHANDLER
+static void io_error_exit_handler(Display *dpy, void *data)
+{
+    /* return to Xlib, and let the worker carry on */
+}
+#endif
+
+
+
+/*
+ * nv_fanout_watch_display() - called for each Display that a job
+ * opens; if this is a worker thread, losing the Display only fails the
+ * job, rather than exiting the process.
+ */
+
+void nv_fanout_watch_display(Display *dpy)
+{
+#ifdef HAVE_XSETIOERROREXITHANDLER
+    pthread_once(&worker_key_once, create_worker_key);
+
+    if (dpy && pthread_getspecific(worker_key)) {
+        XSetIOErrorExitHandler(dpy, io_error_exit_handler, NULL);
+    }
+#endif
+
+} /* nv_fanout_watch_display() */
+
+
+
+static void free_run(FanoutRun *run)
+{
+    pthread_mutex_destroy(&run->lock);
+    pthread_cond_destroy(&run->cond);
+    free(run);
+}
+
+
+
+/*
+ * release_run() - drop one reference to the run; called with
+ * run->lock held, which is released.
+ */
+
+static void release_run(FanoutRun *run)
+{
+    int last = (--run->refs == 0);
+
+    pthread_mutex_unlock(&run->lock);
+
+    if (last) free_run(run);
+}
+
+
+
+static void free_worker(FanoutWorker *w)
+{
+    if (w->out) fclose(w->out);
+    if (w->err) fclose(w->err);
+    free(w->display);
+    free(w);
+}
+
+
+
+/*
+ * finish_worker() - mark the worker as done, and wake up the main
+ * thread.
+ */
+
+static void finish_worker(FanoutWorker *w)
+{
+    FanoutRun *run = w->run;
+    int abandoned;
+
+    nv_msg_set_thread_streams(NULL, NULL);
+
+    pthread_mutex_lock(&run->lock);
+
+    w->done = NV_TRUE;
+    abandoned = w->abandoned;
+    pthread_cond_broadcast(&run->cond);
+
+    release_run(run);
+
+    if (abandoned) free_worker(w);
+
+} /* finish_worker() */
+
+
+
+static void *worker_thread(void *arg)
+{
+    FanoutWorker *w = arg;
+
+    pthread_setspecific(worker_key, w);
+    nv_msg_set_thread_streams(w->out, w->err);
+
+    w->ret = w->func(w->data);
+
+    if (w->lost_display) w->ret = NV_FALSE;
+
+    finish_worker(w);
+
+    return NULL;
+
+} /* worker_thread() */
+
+
+
+/*
+ * start_worker() - create a worker for the job, and start its thread;
+ * called with run->lock held.  Returns NULL if no worker could be
+ * started.
+ */
+
+static FanoutWorker *start_worker(FanoutRun *run, const NvFanoutJob *job,
+                                  int timeout)
+{
+    FanoutWorker *w;
+    pthread_attr_t attr;
+    pthread_t thread;
+    int ret;
+
+    w = calloc(1, sizeof(FanoutWorker));
+    if (!w) return NULL;
+
+    w->func = job->func;
+    w->data = job->data;
+    w->display = strdup(job->display ? job->display : "");
+    w->out = tmpfile();
+    w->err = tmpfile();
+    w->ret = NV_FALSE;
+    w->run = run;
+
+    gettimeofday(&w->deadline, NULL);
+    w->deadline.tv_sec += timeout;
+
+    pthread_attr_init(&attr);
+    pthread_attr_setdetachstate(&attr, PTHREAD_CREATE_DETACHED);
+
+    run->refs++;
+    ret = pthread_create(&thread, &attr, worker_thread, w);
+
+    pthread_attr_destroy(&attr);
+
+    if (ret != 0) {
+        run->refs--;
+        free_worker(w);
+        return NULL;
+    }
+
+    return w;
+
+} /* start_worker() */
+
+
+
+static void copy_stream(FILE *in, FILE *out)
+{
+    char buf[4096];
+    size_t n;
+
+    if (!in) return;
+
+    fflush(in);
+    rewind(in);
+
+    while ((n = fread(buf, 1, sizeof(buf), in)) > 0) {
+        fwrite(buf, 1, n, out);
+    }
+
+} /* copy_stream() */
+
+
+
+/*
+ * nv_fanout_run() - run the jobs, at most options->max_jobs at a
+ * time, waiting at most options->timeout seconds for each.  Sets
+ * ret and timed_out in each job, and prints the messages of each job
+ * in order.  Returns NV_FALSE if a job timed out or could not be
+ * started.
+ *
+ * Without a job limit or a timeout, the jobs are simply run one after
+ * another in the calling thread.
+ */
+
+int nv_fanout_run(NvFanoutJob *jobs, int num_jobs,
+                  const NvFanoutOptions *options)
+{
+    FanoutRun *run;
+    FanoutWorker **workers, *w;
+    struct timeval now, earliest;
+    struct timespec ts;
+    int max_jobs, timeout, started, active, collected, have_deadline;
+    int i, ret = NV_TRUE;
+
+    timerclear(&earliest);
+
+    max_jobs = options ? options->max_jobs : 1;
+    timeout = options ? options->timeout : 0;
+
+    if (max_jobs < 1) max_jobs = 1;
+    if (timeout < 0) timeout = 0;
+
+    if ((max_jobs == 1 && timeout == 0) || num_jobs <= 0) {
+        for (i = 0; i < num_jobs; i++) {
+            jobs[i].ret = jobs[i].func(jobs[i].data);
+            jobs[i].timed_out = NV_FALSE;
+        }
+        return NV_TRUE;
+    }
+
+    workers = calloc(num_jobs, sizeof(FanoutWorker *));
+    run = calloc(1, sizeof(FanoutRun));
+
+    if (!workers || !run) {
+        free(workers);
+        free(run);
+        nv_error_msg("Unable to allocate memory for %d display jobs.",
+                     num_jobs);
+        return NV_FALSE;
+    }
+
+    pthread_mutex_init(&run->lock, NULL);
+    pthread_cond_init(&run->cond, NULL);
+    run->refs = 1;
+
+    pthread_once(&worker_key_once, create_worker_key);
+    prev_io_error_handler = XSetIOErrorHandler(io_error_handler);
+
+    started = active = collected = 0;
+
+    pthread_mutex_lock(&run->lock);
+
+    while (collected < num_jobs) {
+
+        /* start as many jobs as we are allowed to */
+
+        while (active < max_jobs && started < num_jobs) {
+            jobs[started].ret = NV_FALSE;
+            jobs[started].timed_out = NV_FALSE;
+
+            w = start_worker(run, &jobs[started], timeout);
+            if (w) {
+                workers[started] = w;
+                active++;
+            } else {
+                nv_error_msg("Unable to start a thread for display '%s'.",
+                             jobs[started].display);
+                collected++;
+                ret = NV_FALSE;
+            }
+            started++;
+        }
+
+        /*
+         * collect the jobs that are done, abandon the jobs that ran
+         * out of time, and find the next deadline
+         */
+
+        gettimeofday(&now, NULL);
+        have_deadline = NV_FALSE;
+
+        for (i = 0; i < started; i++) {
+            w = workers[i];
+            if (!w || w->collected) continue;
+
+            if (w->done) {
+                w->collected = NV_TRUE;
+                active--;
+                collected++;
+                continue;
+            }
+
+            if (timeout == 0) continue;
+
+            if (!timercmp(&now, &w->deadline, <)) {
+                w->abandoned = NV_TRUE;
+                workers[i] = NULL;
+                jobs[i].timed_out = NV_TRUE;
+                active--;
+                collected++;
+                ret = NV_FALSE;
+                continue;
+            }
+
+            if (!have_deadline || timercmp(&w->deadline, &earliest, <)) {
+                earliest = w->deadline;
+                have_deadline = NV_TRUE;
+            }
+        }
+
+        if (collected == num_jobs) break;
+        if (active < max_jobs && started < num_jobs) continue;
+
+        if (have_deadline) {
+            ts.tv_sec = earliest.tv_sec;
+            ts.tv_nsec = earliest.tv_usec * 1000;
+            pthread_cond_timedwait(&run->cond, &run->lock, &ts);
+        } else {
+            pthread_cond_wait(&run->cond, &run->lock);
+        }
+    }
+
+    release_run(run);
+
+    /*
+     * abandoned workers may still hit an I/O error; keep our handler
+     * installed for them
+     */
+
+    if (ret) {
+        XSetIOErrorHandler(prev_io_error_handler);
+    }
+
+    /* print the output of each job, in order */
+
+    for (i = 0; i < num_jobs; i++) {
+        w = workers[i];
+
+        if (jobs[i].timed_out) {
+            nv_error_msg("Timed out after %d second%s waiting for "
+                         "display '%s'.", timeout, (timeout == 1) ? "" : "s",
+                         jobs[i].display);
+            continue;
+        }
+
+        if (!w) continue;
+
+        copy_stream(w->out, stdout);
+        fflush(stdout);
+        copy_stream(w->err, stderr);
+
+        jobs[i].ret = w->ret;
+
+        free_worker(w);
+    }
+
+    free(workers);
+
+    return ret;
+
+} /* nv_fanout_run() */
@@ -0,0 +1,64 @@
+/*
+ * nvidia-settings: A tool for configuring the NVIDIA X driver on Unix
+ * and Linux systems.
+ *
+ * Copyright (C) 2004 NVIDIA Corporation.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of Version 2 of the GNU General Public
+ * License as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See Version 2
+ * of the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the:
+ *
+ *           Free Software Foundation, Inc.
+ *           59 Temple Place - Suite 330
+ *           Boston, MA 02111-1307, USA
+ *
+ */
+
+#ifndef __FANOUT_H__
+#define __FANOUT_H__
+
+#include <X11/Xlib.h>
+
+/*
+ * Work on several X displays at once: each job is run in its own
+ * worker thread, which opens its own Display connection.  The
+ * messages printed by each job are collected, and printed in job
+ * order once all jobs are done, so that the output does not depend
+ * on which display answered first.
+ */
+
+typedef struct {
+    int max_jobs;       /* number of jobs to run at once; <= 1 is serial */
+    int timeout;        /* seconds to wait for each job; 0 waits forever */
+} NvFanoutOptions;
+
+typedef int (*NvFanoutFunc)(void *data);
+
+typedef struct {
+    const char *display;    /* display the job works on, for messages */
+    NvFanoutFunc func;      /* called with 'data' in the worker thread */
+    void *data;
+
+    int ret;                /* value returned by func */
+    int timed_out;          /* NV_TRUE if func did not return in time */
+} NvFanoutJob;
+
+/*
+ * The data of a job that timed out is still in use by its thread, and
+ * must not be freed by the caller.
+ */
+
+int nv_fanout_run(NvFanoutJob *jobs, int num_jobs,
+                  const NvFanoutOptions *options);
+
+void nv_fanout_watch_display(Display *dpy);
+
+#endif /* __FANOUT_H__ */
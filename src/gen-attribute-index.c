@@ -0,0 +1,268 @@
+/*
+ * nvidia-settings: A tool for configuring the NVIDIA X driver on Unix
+ * and Linux systems.
+ *
+ * Copyright (C) 2004 NVIDIA Corporation.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of Version 2 of the GNU General Public
+ * License as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See Version 2
+ * of the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the:
+ *
+ *           Free Software Foundation, Inc.
+ *           59 Temple Place - Suite 330
+ *           Boston, MA 02111-1307, USA
+ *
+ */
+
+/*
+ * gen-attribute-index.c - build tool that writes, to stdout, the
+ * attribute-index.h header used by parse.c to look up attributeTable[]
+ * entries without scanning the table:
+ *
+ * - a perfect hash of the attribute names: the name is hashed (see
+ *   nv_attribute_name_hash()) with seed 0 to pick a bucket, and again
+ *   with that bucket's displacement to pick a slot, which holds the
+ *   index of the only entry that can have that name.
+ *
+ * - a direct map from attribute constant to the first attributeTable[]
+ *   entry with that constant, and a chain to the following entries
+ *   with the same constant, in table order.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+
+#include "NVCtrl.h"
+
+#include "parse.h"
+
+#define MAX_DISPLACEMENT (1 << 20)
+#define MAX_ATTRIBUTE_ID 0xffff
+
+
+typedef struct {
+    int num_keys;
+    int *keys;
+    unsigned int displacement;
+} Bucket;
+
+static int num_entries;
+static unsigned int num_buckets, num_slots;
+static Bucket *buckets;
+static int *slots;
+
+
+
+static int compare_buckets(const void *a, const void *b)
+{
+    const Bucket *ba = *(const Bucket * const *) a;
+    const Bucket *bb = *(const Bucket * const *) b;
+
+    return bb->num_keys - ba->num_keys;
+}
+
+
+
+static void *alloc_or_die(size_t n)
+{
+    void *p = calloc(1, n ? n : 1);
+
+    if (!p) {
+        fprintf(stderr, "gen-attribute-index: out of memory\n");
+        exit(1);
+    }
+    return p;
+}
+
+
+
+/*
+ * place_bucket() - find a displacement that puts every key of the
+ * bucket in a distinct, free slot, and claim those slots.
+ */
+
+static int place_bucket(Bucket *b, unsigned int *tmp)
+{
+    unsigned int d, s;
+    int i, j;
+
+    for (d = 1; d < MAX_DISPLACEMENT; d++) {
+        for (i = 0; i < b->num_keys; i++) {
+            s = nv_attribute_name_hash(attributeTable[b->keys[i]].name, d) &
+                (num_slots - 1);
+            if (slots[s] >= 0) break;
+            for (j = 0; j < i; j++) {
+                if (tmp[j] == s) break;
+            }
+            if (j < i) break;
+            tmp[i] = s;
+        }
+
+        if (i == b->num_keys) {
+            for (i = 0; i < b->num_keys; i++) {
+                slots[tmp[i]] = b->keys[i];
+            }
+            b->displacement = d;
+            return 1;
+        }
+    }
+
+    return 0;
+
+} /* place_bucket() */
+
+
+
+/*
+ * build_name_hash() - bucket the attribute names, and place the
+ * buckets largest first.  Later entries with the same name as an
+ * earlier one are left out, since a lookup by name has always
+ * returned the first one.
+ */
+
+static void build_name_hash(void)
+{
+    Bucket **order;
+    unsigned int *tmp;
+    unsigned int b;
+    int i, j, num_names = 0;
+
+    for (num_slots = 1; num_slots * 4 < (unsigned int) num_entries * 5;
+         num_slots <<= 1);
+    num_buckets = (num_slots >= 4) ? num_slots / 4 : 1;
+
+    buckets = alloc_or_die(num_buckets * sizeof(Bucket));
+    slots = alloc_or_die(num_slots * sizeof(int));
+    order = alloc_or_die(num_buckets * sizeof(Bucket *));
+    tmp = alloc_or_die(num_entries * sizeof(unsigned int));
+
+    for (i = 0; i < num_entries; i++) {
+        for (j = 0; j < i; j++) {
+            if (!strcasecmp(attributeTable[i].name,
+                            attributeTable[j].name)) break;
+        }
+        if (j < i) continue;
+
+        b = nv_attribute_name_hash(attributeTable[i].name, 0) &
+            (num_buckets - 1);
+        if (!buckets[b].keys) {
+            buckets[b].keys = alloc_or_die(num_entries * sizeof(int));
+        }
+        buckets[b].keys[buckets[b].num_keys++] = i;
+        num_names++;
+    }
+
+    for (b = 0; b < num_slots; b++) slots[b] = -1;
+    for (b = 0; b < num_buckets; b++) order[b] = &buckets[b];
+
+    qsort(order, num_buckets, sizeof(Bucket *), compare_buckets);
+
+    for (b = 0; b < num_buckets && order[b]->num_keys; b++) {
+        if (!place_bucket(order[b], tmp)) {
+            fprintf(stderr, "gen-attribute-index: unable to build a perfect "
+                    "hash of the %d attribute names\n", num_names);
+            exit(1);
+        }
+    }
+
+    free(order);
+    free(tmp);
+
+} /* build_name_hash() */
+
+
+
+static void print_array(const char *type, const char *name,
+                        const int *values, unsigned int n)
+{
+    unsigned int i;
+
+    printf("static const %s %s[%u] = {", type, name, n);
+    for (i = 0; i < n; i++) {
+        printf("%s%d,", (i % 12) ? " " : "\n   ", values[i]);
+    }
+    printf("\n};\n\n");
+}
+
+
+
+int main(void)
+{
+    int *first, *next, *last, *displacements;
+    int i, max_attr = 0;
+    unsigned int b;
+
+    for (num_entries = 0; attributeTable[num_entries].name; num_entries++) {
+        if (attributeTable[num_entries].attr < 0 ||
+            attributeTable[num_entries].attr > MAX_ATTRIBUTE_ID) {
+            fprintf(stderr, "gen-attribute-index: attribute '%s' has the "
+                    "out of range value %d\n",
+                    attributeTable[num_entries].name,
+                    attributeTable[num_entries].attr);
+            return 1;
+        }
+        if (attributeTable[num_entries].attr > max_attr) {
+            max_attr = attributeTable[num_entries].attr;
+        }
+    }
+
+    build_name_hash();
+
+    /* chain the entries of each attribute constant, in table order */
+
+    first = alloc_or_die((max_attr + 1) * sizeof(int));
+    last = alloc_or_die((max_attr + 1) * sizeof(int));
+    next = alloc_or_die(num_entries * sizeof(int));
+
+    for (i = 0; i <= max_attr; i++) first[i] = last[i] = -1;
+
+    for (i = 0; i < num_entries; i++) {
+        int attr = attributeTable[i].attr;
+
+        next[i] = -1;
+        if (last[attr] < 0) {
+            first[attr] = i;
+        } else {
+            next[last[attr]] = i;
+        }
+        last[attr] = i;
+    }
+
+    displacements = alloc_or_die(num_buckets * sizeof(int));
+    for (b = 0; b < num_buckets; b++) {
+        displacements[b] = buckets[b].displacement;
+    }
+
+    printf("/*\n"
+           " * attribute-index.h - generated by gen-attribute-index from\n"
+           " * attributeTable[]; do not edit.\n"
+           " */\n\n");
+    printf("#ifndef __ATTRIBUTE_INDEX_H__\n");
+    printf("#define __ATTRIBUTE_INDEX_H__\n\n");
+
+    printf("#define NV_ATTRIBUTE_TABLE_ENTRIES %d\n", num_entries);
+    printf("#define NV_ATTRIBUTE_NAME_BUCKETS %u\n", num_buckets);
+    printf("#define NV_ATTRIBUTE_NAME_SLOTS %u\n", num_slots);
+    printf("#define NV_ATTRIBUTE_ID_MAX %d\n\n", max_attr);
+
+    print_array("int", "attributeNameDisplacements", displacements,
+                num_buckets);
+    print_array("short", "attributeNameSlots", slots, num_slots);
+    print_array("short", "attributeIdFirst", first, max_attr + 1);
+    print_array("short", "attributeIdNext", next, num_entries);
+
+    printf("#endif /* __ATTRIBUTE_INDEX_H__ */\n");
+
+    return 0;
+
+} /* main() */
@@ -173,13 +173,16 @@ caveat_abbrev(int caveat)
 }
 
 
+#define FBCA(col) (table->columns[NV_CTRL_GLX_FBCONFIG_##col][i])
+
 static void
-print_fbconfig_attribs(GLXFBConfigAttr *fbca)
+print_fbconfig_attribs(const NvCtrlGlxFBConfigTable *table,
+                       const int *indices, int num_indices)
 {
-    int i; /* Iterator */
+    int n, i; /* Iterators */
 
 
-    if ( fbca == NULL ) {
+    if ( table == NULL || indices == NULL ) {
         return;
     }
 
@@ -190,77 +193,78 @@ print_fbconfig_attribs(GLXFBConfigAttr *fbca)
     printf("---------------------------------------------------"
            "--------------------------------------------------------------\n");
 
-    i = 0;
-    while ( fbca[i].fbconfig_id != 0 ) {
-        
-        printf("0x%03x ", fbca[i].fbconfig_id);
-        if ( fbca[i].visual_id ) {
-            printf("0x%03x ", fbca[i].visual_id);
+    for ( n = 0; n < num_indices; n++ ) {
+        i = indices[n];
+
+        printf("0x%03x ", FBCA(FBCONFIG_ID));
+        if ( FBCA(VISUAL_ID) ) {
+            printf("0x%03x ", FBCA(VISUAL_ID));
         } else {
             printf("   .  ");
         }
         printf("%2.2s %3d %2d %3.3s %1c %1c ",
-               x_visual_type_abbrev(fbca[i].x_visual_type),
-               fbca[i].buffer_size,
-               fbca[i].level,
-               render_type_abbrev(fbca[i].render_type),
-               fbca[i].doublebuffer ? 'y' : '.',
-               fbca[i].stereo ? 'y' : '.'
+               x_visual_type_abbrev(FBCA(X_VISUAL_TYPE)),
+               FBCA(BUFFER_SIZE),
+               FBCA(LEVEL),
+               render_type_abbrev(FBCA(RENDER_TYPE)),
+               FBCA(DOUBLEBUFFER) ? 'y' : '.',
+               FBCA(STEREO) ? 'y' : '.'
                );
         printf("%2d %2d %2d %2d %2d %2d %2d ",
-               fbca[i].red_size,
-               fbca[i].green_size,
-               fbca[i].blue_size,
-               fbca[i].alpha_size,
-               fbca[i].aux_buffers,
-               fbca[i].depth_size,
-               fbca[i].stencil_size
+               FBCA(RED_SIZE),
+               FBCA(GREEN_SIZE),
+               FBCA(BLUE_SIZE),
+               FBCA(ALPHA_SIZE),
+               FBCA(AUX_BUFFERS),
+               FBCA(DEPTH_SIZE),
+               FBCA(STENCIL_SIZE)
                );
         printf("%2d %2d %2d %2d ",
-               fbca[i].accum_red_size,
-               fbca[i].accum_green_size,
-               fbca[i].accum_blue_size,
-               fbca[i].accum_alpha_size
+               FBCA(ACCUM_RED_SIZE),
+               FBCA(ACCUM_GREEN_SIZE),
+               FBCA(ACCUM_BLUE_SIZE),
+               FBCA(ACCUM_ALPHA_SIZE)
                );
-        if ( fbca[i].multi_sample_valid == 1 ) {
+        if ( FBCA(MULTI_SAMPLE_VALID) == 1 ) {
             printf("%3d ",
-                   fbca[i].multi_samples
+                   FBCA(MULTI_SAMPLES)
                    );
 
-            if ( fbca[i].multi_sample_coverage_valid == 1 ) {
+            if ( FBCA(MULTI_SAMPLE_COVERAGE_VALID) == 1 ) {
                 printf("%3d ",
-                       fbca[i].multi_samples_color
+                       FBCA(MULTI_SAMPLES_COLOR)
                        );
             } else {
                 printf("%3d ",
-                       fbca[i].multi_samples
+                       FBCA(MULTI_SAMPLES)
                        );
             }
             printf("%1d ",
-                   fbca[i].multi_sample_buffers
+                   FBCA(MULTI_SAMPLE_BUFFERS)
                    );
 
         } else {
             printf("  .   . . ");
         }
         printf("%3.3s %4x %4x %7x %3.3s %2d %2d %2d %2d %2d\n",
-               caveat_abbrev(fbca[i].config_caveat),
-               fbca[i].pbuffer_width,
-               fbca[i].pbuffer_height,
-               fbca[i].pbuffer_max,
-               transparent_type_abbrev(fbca[i].transparent_type),
-               fbca[i].transparent_red_value,
-               fbca[i].transparent_green_value,
-               fbca[i].transparent_blue_value,
-               fbca[i].transparent_alpha_value,
-               fbca[i].transparent_index_value
+               caveat_abbrev(FBCA(CONFIG_CAVEAT)),
+               FBCA(PBUFFER_WIDTH),
+               FBCA(PBUFFER_HEIGHT),
+               FBCA(PBUFFER_MAX),
+               transparent_type_abbrev(FBCA(TRANSPARENT_TYPE)),
+               FBCA(TRANSPARENT_RED_VALUE),
+               FBCA(TRANSPARENT_GREEN_VALUE),
+               FBCA(TRANSPARENT_BLUE_VALUE),
+               FBCA(TRANSPARENT_ALPHA_VALUE),
+               FBCA(TRANSPARENT_INDEX_VALUE)
                );
-        
-        i++;
+
     } /* Done printing FBConfig attributes for FBConfig */
 
 } /* print_fbconfig_attribs() */
 
+#undef FBCA
+
 #endif /* GLX_VERSION_1_3 */
 
 
@@ -300,7 +304,18 @@ void print_glxinfo(const char *display_name)
     char            *opengl_version    = NULL;
     char            *opengl_extensions = NULL;
 
-    GLXFBConfigAttr *fbconfig_attribs  = NULL;
+    const NvCtrlGlxFBConfigTable *fbconfig_table = NULL;
+    int             *fbconfig_indices  = NULL;
+    int              num_fbconfigs     = 0;
+
+    /*
+     * list the fbconfigs that have an id, as the zero-terminated
+     * fbconfig list used to
+     */
+    const NvCtrlGlxFBConfigFilter fbconfig_filter = {
+        NV_CTRL_GLX_FBCONFIG_FBCONFIG_ID,
+        NV_CTRL_GLX_FBCONFIG_FILTER_AT_LEAST, 1
+    };
 
     char            *formated_ext_str  = NULL;
 
@@ -312,7 +327,7 @@ void print_glxinfo(const char *display_name)
     /* Print information for each screen */
     for (screen = 0; screen < h->targets[X_SCREEN_TARGET].n; screen++) {
 
-        t = &h->targets[X_SCREEN_TARGET].t[screen];
+        t = nv_get_ctrl_handle_target(h, X_SCREEN_TARGET, screen);
 
         /* No screen, move on */
         if ( !t->h ) continue;
@@ -413,9 +428,12 @@ void print_glxinfo(const char *display_name)
         }
 
         /* Get FBConfig information */
-        status = NvCtrlGetVoidAttribute(t->h,
-                                        NV_CTRL_ATTR_GLX_FBCONFIG_ATTRIBS,
-                                        (void *)(&fbconfig_attribs));
+        fbconfig_table = NULL;
+        status = NvCtrlGlxFilterFBConfigs(t->h, &fbconfig_filter, 1,
+                                          &fbconfig_indices, &num_fbconfigs);
+        if ( status == NvCtrlSuccess ) {
+            status = NvCtrlGlxGetFBConfigTable(t->h, &fbconfig_table);
+        }
         if ( status != NvCtrlSuccess &&
              status != NvCtrlNoAttribute ) { goto finish; }
 
@@ -447,9 +465,10 @@ void print_glxinfo(const char *display_name)
         nv_msg(TAB, "OpenGL extensions:");
         nv_msg("    ", NULL_TO_EMPTY(opengl_extensions));
 #ifdef GLX_VERSION_1_3        
-        if ( fbconfig_attribs != NULL ) {
+        if ( fbconfig_table != NULL ) {
             nv_msg(" ", "\n");
-            print_fbconfig_attribs(fbconfig_attribs);
+            print_fbconfig_attribs(fbconfig_table, fbconfig_indices,
+                                   num_fbconfigs);
         }
 #endif
         fflush(stdout);
@@ -467,7 +486,7 @@ void print_glxinfo(const char *display_name)
         SAFE_FREE(opengl_renderer);
         SAFE_FREE(opengl_version);
         SAFE_FREE(opengl_extensions);
-        SAFE_FREE(fbconfig_attribs);
+        SAFE_FREE(fbconfig_indices);
 
     } /* Done looking at all screens */
 
@@ -492,7 +511,7 @@ void print_glxinfo(const char *display_name)
     SAFE_FREE(opengl_renderer);
     SAFE_FREE(opengl_version);
     SAFE_FREE(opengl_extensions);
-    SAFE_FREE(fbconfig_attribs);
+    SAFE_FREE(fbconfig_indices);
     
     nv_free_ctrl_handles(h);
 
@@ -25,6 +25,7 @@
 #include <gtk/gtk.h>
 
 #include "NvCtrlAttributes.h"
+#include "msg.h"
 
 #include "rgb_xpm.h"
 #include "red_xpm.h"
@@ -86,6 +87,15 @@ get_attribute_channel_value (CtkColorCorrection *, gint, gint);
 static void
 flush_attribute_channel_values (CtkColorCorrection *, gint, gint);
 
+static void
+queue_attribute_channel_values (CtkColorCorrection *, gint, gint);
+
+static gboolean
+flush_pending_values (gpointer);
+
+static gboolean
+slider_button_released (GtkWidget *, GdkEventButton *, gpointer);
+
 static void
 ctk_color_correction_class_init(CtkColorCorrectionClass *);
 
@@ -117,6 +127,12 @@ static guint signals[LAST_SIGNAL] = { 0 };
 
 #define DEFAULT_CONFIRM_COLORCORRECTION_TIMEOUT 10
 
+/*
+ * Slider changes are applied at most once per this many milliseconds
+ * (about once per frame); the latest value wins.
+ */
+#define COLOR_CORRECTION_FLUSH_INTERVAL 16
+
 #define CREATE_COLOR_ADJUSTMENT(adj, attr, min, max)          \
 {                                                             \
     gdouble _step_incr, _page_incr, _def;                     \
@@ -422,6 +438,10 @@ GtkWidget* ctk_color_correction_new(NvCtrlAttributeHandle *handle,
     
     widget = CTK_SCALE(scale)->gtk_scale;
 
+    g_signal_connect(G_OBJECT(widget), "button_release_event",
+                     G_CALLBACK(slider_button_released),
+                     (gpointer) ctk_color_correction);
+
     ctk_config_set_tooltip(ctk_config, widget, "The Brightness slider alters "
                            "the amount of brightness for the selected color "
                            "channel(s).");
@@ -451,6 +471,10 @@ GtkWidget* ctk_color_correction_new(NvCtrlAttributeHandle *handle,
     
     widget = CTK_SCALE(scale)->gtk_scale;
 
+    g_signal_connect(G_OBJECT(widget), "button_release_event",
+                     G_CALLBACK(slider_button_released),
+                     (gpointer) ctk_color_correction);
+
     ctk_config_set_tooltip(ctk_config, widget, "The Contrast slider alters "
                            "the amount of contrast for the selected color "
                            "channel(s).");
@@ -478,6 +502,10 @@ GtkWidget* ctk_color_correction_new(NvCtrlAttributeHandle *handle,
     gtk_box_pack_start(GTK_BOX(rightvbox), scale, TRUE, TRUE, 0);
 
     widget = CTK_SCALE(scale)->gtk_scale;
+
+    g_signal_connect(G_OBJECT(widget), "button_release_event",
+                     G_CALLBACK(slider_button_released),
+                     (gpointer) ctk_color_correction);
  
     ctk_config_set_tooltip(ctk_config, widget, "The Gamma slider alters "
                            "the amount of gamma for the selected color "
@@ -806,7 +834,7 @@ static void adjustment_value_changed(
     set_color_state(ctk_color_correction, attribute_idx, channel,
                     value, FALSE);
     
-    flush_attribute_channel_values(ctk_color_correction, attribute, channel);
+    queue_attribute_channel_values(ctk_color_correction, attribute, channel);
     
     ctk_config_statusbar_message(ctk_color_correction->ctk_config,
                                  "Set %s%s to %f.",
@@ -855,6 +883,13 @@ static gfloat get_attribute_channel_value(CtkColorCorrection
     return ctk_color_correction->cur_slider_val[attribute_idx][channel_idx];
 }
 
+/** flush_attribute_channel_values() ************************
+ *
+ * Applies the current values of the given attributes and channels,
+ * along with any slider changes that are still pending.
+ *
+ **/
+
 static void flush_attribute_channel_values(
     CtkColorCorrection *ctk_color_correction,
     gint attribute,
@@ -862,17 +897,111 @@ static void flush_attribute_channel_values(
 )
 {
     NvCtrlAttributeHandle *handle = ctk_color_correction->handle;
+    guint mask = attribute | channel | ctk_color_correction->pending_mask;
+
+    ctk_color_correction->pending_mask = 0;
+    if (ctk_color_correction->flush_timer) {
+        g_source_remove(ctk_color_correction->flush_timer);
+        ctk_color_correction->flush_timer = 0;
+    }
     
     NvCtrlSetColorAttributes(handle,
                              ctk_color_correction->cur_slider_val[CONTRAST],
                              ctk_color_correction->cur_slider_val[BRIGHTNESS],
                              ctk_color_correction->cur_slider_val[GAMMA],
-                             attribute | channel);
+                             mask);
     
     g_signal_emit(ctk_color_correction, signals[CHANGED], 0);
 }
 
 
+
+/** queue_attribute_channel_values() ************************
+ *
+ * Schedules the current values of the given attributes and channels
+ * to be applied.  Slider motion can generate many more changes than
+ * can be usefully sent to the X server, so changes are accumulated and
+ * applied at most once every COLOR_CORRECTION_FLUSH_INTERVAL ms; since
+ * the values themselves are kept in cur_slider_val[][], only the latest
+ * one is applied.
+ *
+ **/
+
+static void queue_attribute_channel_values(
+    CtkColorCorrection *ctk_color_correction,
+    gint attribute,
+    gint channel
+)
+{
+    ctk_color_correction->num_requested_updates++;
+
+    if (ctk_color_correction->flush_timer) {
+        ctk_color_correction->num_coalesced_updates++;
+    } else {
+        ctk_color_correction->flush_timer =
+            g_timeout_add(COLOR_CORRECTION_FLUSH_INTERVAL,
+                          flush_pending_values,
+                          (gpointer) ctk_color_correction);
+    }
+
+    ctk_color_correction->pending_mask |= attribute | channel;
+}
+
+
+
+/** flush_pending_values() **********************************
+ *
+ * Timeout callback that applies the pending slider changes.
+ *
+ **/
+
+static gboolean flush_pending_values(gpointer data)
+{
+    CtkColorCorrection *ctk_color_correction = CTK_COLOR_CORRECTION(data);
+
+    /* the timer is removed by returning FALSE */
+    ctk_color_correction->flush_timer = 0;
+
+    if (ctk_color_correction->pending_mask) {
+        flush_attribute_channel_values(ctk_color_correction, 0, 0);
+    }
+
+    return FALSE;
+}
+
+
+
+/** slider_button_released() ********************************
+ *
+ * Applies the final value of a slider drag right away, and reports how
+ * many of the drag's updates were coalesced.
+ *
+ **/
+
+static gboolean slider_button_released(
+    GtkWidget *widget,
+    GdkEventButton *event,
+    gpointer user_data
+)
+{
+    CtkColorCorrection *ctk_color_correction = CTK_COLOR_CORRECTION(user_data);
+
+    if (ctk_color_correction->pending_mask) {
+        flush_attribute_channel_values(ctk_color_correction, 0, 0);
+    }
+
+    if (ctk_color_correction->num_requested_updates) {
+        nv_info_msg(NULL, "Color correction: %u slider updates, %u "
+                    "coalesced.", ctk_color_correction->num_requested_updates,
+                    ctk_color_correction->num_coalesced_updates);
+        ctk_color_correction->num_requested_updates = 0;
+        ctk_color_correction->num_coalesced_updates = 0;
+    }
+
+    return FALSE;
+}
+
+
 static void apply_parsed_attribute_list(
     CtkColorCorrection *ctk_color_correction,
     ParsedAttribute *p
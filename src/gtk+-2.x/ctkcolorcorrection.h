@@ -71,6 +71,10 @@ struct _CtkColorCorrection
     gfloat cur_slider_val[3][4];  // as [attribute][channel]
     gfloat prev_slider_val[3][4]; // as [attribute][channel]
     guint enabled_display_devices;
+    guint pending_mask;           // attributes|channels not yet applied
+    guint flush_timer;
+    guint num_requested_updates;  // slider changes since the last release
+    guint num_coalesced_updates;  // ... that were merged into another
 };
 
 struct _CtkColorCorrectionClass
@@ -511,11 +511,23 @@ static void ctk_event_register_source(CtkEvent *ctk_event)
      * (Resulting in randr_event_base being == -1), followed by an
      * X Screen target type handle registering itself to receive
      * XRandR events on the existing dpy/event source.
+     *
+     * The XRandR subsystem of each X Screen handle is initialized on
+     * first use, and that is when it selects XRandR events for its
+     * screen; so always query the event base of X Screen handles.
      */
-    if (event_source->randr_event_base == -1 &&
-        event_node->target_type == NV_CTRL_TARGET_TYPE_X_SCREEN) {
-        event_source->randr_event_base =
-            NvCtrlGetXrandrEventBase(ctk_event->handle);
+    if (event_node->target_type == NV_CTRL_TARGET_TYPE_X_SCREEN) {
+        int randr_event_base = NvCtrlGetXrandrEventBase(ctk_event->handle);
+
+        if (event_source->randr_event_base == -1) {
+            event_source->randr_event_base = randr_event_base;
+        }
+
+        /* screen changes now reach NvCtrlXrandrScreenChanged() */
+
+        if (randr_event_base != -1) {
+            NvCtrlXrandrTrackScreenChanges(ctk_event->handle);
+        }
     }
 
 } /* ctk_event_register_source() */
@@ -537,6 +549,14 @@ GtkObject *ctk_event_new(NvCtrlAttributeHandle *handle)
     /* Register to receive (dpy) events */
 
     ctk_event_register_source(ctk_event);
+
+    /*
+     * Now that attribute events for this handle's target will be seen
+     * (and passed on to the handle by ctk_event_dispatch()), its
+     * attribute values can be cached.
+     */
+
+    NvCtrlAttributeCacheEnable(handle, True);
     
     return GTK_OBJECT(ctk_event);
 
@@ -603,6 +623,28 @@ do {                                                  \
     }                                                 \
 } while (0)
 
+/*
+ * ctk_event_update_caches() - pass an NV-CONTROL attribute event on to
+ * the attribute caches of all handles registered for its target.
+ */
+
+static void ctk_event_update_caches(CtkEventSource *event_source,
+                                    int target_type, int target_id,
+                                    unsigned int display_mask, int attr,
+                                    int value, Bool available)
+{
+    CtkEventNode *e;
+
+    for (e = event_source->ctk_events; e; e = e->next) {
+        if (e->target_type == target_type && e->target_id == target_id) {
+            NvCtrlAttributeCacheAttributeChanged(e->ctk_event->handle,
+                                                 display_mask, attr, value,
+                                                 available);
+        }
+    }
+
+} /* ctk_event_update_caches() */
+
 static gboolean ctk_event_dispatch(GSource *source,
                                    GSourceFunc callback, gpointer user_data)
 {
@@ -628,6 +670,13 @@ static gboolean ctk_event_dispatch(GSource *source,
         XNVCtrlAttributeChangedEvent *nvctrlevent =
             (XNVCtrlAttributeChangedEvent *) &event;
 
+        ctk_event_update_caches(event_source,
+                                NV_CTRL_TARGET_TYPE_X_SCREEN,
+                                nvctrlevent->screen,
+                                nvctrlevent->display_mask,
+                                nvctrlevent->attribute,
+                                nvctrlevent->value, True);
+
         /* make sure the attribute is in our signal array */
 
         if ((nvctrlevent->attribute >= 0) &&
@@ -662,6 +711,13 @@ static gboolean ctk_event_dispatch(GSource *source,
         XNVCtrlAttributeChangedEventTarget *nvctrlevent =
             (XNVCtrlAttributeChangedEventTarget *) &event;
 
+        ctk_event_update_caches(event_source,
+                                nvctrlevent->target_type,
+                                nvctrlevent->target_id,
+                                nvctrlevent->display_mask,
+                                nvctrlevent->attribute,
+                                nvctrlevent->value, True);
+
         /* make sure the attribute is in our signal array */
 
         if ((nvctrlevent->attribute >= 0) &&
@@ -697,6 +753,14 @@ static gboolean ctk_event_dispatch(GSource *source,
         XNVCtrlAttributeChangedEventTargetAvailability *nvctrlevent =
             (XNVCtrlAttributeChangedEventTargetAvailability *) &event;
 
+        ctk_event_update_caches(event_source,
+                                nvctrlevent->target_type,
+                                nvctrlevent->target_id,
+                                nvctrlevent->display_mask,
+                                nvctrlevent->attribute,
+                                nvctrlevent->value,
+                                nvctrlevent->availability);
+
         /* make sure the attribute is in our signal array */
 
         if ((nvctrlevent->attribute >= 0) &&
@@ -797,6 +861,10 @@ static gboolean ctk_event_dispatch(GSource *source,
         /* Find the screen the window belongs to */
         screen = get_screen_of_root(xrandrevent->display, xrandrevent->root);
         if (screen >= 0) {
+            if (event_source->ctk_events) {
+                NvCtrlXrandrScreenChanged
+                    (event_source->ctk_events->ctk_event->handle);
+            }
             CTK_EVENT_BROADCAST(event_source,
                                 signal_RRScreenChangeNotify,
                                 &event,
@@ -228,6 +228,8 @@ typedef struct WidgetSizeRec {
     int width;
 } WidgetSize;
 
+#define FBCA(col) (fbconfig_table->columns[NV_CTRL_GLX_FBCONFIG_##col][i])
+
 GtkWidget* ctk_glx_new(NvCtrlAttributeHandle *handle,
                        CtkConfig *ctk_config, CtkEvent *ctk_event)
 {
@@ -248,11 +250,21 @@ GtkWidget* ctk_glx_new(NvCtrlAttributeHandle *handle,
     ReturnStatus ret;
 
     char * glx_info_str = NULL;               /* Test if GLX supported */
-    GLXFBConfigAttr *fbconfig_attribs = NULL; /* FBConfig data */
-    int i;                                    /* Iterator */
+    const NvCtrlGlxFBConfigTable *fbconfig_table = NULL; /* FBConfig data */
+    int *fbconfig_indices = NULL;             /* FBConfigs to list */
+    int n, i;                                 /* Iterators */
     int num_fbconfigs = 0;
     char *err_str = NULL;
 
+    /*
+     * list the fbconfigs that have an id, as the zero-terminated
+     * fbconfig list used to
+     */
+    const NvCtrlGlxFBConfigFilter fbconfig_filter = {
+        NV_CTRL_GLX_FBCONFIG_FBCONFIG_ID,
+        NV_CTRL_GLX_FBCONFIG_FILTER_AT_LEAST, 1
+    };
+
     gchar *fbconfig_titles[NUM_FBCONFIG_ATTRIBS] = {
         "fid",  "vid",  "vt", "bfs",  "lvl",
         "bf",   "db",   "st",
@@ -330,19 +342,16 @@ GtkWidget* ctk_glx_new(NvCtrlAttributeHandle *handle,
 #ifdef GLX_VERSION_1_3
 
     /* Grab the FBConfigs */
-    ret = NvCtrlGetVoidAttribute(handle, NV_CTRL_ATTR_GLX_FBCONFIG_ATTRIBS,
-                                 (void *)(&fbconfig_attribs));
+    ret = NvCtrlGlxFilterFBConfigs(handle, &fbconfig_filter, 1,
+                                   &fbconfig_indices, &num_fbconfigs);
+    if ( ret == NvCtrlSuccess ) {
+        ret = NvCtrlGlxGetFBConfigTable(handle, &fbconfig_table);
+    }
     if ( ret != NvCtrlSuccess ) {
         err_str = "Failed to query list of GLX frame buffer configurations.";
         goto fail;
     }
 
-    /* Count the number of fbconfigs */
-    if ( fbconfig_attribs ) {
-        for (num_fbconfigs = 0;
-             fbconfig_attribs[num_fbconfigs].fbconfig_id != 0;
-             num_fbconfigs++);
-    }
     if ( ! num_fbconfigs ) {
         err_str = "No frame buffer configurations found.";
         
@@ -457,97 +466,98 @@ GtkWidget* ctk_glx_new(NvCtrlAttributeHandle *handle,
     
     /* Fill the data table */
 
-    if ( fbconfig_attribs ) {
+    if ( fbconfig_table ) {
 
         /* Populate FBConfig table */
-        i = 0;
-        while ( fbconfig_attribs[i].fbconfig_id != 0 ) {
+        for ( n = 0; n < num_fbconfigs; n++ ) {
             char str[NUM_FBCONFIG_ATTRIBS + 1][16];
             int  cell = 0; /* Used for putting information into cells */
-            
-            if ( fbconfig_attribs[i].fbconfig_id )  {
+
+            i = fbconfig_indices[n];
+
+            if ( FBCA(FBCONFIG_ID) )  {
                 snprintf((char *) (&(str[cell++])), 16, "0x%02X",
-                         fbconfig_attribs[i].fbconfig_id);
+                         FBCA(FBCONFIG_ID));
             } else {
                 sprintf((char *) (&(str[cell++])),".");
             }
             
-            if ( fbconfig_attribs[i].visual_id )  {
+            if ( FBCA(VISUAL_ID) )  {
                 snprintf((char *) (&(str[cell++])), 16, "0x%02X",
-                         fbconfig_attribs[i].visual_id);
+                         FBCA(VISUAL_ID));
             } else {
                 sprintf((char *) (&(str[cell++])),".");
             }
             snprintf((char *) (&(str[cell++])), 16, "%s",
-                     x_visual_type_abbrev(fbconfig_attribs[i].x_visual_type));
+                     x_visual_type_abbrev(FBCA(X_VISUAL_TYPE)));
             snprintf((char *) (&(str[cell++])), 16, "%3d",
-                     fbconfig_attribs[i].buffer_size);
+                     FBCA(BUFFER_SIZE));
             snprintf((char *) (&(str[cell++])), 16, "%2d",
-                     fbconfig_attribs[i].level);
+                     FBCA(LEVEL));
             snprintf((char *) (&(str[cell++])), 16, "%s",
-                     render_type_abbrev(fbconfig_attribs[i].render_type) );
+                     render_type_abbrev(FBCA(RENDER_TYPE)) );
             snprintf((char *) (&(str[cell++])), 16, "%c",
-                     fbconfig_attribs[i].doublebuffer ? 'y' : '.');
+                     FBCA(DOUBLEBUFFER) ? 'y' : '.');
             snprintf((char *) (&(str[cell++])), 16, "%c",
-                     fbconfig_attribs[i].stereo ? 'y' : '.');
+                     FBCA(STEREO) ? 'y' : '.');
             snprintf((char *) (&(str[cell++])), 16, "%2d",
-                     fbconfig_attribs[i].red_size);
+                     FBCA(RED_SIZE));
             snprintf((char *) (&(str[cell++])), 16, "%2d",
-                     fbconfig_attribs[i].green_size);
+                     FBCA(GREEN_SIZE));
             snprintf((char *) (&(str[cell++])), 16, "%2d",
-                     fbconfig_attribs[i].blue_size);
+                     FBCA(BLUE_SIZE));
             snprintf((char *) (&(str[cell++])), 16, "%2d",
-                     fbconfig_attribs[i].alpha_size);
+                     FBCA(ALPHA_SIZE));
             snprintf((char *) (&(str[cell++])), 16, "%2d",
-                     fbconfig_attribs[i].aux_buffers);
+                     FBCA(AUX_BUFFERS));
             snprintf((char *) (&(str[cell++])), 16, "%2d",
-                     fbconfig_attribs[i].depth_size);
+                     FBCA(DEPTH_SIZE));
             snprintf((char *) (&(str[cell++])), 16, "%2d",
-                     fbconfig_attribs[i].stencil_size);
+                     FBCA(STENCIL_SIZE));
             snprintf((char *) (&(str[cell++])), 16, "%2d",
-                     fbconfig_attribs[i].accum_red_size);
+                     FBCA(ACCUM_RED_SIZE));
             snprintf((char *) (&(str[cell++])), 16, "%2d",
-                     fbconfig_attribs[i].accum_green_size);
+                     FBCA(ACCUM_GREEN_SIZE));
             snprintf((char *) (&(str[cell++])), 16, "%2d",
-                     fbconfig_attribs[i].accum_blue_size);
+                     FBCA(ACCUM_BLUE_SIZE));
             snprintf((char *) (&(str[cell++])), 16, "%2d",
-                     fbconfig_attribs[i].accum_alpha_size);
-            if (fbconfig_attribs[i].multi_sample_valid) {
+                     FBCA(ACCUM_ALPHA_SIZE));
+            if (FBCA(MULTI_SAMPLE_VALID)) {
                 snprintf((char *) (&(str[cell++])), 16, "%2d",
-                         fbconfig_attribs[i].multi_samples);
-                if (fbconfig_attribs[i].multi_sample_coverage_valid) {
+                         FBCA(MULTI_SAMPLES));
+                if (FBCA(MULTI_SAMPLE_COVERAGE_VALID)) {
                     snprintf((char *) (&(str[cell++])), 16, "%2d",
-                             fbconfig_attribs[i].multi_samples_color);
+                             FBCA(MULTI_SAMPLES_COLOR));
                 } else {
                     snprintf((char *) (&(str[cell++])), 16, "%2d",
-                             fbconfig_attribs[i].multi_samples);
+                             FBCA(MULTI_SAMPLES));
                 }
             } else {
                 snprintf((char *) (&(str[cell++])), 16, " 0");
                 snprintf((char *) (&(str[cell++])), 16, " 0");
             }
             snprintf((char *) (&(str[cell++])), 16, "%1d",
-                     fbconfig_attribs[i].multi_sample_buffers);
+                     FBCA(MULTI_SAMPLE_BUFFERS));
             snprintf((char *) (&(str[cell++])), 16, "%s",
-                     caveat_abbrev( fbconfig_attribs[i].config_caveat) );
+                     caveat_abbrev( FBCA(CONFIG_CAVEAT)) );
             snprintf((char *) (&(str[cell++])), 16, "0x%04X",
-                     fbconfig_attribs[i].pbuffer_width);
+                     FBCA(PBUFFER_WIDTH));
             snprintf((char *) (&(str[cell++])), 16, "0x%04X",
-                     fbconfig_attribs[i].pbuffer_height);
+                     FBCA(PBUFFER_HEIGHT));
             snprintf((char *) (&(str[cell++])), 16, "0x%07X",
-                     fbconfig_attribs[i].pbuffer_max);
+                     FBCA(PBUFFER_MAX));
             snprintf((char *) (&(str[cell++])), 16, "%s",
-                     transparent_type_abbrev(fbconfig_attribs[i].transparent_type));
+                     transparent_type_abbrev(FBCA(TRANSPARENT_TYPE)));
             snprintf((char *) (&(str[cell++])), 16, "%3d",
-                     fbconfig_attribs[i].transparent_red_value);
+                     FBCA(TRANSPARENT_RED_VALUE));
             snprintf((char *) (&(str[cell++])), 16, "%3d",
-                     fbconfig_attribs[i].transparent_green_value);
+                     FBCA(TRANSPARENT_GREEN_VALUE));
             snprintf((char *) (&(str[cell++])), 16, "%3d",
-                     fbconfig_attribs[i].transparent_blue_value);
+                     FBCA(TRANSPARENT_BLUE_VALUE));
             snprintf((char *) (&(str[cell++])), 16, "%3d",
-                     fbconfig_attribs[i].transparent_alpha_value);
+                     FBCA(TRANSPARENT_ALPHA_VALUE));
             snprintf((char *) (&(str[cell++])), 16, "%3d",
-                     fbconfig_attribs[i].transparent_index_value);
+                     FBCA(TRANSPARENT_INDEX_VALUE));
             str[NUM_FBCONFIG_ATTRIBS][0] = '\0';
         
             /* Populate row cells */
@@ -556,7 +566,7 @@ GtkWidget* ctk_glx_new(NvCtrlAttributeHandle *handle,
                 gtk_label_set_justify( GTK_LABEL(label), GTK_JUSTIFY_CENTER);
                 gtk_table_attach(GTK_TABLE(data_table), label,
                                  cell, cell+1, 
-                                 i+1, i+2,
+                                 n+1, n+2,
                                  GTK_EXPAND, GTK_EXPAND, 0, 0);
 
                 /* Make sure the table headers are the same width
@@ -575,12 +585,11 @@ GtkWidget* ctk_glx_new(NvCtrlAttributeHandle *handle,
                                                 -1);
                 }
             }
-            i++;
 
         } /* Done - Populating FBconfig table */
 
 
-        free(fbconfig_attribs);
+        free(fbconfig_indices);
 
     } /* Done - FBConfigs exist */
         
@@ -602,13 +611,15 @@ GtkWidget* ctk_glx_new(NvCtrlAttributeHandle *handle,
     }
 
     /* Free memory that may have been allocated */
-    free(fbconfig_attribs);
+    free(fbconfig_indices);
     
     gtk_widget_show_all(GTK_WIDGET(object));
     return GTK_WIDGET(object);
 
 } /* ctk_glx_new */
 
+#undef FBCA
+
 
 
 
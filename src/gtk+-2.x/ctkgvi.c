@@ -502,7 +502,8 @@ static gchar* gpu_name_string(gint gpu, CtrlHandles *handle)
     if ((gpu < 0) || (gpu >= handle->targets[GPU_TARGET].n)) {
         gpu_name = g_strdup_printf("None");
     } else {
-        NvCtrlAttributeHandle *gpu_handle = handle->targets[GPU_TARGET].t[gpu].h;
+        NvCtrlAttributeHandle *gpu_handle =
+            nv_get_ctrl_handle_target(handle, GPU_TARGET, gpu)->h;
         gpu_name = create_gpu_name_string(gpu_handle);
     }
     return gpu_name;
@@ -1228,7 +1228,8 @@ GtkWidget* ctk_thermal_new(NvCtrlAttributeHandle *handle,
         for (j = 1; j <= ctk_thermal->sensor_count; j++) {
             gint reading, target, provider;
             sensor_handle =
-                h->targets[THERMAL_SENSOR_TARGET].t[pDataSensor[j]].h;
+                nv_get_ctrl_handle_target(h, THERMAL_SENSOR_TARGET,
+                                          pDataSensor[j])->h;
 
             if ( !sensor_handle ) {
                 continue;
@@ -1397,7 +1398,8 @@ sensor_end:
         malloc(ctk_thermal->cooler_count * sizeof(CoolerControlRec));
 
     for (j = 1; j <= ctk_thermal->cooler_count; j++) {
-        cooler_handle = h->targets[COOLER_TARGET].t[pDataCooler[j]].h;
+        cooler_handle =
+            nv_get_ctrl_handle_target(h, COOLER_TARGET, pDataCooler[j])->h;
         
         if ( !cooler_handle ) {    
             continue;
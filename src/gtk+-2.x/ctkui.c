@@ -56,7 +56,7 @@ void ctk_main(ParsedAttribute *p,
     window = ctk_window_new(p, conf, h);
 
     for (i = 0; i < h->targets[X_SCREEN_TARGET].n; i++) {
-        if (h->targets[X_SCREEN_TARGET].t[i].h) {
+        if (nv_get_ctrl_handle_target(h, X_SCREEN_TARGET, i)->h) {
             has_nv_control = TRUE;
             break;
         }
@@ -573,8 +573,8 @@ GtkWidget *ctk_window_new(ParsedAttribute *p, ConfigProperties *conf,
          */
 
         for (i = 0 ; i < h->targets[X_SCREEN_TARGET].n; i++) {
-            if (h->targets[X_SCREEN_TARGET].t[i].h) {
-                screen_handle = h->targets[X_SCREEN_TARGET].t[i].h;
+            screen_handle = nv_get_ctrl_handle_target(h, X_SCREEN_TARGET, i)->h;
+            if (screen_handle) {
                 break;
             }
         }
@@ -612,7 +612,8 @@ GtkWidget *ctk_window_new(ParsedAttribute *p, ConfigProperties *conf,
 
         gchar *screen_name;
         GtkWidget *child;
-        NvCtrlAttributeHandle *screen_handle = h->targets[X_SCREEN_TARGET].t[i].h;
+        NvCtrlAttributeHandle *screen_handle =
+            nv_get_ctrl_handle_target(h, X_SCREEN_TARGET, i)->h;
 
         if (!screen_handle) continue;
 
@@ -769,7 +770,8 @@ GtkWidget *ctk_window_new(ParsedAttribute *p, ConfigProperties *conf,
         
         gchar *gpu_name;
         GtkWidget *child;
-        NvCtrlAttributeHandle *gpu_handle = h->targets[GPU_TARGET].t[i].h;
+        NvCtrlAttributeHandle *gpu_handle =
+            nv_get_ctrl_handle_target(h, GPU_TARGET, i)->h;
         UpdateDisplaysData *data;
 
 
@@ -790,6 +792,11 @@ GtkWidget *ctk_window_new(ParsedAttribute *p, ConfigProperties *conf,
         gtk_tree_store_set(ctk_window->tree_store, &iter,
                            CTK_WINDOW_LABEL_COLUMN, gpu_name, -1);
 
+        /*
+         * every X screen target was set up by the X screen loop above,
+         * so the raw target array can be handed to the GPU page
+         */
+
         child = ctk_gpu_new(gpu_handle, h->targets[X_SCREEN_TARGET].t, ctk_event,
                             ctk_config);
 
@@ -876,7 +883,8 @@ GtkWidget *ctk_window_new(ParsedAttribute *p, ConfigProperties *conf,
         gchar *vcs_name;
         GtkWidget *child;
         ReturnStatus ret;
-        NvCtrlAttributeHandle *vcs_handle = h->targets[VCS_TARGET].t[i].h;
+        NvCtrlAttributeHandle *vcs_handle =
+            nv_get_ctrl_handle_target(h, VCS_TARGET, i)->h;
 
         if (!vcs_handle) continue;
 
@@ -929,7 +937,8 @@ GtkWidget *ctk_window_new(ParsedAttribute *p, ConfigProperties *conf,
 
         gchar *gvi_name;
         GtkWidget *child;
-        NvCtrlAttributeHandle *gvi_handle = h->targets[GVI_TARGET].t[i].h;
+        NvCtrlAttributeHandle *gvi_handle =
+            nv_get_ctrl_handle_target(h, GVI_TARGET, i)->h;
 
         if (!gvi_handle) continue;
 
@@ -978,7 +987,8 @@ GtkWidget *ctk_window_new(ParsedAttribute *p, ConfigProperties *conf,
 
     for (i = 0; i < h->targets[X_SCREEN_TARGET].n; i++) {
 
-        NvCtrlAttributeHandle *screen_handle = h->targets[X_SCREEN_TARGET].t[i].h;
+        NvCtrlAttributeHandle *screen_handle =
+            nv_get_ctrl_handle_target(h, X_SCREEN_TARGET, i)->h;
 
         if (!screen_handle) continue;
         
@@ -997,7 +1007,9 @@ GtkWidget *ctk_window_new(ParsedAttribute *p, ConfigProperties *conf,
     /* add NVIDIA 3D VisionPro dongle configuration page */
 
     for (i = 0; i < h->targets[NVIDIA_3D_VISION_PRO_TRANSCEIVER_TARGET].n; i++) {
-        NvCtrlAttributeHandle *svp_handle = h->targets[NVIDIA_3D_VISION_PRO_TRANSCEIVER_TARGET].t[i].h;
+        NvCtrlAttributeHandle *svp_handle =
+            nv_get_ctrl_handle_target(h, NVIDIA_3D_VISION_PRO_TRANSCEIVER_TARGET,
+                                      i)->h;
 
         if (!svp_handle) continue;
 
@@ -42,6 +42,12 @@
 #include "NVCtrlLib.h"
 #include "nv_control.h"
 
+#if defined(XNVCTRL_USE_XCB)
+#include <string.h>
+#include <X11/Xlib-xcb.h>
+#include "NVCtrlXcb.h"
+#endif
+
 #define NVCTRL_EXT_EXISTS              1
 #define NVCTRL_EXT_NEED_TARGET_SWAP    2
 #define NVCTRL_EXT_64_BIT_ATTRIBUTES   4
@@ -81,6 +87,29 @@ static XEXT_GENERATE_FIND_DISPLAY (find_display, nvctrl_ext_info,
 
 static XEXT_GENERATE_CLOSE_DISPLAY (close_display, nvctrl_ext_info)
 
+#if defined(XNVCTRL_USE_XCB)
+
+/*
+ * Return the XCB connection underlying dpy if the attribute requests
+ * should be sent through the XCB backend (see NVCtrlXcb.h), or NULL
+ * if they should use the Xlib code below.  The XCB backend is used
+ * unless XNVCTRL_BACKEND=xlib is set in the environment.
+ */
+
+static xcb_connection_t *xcb_connection(Display *dpy)
+{
+    static int use_xcb = -1;
+
+    if (use_xcb < 0) {
+        const char *backend = getenv("XNVCTRL_BACKEND");
+        use_xcb = !(backend && (strcmp(backend, "xlib") == 0));
+    }
+
+    return use_xcb ? XGetXCBConnection(dpy) : NULL;
+}
+
+#endif /* XNVCTRL_USE_XCB */
+
 /*
  * NV-CONTROL versions 1.8 and 1.9 pack the target_type and target_id
  * fields in reversed order.  In order to talk to one of these servers,
@@ -254,6 +283,15 @@ void XNVCTRLSetTargetAttribute (
     XNVCTRLSimpleCheckExtension (dpy, info);
     XNVCTRLCheckTargetData(dpy, info, &target_type, &target_id);
 
+#if defined(XNVCTRL_USE_XCB)
+    if (xcb_connection(dpy)) {
+        XNVCTRLXcbSetTargetAttribute(xcb_connection(dpy), target_type,
+                                     target_id, display_mask, attribute,
+                                     value);
+        return;
+    }
+#endif
+
     LockDisplay (dpy);
     GetReq (nvCtrlSetAttribute, req);
     req->reqType = info->codes->major_opcode;
@@ -297,6 +335,18 @@ Bool XNVCTRLSetTargetAttributeAndGetStatus (
 
     XNVCTRLCheckExtension (dpy, info, False);
 
+#if defined(XNVCTRL_USE_XCB)
+    if (xcb_connection(dpy)) {
+        XNVCTRLXcbCookie cookie =
+            XNVCTRLXcbSetTargetAttributeAndGetStatus(xcb_connection(dpy),
+                                                     target_type, target_id,
+                                                     display_mask, attribute,
+                                                     value);
+        return XNVCTRLXcbSetTargetAttributeAndGetStatusReply
+            (xcb_connection(dpy), cookie);
+    }
+#endif
+
     LockDisplay (dpy);
     GetReq (nvCtrlSetAttributeAndGetStatus, req);
     req->reqType = info->codes->major_opcode;
@@ -351,6 +401,21 @@ Bool XNVCTRLQueryTargetAttribute (
     XNVCTRLCheckExtension (dpy, info, False);
     XNVCTRLCheckTargetData(dpy, info, &target_type, &target_id);
 
+#if defined(XNVCTRL_USE_XCB)
+    if (xcb_connection(dpy)) {
+        XNVCTRLXcbCookie cookie;
+        int64_t value_64;
+
+        cookie = XNVCTRLXcbQueryTargetAttribute(xcb_connection(dpy),
+                                                target_type, target_id,
+                                                display_mask, attribute);
+        exists = XNVCTRLXcbQueryTargetAttributeReply(xcb_connection(dpy),
+                                                     cookie, &value_64);
+        if (exists && value) *value = value_64;
+        return exists;
+    }
+#endif
+
     LockDisplay (dpy);
     GetReq (nvCtrlQueryAttribute, req);
     req->reqType = info->codes->major_opcode;
@@ -402,6 +467,18 @@ Bool XNVCTRLQueryTargetAttribute64 (
     XNVCTRLCheckExtension(dpy, info, False);
     XNVCTRLCheckTargetData(dpy, info, &target_type, &target_id);
 
+#if defined(XNVCTRL_USE_XCB)
+    if (xcb_connection(dpy)) {
+        XNVCTRLXcbCookie cookie;
+
+        cookie = XNVCTRLXcbQueryTargetAttribute64(xcb_connection(dpy),
+                                                  target_type, target_id,
+                                                  display_mask, attribute);
+        return XNVCTRLXcbQueryTargetAttributeReply(xcb_connection(dpy),
+                                                   cookie, value);
+    }
+#endif
+
     LockDisplay(dpy);
     GetReq(nvCtrlQueryAttribute, req);
     req->reqType = info->codes->major_opcode;
@@ -445,6 +522,18 @@ Bool XNVCTRLQueryTargetStringAttribute (
     XNVCTRLCheckExtension (dpy, info, False);
     XNVCTRLCheckTargetData(dpy, info, &target_type, &target_id);
 
+#if defined(XNVCTRL_USE_XCB)
+    if (xcb_connection(dpy)) {
+        XNVCTRLXcbCookie cookie;
+
+        cookie = XNVCTRLXcbQueryTargetStringAttribute(xcb_connection(dpy),
+                                                      target_type, target_id,
+                                                      display_mask, attribute);
+        return XNVCTRLXcbQueryTargetStringAttributeReply(xcb_connection(dpy),
+                                                         cookie, ptr);
+    }
+#endif
+
     LockDisplay (dpy);
     GetReq (nvCtrlQueryStringAttribute, req);
     req->reqType = info->codes->major_opcode;
@@ -708,6 +797,24 @@ Bool XNVCTRLQueryValidTargetAttributeValues (
     if (!(flags & NVCTRL_EXT_EXISTS))
         return False;
 
+#if defined(XNVCTRL_USE_XCB)
+    if (xcb_connection(dpy)) {
+        XNVCTRLXcbCookie cookie;
+
+        if (flags & NVCTRL_EXT_64_BIT_ATTRIBUTES) {
+            cookie = XNVCTRLXcbQueryValidTargetAttributeValues64
+                (xcb_connection(dpy), target_type, target_id,
+                 display_mask, attribute);
+        } else {
+            cookie = XNVCTRLXcbQueryValidTargetAttributeValues
+                (xcb_connection(dpy), target_type, target_id,
+                 display_mask, attribute);
+        }
+        return XNVCTRLXcbQueryValidTargetAttributeValuesReply
+            (xcb_connection(dpy), cookie, values);
+    }
+#endif
+
     if (flags & NVCTRL_EXT_64_BIT_ATTRIBUTES) {
         exists = XNVCTRLQueryValidTargetAttributeValues64(dpy, info,
                                                           target_type,
@@ -1114,6 +1221,293 @@ Bool XNVCTRLStringOperation (
 }
 
 
+/*
+ * State shared between XNVCTRLQueryTargetBatch() and the async reply
+ * handler that collects the replies to the batched requests; the
+ * request with sequence number start_seq + i is queries[i].
+ */
+
+typedef struct {
+    XNVCTRLBatchQueryRec *queries;
+    unsigned long start_seq;
+    unsigned long stop_seq;
+    Bool use_64;
+} XNVCTRLBatchState;
+
+
+static Bool batch_reply_handler (
+    Display *dpy,
+    xReply *rep,
+    char *buf,
+    int len,
+    XPointer data
+){
+    XNVCTRLBatchState *state = (XNVCTRLBatchState *) data;
+    XNVCTRLBatchQueryRec *q;
+
+    if (dpy->last_request_read < state->start_seq ||
+        dpy->last_request_read > state->stop_seq)
+        return False;
+
+    q = &state->queries[dpy->last_request_read - state->start_seq];
+
+    /*
+     * fail this entry; returning False passes the error on to the
+     * normal X error handler
+     */
+
+    if (rep->generic.type == X_Error) {
+        q->status = False;
+        return False;
+    }
+
+    switch (q->query_type) {
+
+    case XNVCTRL_BATCH_QUERY_ATTRIBUTE:
+        if (state->use_64) {
+            xnvCtrlQueryAttribute64Reply replbuf, *repl;
+            repl = (xnvCtrlQueryAttribute64Reply *)
+                _XGetAsyncReply(dpy, (char *) &replbuf, rep, buf, len,
+                                (SIZEOF(xnvCtrlQueryAttribute64Reply) -
+                                 SIZEOF(xReply)) >> 2, True);
+            q->status = repl->flags;
+            if (q->status) q->value = repl->value_64;
+        } else {
+            xnvCtrlQueryAttributeReply replbuf, *repl;
+            repl = (xnvCtrlQueryAttributeReply *)
+                _XGetAsyncReply(dpy, (char *) &replbuf, rep, buf, len,
+                                (SIZEOF(xnvCtrlQueryAttributeReply) -
+                                 SIZEOF(xReply)) >> 2, True);
+            q->status = repl->flags;
+            if (q->status) q->value = repl->value;
+        }
+        break;
+
+    case XNVCTRL_BATCH_QUERY_VALID_VALUES:
+        if (state->use_64) {
+            xnvCtrlQueryValidAttributeValues64Reply replbuf, *repl;
+            repl = (xnvCtrlQueryValidAttributeValues64Reply *)
+                _XGetAsyncReply(dpy, (char *) &replbuf, rep, buf, len,
+                                sz_xnvCtrlQueryValidAttributeValues64Reply_extra,
+                                True);
+            q->status = repl->flags;
+            if (q->status) {
+                q->valid_values.type = repl->attr_type;
+                if (repl->attr_type == ATTRIBUTE_TYPE_RANGE) {
+                    q->valid_values.u.range.min = repl->min_64;
+                    q->valid_values.u.range.max = repl->max_64;
+                }
+                if (repl->attr_type == ATTRIBUTE_TYPE_INT_BITS) {
+                    q->valid_values.u.bits.ints = repl->bits_64;
+                }
+                q->valid_values.permissions = repl->perms;
+            }
+        } else {
+            xnvCtrlQueryValidAttributeValuesReply replbuf, *repl;
+            repl = (xnvCtrlQueryValidAttributeValuesReply *)
+                _XGetAsyncReply(dpy, (char *) &replbuf, rep, buf, len,
+                                (SIZEOF(xnvCtrlQueryValidAttributeValuesReply) -
+                                 SIZEOF(xReply)) >> 2, True);
+            q->status = repl->flags;
+            if (q->status) {
+                q->valid_values.type = repl->attr_type;
+                if (repl->attr_type == ATTRIBUTE_TYPE_RANGE) {
+                    q->valid_values.u.range.min = repl->min;
+                    q->valid_values.u.range.max = repl->max;
+                }
+                if (repl->attr_type == ATTRIBUTE_TYPE_INT_BITS) {
+                    q->valid_values.u.bits.ints = repl->bits;
+                }
+                q->valid_values.permissions = repl->perms;
+            }
+        }
+        break;
+
+    case XNVCTRL_BATCH_QUERY_STRING_ATTRIBUTE:
+        {
+            xnvCtrlQueryStringAttributeReply replbuf, *repl;
+            int numbytes;
+
+            repl = (xnvCtrlQueryStringAttributeReply *)
+                _XGetAsyncReply(dpy, (char *) &replbuf, rep, buf, len,
+                                0, False);
+            numbytes = repl->n;
+            q->status = repl->flags;
+            if (q->status) {
+                q->string = (char *) Xmalloc(numbytes);
+            }
+            if (!q->status || !q->string) {
+                q->status = False;
+                _XGetAsyncData(dpy, NULL, buf, len,
+                               SIZEOF(xnvCtrlQueryStringAttributeReply),
+                               0, repl->length << 2);
+            } else {
+                _XGetAsyncData(dpy, q->string, buf, len,
+                               SIZEOF(xnvCtrlQueryStringAttributeReply),
+                               numbytes, repl->length << 2);
+            }
+        }
+        break;
+
+    case XNVCTRL_BATCH_SET_ATTRIBUTE:
+        {
+            xnvCtrlSetAttributeAndGetStatusReply replbuf, *repl;
+            repl = (xnvCtrlSetAttributeAndGetStatusReply *)
+                _XGetAsyncReply(dpy, (char *) &replbuf, rep, buf, len,
+                                (SIZEOF(xnvCtrlSetAttributeAndGetStatusReply) -
+                                 SIZEOF(xReply)) >> 2, True);
+            q->status = repl->flags;
+        }
+        break;
+    }
+
+    return True;
+}
+
+
+Bool XNVCTRLQueryTargetBatch (
+    Display *dpy,
+    XNVCTRLBatchQueryRec *queries,
+    int count
+){
+    XExtDisplayInfo *info = find_display(dpy);
+    XNVCTRLBatchState state;
+    _XAsyncHandler async;
+    xGetInputFocusReply rep;
+    xReq *sync_req;
+    uintptr_t flags;
+    int i;
+
+    if (!queries || count <= 0) return False;
+
+    if (!XextHasExtension(info))
+        return False;
+
+    XNVCTRLCheckExtension(dpy, info, False);
+
+    /*
+     * Resolve the version flags before taking the display lock; this
+     * may itself need a round trip the first time through.
+     */
+
+    flags = version_flags(dpy, info);
+
+    if (!(flags & NVCTRL_EXT_EXISTS))
+        return False;
+
+    for (i = 0; i < count; i++) {
+        switch (queries[i].query_type) {
+        case XNVCTRL_BATCH_QUERY_ATTRIBUTE:
+        case XNVCTRL_BATCH_QUERY_VALID_VALUES:
+        case XNVCTRL_BATCH_QUERY_STRING_ATTRIBUTE:
+            queries[i].value = 0;
+            break;
+        case XNVCTRL_BATCH_SET_ATTRIBUTE:
+            break;
+        default:
+            return False;
+        }
+        queries[i].status = False;
+        queries[i].string = NULL;
+    }
+
+    state.queries = queries;
+    state.use_64 = (flags & NVCTRL_EXT_64_BIT_ATTRIBUTES) ? True : False;
+
+    LockDisplay(dpy);
+
+    state.start_seq = dpy->request + 1;
+    state.stop_seq = dpy->request + count;
+
+    async.next = dpy->async_handlers;
+    async.handler = batch_reply_handler;
+    async.data = (XPointer) &state;
+    dpy->async_handlers = &async;
+
+    for (i = 0; i < count; i++) {
+        XNVCTRLBatchQueryRec *q = &queries[i];
+        int target_type = q->target_type;
+        int target_id = q->target_id;
+
+        if (flags & NVCTRL_EXT_NEED_TARGET_SWAP) {
+            target_type = q->target_id;
+            target_id = q->target_type;
+        }
+
+        switch (q->query_type) {
+        case XNVCTRL_BATCH_QUERY_ATTRIBUTE:
+            {
+                xnvCtrlQueryAttributeReq *req;
+                GetReq(nvCtrlQueryAttribute, req);
+                req->reqType = info->codes->major_opcode;
+                req->nvReqType = state.use_64 ? X_nvCtrlQueryAttribute64 :
+                                                X_nvCtrlQueryAttribute;
+                req->target_type = target_type;
+                req->target_id = target_id;
+                req->display_mask = q->display_mask;
+                req->attribute = q->attribute;
+            }
+            break;
+        case XNVCTRL_BATCH_QUERY_VALID_VALUES:
+            {
+                xnvCtrlQueryValidAttributeValuesReq *req;
+                GetReq(nvCtrlQueryValidAttributeValues, req);
+                req->reqType = info->codes->major_opcode;
+                req->nvReqType = state.use_64 ?
+                    X_nvCtrlQueryValidAttributeValues64 :
+                    X_nvCtrlQueryValidAttributeValues;
+                req->target_type = target_type;
+                req->target_id = target_id;
+                req->display_mask = q->display_mask;
+                req->attribute = q->attribute;
+            }
+            break;
+        case XNVCTRL_BATCH_QUERY_STRING_ATTRIBUTE:
+            {
+                xnvCtrlQueryStringAttributeReq *req;
+                GetReq(nvCtrlQueryStringAttribute, req);
+                req->reqType = info->codes->major_opcode;
+                req->nvReqType = X_nvCtrlQueryStringAttribute;
+                req->target_type = target_type;
+                req->target_id = target_id;
+                req->display_mask = q->display_mask;
+                req->attribute = q->attribute;
+            }
+            break;
+        case XNVCTRL_BATCH_SET_ATTRIBUTE:
+            {
+                xnvCtrlSetAttributeAndGetStatusReq *req;
+                GetReq(nvCtrlSetAttributeAndGetStatus, req);
+                req->reqType = info->codes->major_opcode;
+                req->nvReqType = X_nvCtrlSetAttributeAndGetStatus;
+                req->target_type = target_type;
+                req->target_id = target_id;
+                req->display_mask = q->display_mask;
+                req->attribute = q->attribute;
+                req->value = q->value;
+            }
+            break;
+        }
+    }
+
+    /*
+     * Follow the batch with a GetInputFocus request, like XSync(); by
+     * the time its reply arrives, the async handler has seen the
+     * replies to every request in the batch.
+     */
+
+    GetEmptyReq(GetInputFocus, sync_req);
+    (void) sync_req; /* only needed by older GetEmptyReq() macros */
+    (void) _XReply(dpy, (xReply *) &rep, 0, xTrue);
+
+    DeqAsyncHandler(dpy, &async);
+    UnlockDisplay(dpy);
+    SyncHandle();
+
+    return True;
+}
+
+
 static Bool wire_to_event (Display *dpy, XEvent *host, xEvent *wire)
 {
     XExtDisplayInfo *info = find_display (dpy);
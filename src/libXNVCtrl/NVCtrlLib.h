@@ -632,6 +632,68 @@ Bool XNVCTRLStringOperation (
 );
 
 
+/*
+ * XNVCTRLQueryTargetBatch -
+ *
+ * Issues all of the queries described by the 'count' entries of
+ * 'queries' back to back, and then collects all of the replies, so
+ * that the whole batch costs a single round trip to the server rather
+ * than one round trip per query.  The query_type of each entry selects
+ * which query is made:
+ *
+ *   XNVCTRL_BATCH_QUERY_ATTRIBUTE: as XNVCTRLQueryTargetAttribute64();
+ *     the result is returned in 'value'.
+ *
+ *   XNVCTRL_BATCH_QUERY_VALID_VALUES: as
+ *     XNVCTRLQueryValidTargetAttributeValues(); the result is returned
+ *     in 'valid_values'.
+ *
+ *   XNVCTRL_BATCH_QUERY_STRING_ATTRIBUTE: as
+ *     XNVCTRLQueryTargetStringAttribute(); the result is returned in
+ *     'string', which the caller should free with XFree().
+ *
+ *   XNVCTRL_BATCH_SET_ATTRIBUTE: as
+ *     XNVCTRLSetTargetAttributeAndGetStatus(), assigning 'value'; the
+ *     'status' is the status returned by the server.
+ *
+ * The per-entry 'status' is set to True if that query succeeded, and
+ * False otherwise.  An X error generated by an individual query sets
+ * that entry's 'status' to False, and is then passed to the normal X
+ * error handler, as for any other request: unless the application
+ * has installed its own handler with XSetErrorHandler(), the default
+ * handler prints the error and exits.
+ *
+ * Returns False if the batch could not be sent at all (e.g., the
+ * NV-CONTROL extension is not present, or an entry has an unknown
+ * query_type), and True otherwise.
+ */
+
+#define XNVCTRL_BATCH_QUERY_ATTRIBUTE         0
+#define XNVCTRL_BATCH_QUERY_VALID_VALUES      1
+#define XNVCTRL_BATCH_QUERY_STRING_ATTRIBUTE  2
+#define XNVCTRL_BATCH_SET_ATTRIBUTE           3
+
+typedef struct {
+    int query_type;
+    int target_type;
+    int target_id;
+    unsigned int display_mask;
+    unsigned int attribute;
+
+    /* results */
+    Bool status;
+    int64_t value;
+    NVCTRLAttributeValidValuesRec valid_values;
+    char *string;
+} XNVCTRLBatchQueryRec;
+
+Bool XNVCTRLQueryTargetBatch (
+    Display *dpy,
+    XNVCTRLBatchQueryRec *queries,
+    int count
+);
+
+
 
 /*
  * XNVCtrlSelectNotify -
@@ -0,0 +1,369 @@
+/*
+ * Copyright (c) 2008 NVIDIA, Corporation
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice (including the next
+ * paragraph) shall be included in all copies or substantial portions of the
+ * Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+/*
+ * XCB implementation of the NV-CONTROL client requests; see
+ * NVCtrlXcb.h.
+ */
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/uio.h>
+#include <X11/Xmd.h>
+#include <X11/Xproto.h>
+#include <xcb/xcb.h>
+#include <xcb/xcbext.h>
+#include "NVCtrlXcb.h"
+#include "nv_control.h"
+
+static xcb_extension_t xnvctrl_xcb_id = { NV_CONTROL_NAME, 0 };
+
+
+/*
+ * send_request() - send a request of 'size' bytes, whose NV-CONTROL
+ * minor opcode is 'request'; XCB fills in the major opcode and
+ * length.
+ */
+
+static XNVCTRLXcbCookie send_request(xcb_connection_t *c, int request,
+                                     void *req, int size, int has_reply)
+{
+    struct iovec parts[4];
+    xcb_protocol_request_t xcb_req;
+    XNVCTRLXcbCookie cookie;
+
+    xcb_req.count = 2;
+    xcb_req.ext = &xnvctrl_xcb_id;
+    xcb_req.opcode = request;
+    xcb_req.isvoid = !has_reply;
+
+    parts[2].iov_base = req;
+    parts[2].iov_len = size;
+    parts[3].iov_base = NULL;
+    parts[3].iov_len = -size & 3;
+
+    cookie.sequence = xcb_send_request(c, has_reply ? XCB_REQUEST_CHECKED : 0,
+                                       parts + 2, &xcb_req);
+    cookie.request = request;
+
+    return cookie;
+}
+
+
+/*
+ * send_target_request() - send one of the requests that share the
+ * target_type/target_id/display_mask/attribute request layout.
+ */
+
+static XNVCTRLXcbCookie send_target_request(xcb_connection_t *c,
+                                            int request,
+                                            int target_type,
+                                            int target_id,
+                                            unsigned int display_mask,
+                                            unsigned int attribute)
+{
+    xnvCtrlQueryAttributeReq req;
+
+    memset(&req, 0, sizeof(req));
+    req.nvReqType = request;
+    req.target_type = target_type;
+    req.target_id = target_id;
+    req.display_mask = display_mask;
+    req.attribute = attribute;
+
+    return send_request(c, request, &req, sz_xnvCtrlQueryAttributeReq, 1);
+}
+
+
+/*
+ * wait_reply() - wait for the reply to the given cookie; returns a
+ * malloc()'ed reply, or NULL if the request generated an error.
+ */
+
+static void *wait_reply(xcb_connection_t *c, XNVCTRLXcbCookie cookie)
+{
+    xcb_generic_error_t *error = NULL;
+    void *reply;
+
+    reply = xcb_wait_for_reply(c, cookie.sequence, &error);
+    if (error) {
+        free(error);
+        free(reply);
+        return NULL;
+    }
+
+    return reply;
+}
+
+
+XNVCTRLXcbCookie XNVCTRLXcbQueryVersion (
+    xcb_connection_t *c
+){
+    xnvCtrlQueryExtensionReq req;
+
+    memset(&req, 0, sizeof(req));
+    req.nvReqType = X_nvCtrlQueryExtension;
+
+    return send_request(c, X_nvCtrlQueryExtension, &req,
+                        sz_xnvCtrlQueryExtensionReq, 1);
+}
+
+int XNVCTRLXcbQueryVersionReply (
+    xcb_connection_t *c,
+    XNVCTRLXcbCookie cookie,
+    int *major,
+    int *minor
+){
+    xnvCtrlQueryExtensionReply *rep = wait_reply(c, cookie);
+
+    if (!rep) return 0;
+    if (major) *major = rep->major;
+    if (minor) *minor = rep->minor;
+    free(rep);
+    return 1;
+}
+
+
+XNVCTRLXcbCookie XNVCTRLXcbQueryTargetAttribute (
+    xcb_connection_t *c,
+    int target_type,
+    int target_id,
+    unsigned int display_mask,
+    unsigned int attribute
+){
+    return send_target_request(c, X_nvCtrlQueryAttribute, target_type,
+                               target_id, display_mask, attribute);
+}
+
+XNVCTRLXcbCookie XNVCTRLXcbQueryTargetAttribute64 (
+    xcb_connection_t *c,
+    int target_type,
+    int target_id,
+    unsigned int display_mask,
+    unsigned int attribute
+){
+    return send_target_request(c, X_nvCtrlQueryAttribute64, target_type,
+                               target_id, display_mask, attribute);
+}
+
+int XNVCTRLXcbQueryTargetAttributeReply (
+    xcb_connection_t *c,
+    XNVCTRLXcbCookie cookie,
+    int64_t *value
+){
+    void *rep = wait_reply(c, cookie);
+    int exists = 0;
+
+    if (!rep) return 0;
+
+    if (cookie.request == X_nvCtrlQueryAttribute64) {
+        xnvCtrlQueryAttribute64Reply *rep64 = rep;
+        exists = rep64->flags;
+        if (exists && value) *value = rep64->value_64;
+    } else {
+        xnvCtrlQueryAttributeReply *rep32 = rep;
+        exists = rep32->flags;
+        if (exists && value) *value = rep32->value;
+    }
+
+    free(rep);
+    return exists;
+}
+
+
+XNVCTRLXcbCookie XNVCTRLXcbQueryValidTargetAttributeValues (
+    xcb_connection_t *c,
+    int target_type,
+    int target_id,
+    unsigned int display_mask,
+    unsigned int attribute
+){
+    return send_target_request(c, X_nvCtrlQueryValidAttributeValues,
+                               target_type, target_id, display_mask,
+                               attribute);
+}
+
+XNVCTRLXcbCookie XNVCTRLXcbQueryValidTargetAttributeValues64 (
+    xcb_connection_t *c,
+    int target_type,
+    int target_id,
+    unsigned int display_mask,
+    unsigned int attribute
+){
+    return send_target_request(c, X_nvCtrlQueryValidAttributeValues64,
+                               target_type, target_id, display_mask,
+                               attribute);
+}
+
+int XNVCTRLXcbQueryValidTargetAttributeValuesReply (
+    xcb_connection_t *c,
+    XNVCTRLXcbCookie cookie,
+    NVCTRLAttributeValidValuesRec *values
+){
+    void *rep = wait_reply(c, cookie);
+    int exists = 0;
+
+    if (!rep) return 0;
+
+    if (cookie.request == X_nvCtrlQueryValidAttributeValues64) {
+        xnvCtrlQueryValidAttributeValues64Reply *rep64 = rep;
+        exists = rep64->flags;
+        if (exists && values) {
+            values->type = rep64->attr_type;
+            if (rep64->attr_type == ATTRIBUTE_TYPE_RANGE) {
+                values->u.range.min = rep64->min_64;
+                values->u.range.max = rep64->max_64;
+            }
+            if (rep64->attr_type == ATTRIBUTE_TYPE_INT_BITS) {
+                values->u.bits.ints = rep64->bits_64;
+            }
+            values->permissions = rep64->perms;
+        }
+    } else {
+        xnvCtrlQueryValidAttributeValuesReply *rep32 = rep;
+        exists = rep32->flags;
+        if (exists && values) {
+            values->type = rep32->attr_type;
+            if (rep32->attr_type == ATTRIBUTE_TYPE_RANGE) {
+                values->u.range.min = rep32->min;
+                values->u.range.max = rep32->max;
+            }
+            if (rep32->attr_type == ATTRIBUTE_TYPE_INT_BITS) {
+                values->u.bits.ints = rep32->bits;
+            }
+            values->permissions = rep32->perms;
+        }
+    }
+
+    free(rep);
+    return exists;
+}
+
+
+XNVCTRLXcbCookie XNVCTRLXcbQueryTargetStringAttribute (
+    xcb_connection_t *c,
+    int target_type,
+    int target_id,
+    unsigned int display_mask,
+    unsigned int attribute
+){
+    return send_target_request(c, X_nvCtrlQueryStringAttribute, target_type,
+                               target_id, display_mask, attribute);
+}
+
+int XNVCTRLXcbQueryTargetStringAttributeReply (
+    xcb_connection_t *c,
+    XNVCTRLXcbCookie cookie,
+    char **ptr
+){
+    xnvCtrlQueryStringAttributeReply *rep = wait_reply(c, cookie);
+    int exists;
+
+    if (!rep) return 0;
+
+    exists = rep->flags;
+
+    /* the string follows the fixed-size part of the reply */
+
+    if (exists && ptr) {
+        *ptr = malloc(rep->n);
+        if (*ptr) {
+            memcpy(*ptr, (char *) rep + sz_xnvCtrlQueryStringAttributeReply,
+                   rep->n);
+        } else {
+            exists = 0;
+        }
+    }
+
+    free(rep);
+    return exists;
+}
+
+
+void XNVCTRLXcbSetTargetAttribute (
+    xcb_connection_t *c,
+    int target_type,
+    int target_id,
+    unsigned int display_mask,
+    unsigned int attribute,
+    int value
+){
+    xnvCtrlSetAttributeReq req;
+
+    memset(&req, 0, sizeof(req));
+    req.nvReqType = X_nvCtrlSetAttribute;
+    req.target_type = target_type;
+    req.target_id = target_id;
+    req.display_mask = display_mask;
+    req.attribute = attribute;
+    req.value = value;
+
+    (void) send_request(c, X_nvCtrlSetAttribute, &req,
+                        sz_xnvCtrlSetAttributeReq, 0);
+}
+
+
+XNVCTRLXcbCookie XNVCTRLXcbSetTargetAttributeAndGetStatus (
+    xcb_connection_t *c,
+    int target_type,
+    int target_id,
+    unsigned int display_mask,
+    unsigned int attribute,
+    int value
+){
+    xnvCtrlSetAttributeAndGetStatusReq req;
+
+    memset(&req, 0, sizeof(req));
+    req.nvReqType = X_nvCtrlSetAttributeAndGetStatus;
+    req.target_type = target_type;
+    req.target_id = target_id;
+    req.display_mask = display_mask;
+    req.attribute = attribute;
+    req.value = value;
+
+    return send_request(c, X_nvCtrlSetAttributeAndGetStatus, &req,
+                        sz_xnvCtrlSetAttributeAndGetStatusReq, 1);
+}
+
+int XNVCTRLXcbSetTargetAttributeAndGetStatusReply (
+    xcb_connection_t *c,
+    XNVCTRLXcbCookie cookie
+){
+    xnvCtrlSetAttributeAndGetStatusReply *rep = wait_reply(c, cookie);
+    int success;
+
+    if (!rep) return 0;
+
+    success = rep->flags;
+    free(rep);
+    return success;
+}
+
+
+void XNVCTRLXcbDiscardReply (
+    xcb_connection_t *c,
+    XNVCTRLXcbCookie cookie
+){
+    xcb_discard_reply(c, cookie.sequence);
+}
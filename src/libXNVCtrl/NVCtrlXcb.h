@@ -0,0 +1,219 @@
+/*
+ * Copyright (c) 2008 NVIDIA, Corporation
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice (including the next
+ * paragraph) shall be included in all copies or substantial portions of the
+ * Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#ifndef __NVCTRLXCB_H
+#define __NVCTRLXCB_H
+
+/*
+ * XCB-based NV-CONTROL client interface.
+ *
+ * Each request is split into a function that sends the request and
+ * returns an XNVCTRLXcbCookie without waiting for the server, and a
+ * matching *Reply function that waits for (or collects) the reply.
+ * Any number of requests may be in flight at once, and, as these
+ * functions only use the thread-safe XCB connection, they may be
+ * called from any thread without XInitThreads().
+ *
+ * These functions talk to the wire protocol directly: callers talking
+ * to an NV-CONTROL 1.8 or 1.9 server must swap target_type and
+ * target_id themselves, and the *64 requests require NV-CONTROL 1.21
+ * or later.  X errors are not passed to the Xlib error handler; the
+ * reply function simply returns 0.
+ *
+ * This interface is only available when libXNVCtrl is built with
+ * XNVCTRL_USE_XCB defined.
+ */
+
+#include <stdint.h>
+#include <xcb/xcb.h>
+
+#include "NVCtrl.h"
+
+#if defined __cplusplus
+extern "C" {
+#endif
+
+typedef struct {
+    unsigned int sequence;  /* XCB sequence number of the request */
+    int request;            /* NV-CONTROL minor opcode of the request */
+} XNVCTRLXcbCookie;
+
+
+/*
+ * XNVCTRLXcbQueryVersion -
+ *
+ * The reply returns 1 and the extension version in major and minor
+ * if the query succeeded; 0 otherwise.
+ */
+
+XNVCTRLXcbCookie XNVCTRLXcbQueryVersion (
+    xcb_connection_t *c
+);
+
+int XNVCTRLXcbQueryVersionReply (
+    xcb_connection_t *c,
+    XNVCTRLXcbCookie cookie,
+    int *major,
+    int *minor
+);
+
+
+/*
+ * XNVCTRLXcbQueryTargetAttribute[64] -
+ *
+ * The reply returns 1 and the attribute value in value if the
+ * attribute exists; 0 otherwise.  The same reply function is used for
+ * both the 32-bit and 64-bit request.
+ */
+
+XNVCTRLXcbCookie XNVCTRLXcbQueryTargetAttribute (
+    xcb_connection_t *c,
+    int target_type,
+    int target_id,
+    unsigned int display_mask,
+    unsigned int attribute
+);
+
+XNVCTRLXcbCookie XNVCTRLXcbQueryTargetAttribute64 (
+    xcb_connection_t *c,
+    int target_type,
+    int target_id,
+    unsigned int display_mask,
+    unsigned int attribute
+);
+
+int XNVCTRLXcbQueryTargetAttributeReply (
+    xcb_connection_t *c,
+    XNVCTRLXcbCookie cookie,
+    int64_t *value
+);
+
+
+/*
+ * XNVCTRLXcbQueryValidTargetAttributeValues[64] -
+ *
+ * The reply returns 1 and fills in values if the attribute exists; 0
+ * otherwise.  The same reply function is used for both the 32-bit and
+ * 64-bit request.
+ */
+
+XNVCTRLXcbCookie XNVCTRLXcbQueryValidTargetAttributeValues (
+    xcb_connection_t *c,
+    int target_type,
+    int target_id,
+    unsigned int display_mask,
+    unsigned int attribute
+);
+
+XNVCTRLXcbCookie XNVCTRLXcbQueryValidTargetAttributeValues64 (
+    xcb_connection_t *c,
+    int target_type,
+    int target_id,
+    unsigned int display_mask,
+    unsigned int attribute
+);
+
+int XNVCTRLXcbQueryValidTargetAttributeValuesReply (
+    xcb_connection_t *c,
+    XNVCTRLXcbCookie cookie,
+    NVCTRLAttributeValidValuesRec *values
+);
+
+
+/*
+ * XNVCTRLXcbQueryTargetStringAttribute -
+ *
+ * The reply returns 1 if the attribute exists, in which case *ptr
+ * points to a malloc()'ed copy of the string that the caller should
+ * free(); 0 otherwise.
+ */
+
+XNVCTRLXcbCookie XNVCTRLXcbQueryTargetStringAttribute (
+    xcb_connection_t *c,
+    int target_type,
+    int target_id,
+    unsigned int display_mask,
+    unsigned int attribute
+);
+
+int XNVCTRLXcbQueryTargetStringAttributeReply (
+    xcb_connection_t *c,
+    XNVCTRLXcbCookie cookie,
+    char **ptr
+);
+
+
+/*
+ * XNVCTRLXcbSetTargetAttribute -
+ *
+ * Sends a SetAttribute request; no reply is generated.
+ */
+
+void XNVCTRLXcbSetTargetAttribute (
+    xcb_connection_t *c,
+    int target_type,
+    int target_id,
+    unsigned int display_mask,
+    unsigned int attribute,
+    int value
+);
+
+
+/*
+ * XNVCTRLXcbSetTargetAttributeAndGetStatus -
+ *
+ * The reply returns 1 if the server accepted the new value; 0
+ * otherwise.
+ */
+
+XNVCTRLXcbCookie XNVCTRLXcbSetTargetAttributeAndGetStatus (
+    xcb_connection_t *c,
+    int target_type,
+    int target_id,
+    unsigned int display_mask,
+    unsigned int attribute,
+    int value
+);
+
+int XNVCTRLXcbSetTargetAttributeAndGetStatusReply (
+    xcb_connection_t *c,
+    XNVCTRLXcbCookie cookie
+);
+
+
+/*
+ * XNVCTRLXcbDiscardReply -
+ *
+ * Discards the reply to a request whose result is no longer needed.
+ */
+
+void XNVCTRLXcbDiscardReply (
+    xcb_connection_t *c,
+    XNVCTRLXcbCookie cookie
+);
+
+#if defined __cplusplus
+} /* extern "C" */
+#endif
+
+#endif /* __NVCTRLXCB_H */
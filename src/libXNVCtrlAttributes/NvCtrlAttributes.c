@@ -36,6 +36,7 @@
 #include <stdlib.h>
 #include <string.h>
 #include <stdio.h>
+#include <pthread.h>
 
 #include <sys/utsname.h>
 
@@ -78,40 +79,17 @@ NvCtrlAttributeHandle *NvCtrlAttributeInit(Display *dpy, int target_type,
     if (target_type == NV_CTRL_TARGET_TYPE_X_SCREEN) {
 
         /*
-         * initialize the XF86VidMode attributes; it is OK if this
-         * fails
+         * these are initialized by NvCtrlInitSubsystems() the first
+         * time one of their attributes is used, so that clients that
+         * only need NV-CONTROL (e.g., a single command line query) do
+         * not pay for loading and probing them
          */
-        
-        if (subsystems & NV_CTRL_ATTRIBUTES_XF86VIDMODE_SUBSYSTEM) {
-            h->vm = NvCtrlInitVidModeAttributes(h);
-        }
-        
-        /*
-         * initialize the XVideo extension and attributes; it is OK if
-         * this fails
-         */
-        
-        if (subsystems & NV_CTRL_ATTRIBUTES_XVIDEO_SUBSYSTEM) {
-            h->xv = NvCtrlInitXvAttributes(h);
-        }
-        
-        /*
-         * initialize the GLX extension and attributes; it is OK if
-         * this fails
-         */
-        
-        if (subsystems & NV_CTRL_ATTRIBUTES_GLX_SUBSYSTEM) {
-            h->glx = NvCtrlInitGlxAttributes(h);
-        }
-        
-        /*
-         * initialize the XRandR extension and attributes; it is OK if
-         * this fails
-         */
-        
-        if (subsystems & NV_CTRL_ATTRIBUTES_XRANDR_SUBSYSTEM) {
-            h->xrandr = NvCtrlInitXrandrAttributes(h);
-        }
+
+        h->uninitialized_subsystems = subsystems &
+            (NV_CTRL_ATTRIBUTES_XF86VIDMODE_SUBSYSTEM |
+             NV_CTRL_ATTRIBUTES_XVIDEO_SUBSYSTEM |
+             NV_CTRL_ATTRIBUTES_GLX_SUBSYSTEM |
+             NV_CTRL_ATTRIBUTES_XRANDR_SUBSYSTEM);
 
     } /* X Screen target type attribute subsystems */
   
@@ -124,6 +102,54 @@ NvCtrlAttributeHandle *NvCtrlAttributeInit(Display *dpy, int target_type,
 } /* NvCtrlAttributeInit() */
 
 
+
+/*
+ * NvCtrlInitSubsystems() - initialize those of the given subsystems
+ * that were requested in NvCtrlAttributeInit() but have not been
+ * initialized yet.  It is OK if any of them fails; the corresponding
+ * attributes then report NvCtrlMissingExtension.
+ */
+
+/*
+ * Probing the subsystems temporarily replaces the process-wide Xlib
+ * error handler, and loads libraries whose handles are shared by all
+ * NvCtrlAttributeHandles; serialize it for clients that work on
+ * several displays from different threads.
+ */
+
+static pthread_mutex_t subsystems_lock = PTHREAD_MUTEX_INITIALIZER;
+
+void NvCtrlInitSubsystems(NvCtrlAttributePrivateHandle *h,
+                          unsigned int subsystems)
+{
+    subsystems &= h->uninitialized_subsystems;
+    if (!subsystems) return;
+
+    h->uninitialized_subsystems &= ~subsystems;
+
+    pthread_mutex_lock(&subsystems_lock);
+
+    if (subsystems & NV_CTRL_ATTRIBUTES_XF86VIDMODE_SUBSYSTEM) {
+        h->vm = NvCtrlInitVidModeAttributes(h);
+    }
+
+    if (subsystems & NV_CTRL_ATTRIBUTES_XVIDEO_SUBSYSTEM) {
+        h->xv = NvCtrlInitXvAttributes(h);
+    }
+
+    if (subsystems & NV_CTRL_ATTRIBUTES_GLX_SUBSYSTEM) {
+        h->glx = NvCtrlInitGlxAttributes(h);
+    }
+
+    if (subsystems & NV_CTRL_ATTRIBUTES_XRANDR_SUBSYSTEM) {
+        h->xrandr = NvCtrlInitXrandrAttributes(h);
+    }
+
+    pthread_mutex_unlock(&subsystems_lock);
+
+} /* NvCtrlInitSubsystems() */
+
+
 /*
  * NvCtrlGetDisplayName() - return a string of the form:
  * 
@@ -293,12 +319,55 @@ int NvCtrlGetXrandrEventBase(NvCtrlAttributeHandle *handle)
 
     h = (NvCtrlAttributePrivateHandle *) handle;
 
+    NvCtrlInitSubsystems(h, NV_CTRL_ATTRIBUTES_XRANDR_SUBSYSTEM);
     if (!h->xrandr) return -1;
     return (h->xrandr->event_base);
     
 } /* NvCtrlGetXrandrEventBase() */
 
 
+/*
+ * NvCtrlXrandrScreenChanged() - tell the XRandR subsystem that an
+ * RRScreenChangeNotify event was received, so that cached screen
+ * configurations are refetched.
+ */
+
+void NvCtrlXrandrScreenChanged(NvCtrlAttributeHandle *handle)
+{
+    NvCtrlAttributePrivateHandle *h;
+
+    if (!handle) return;
+
+    h = (NvCtrlAttributePrivateHandle *) handle;
+
+    NvCtrlXrandrInvalidateScreenConfig(h);
+
+} /* NvCtrlXrandrScreenChanged() */
+
+
+/*
+ * NvCtrlXrandrTrackScreenChanges() - tell the XRandR subsystem that
+ * the RRScreenChangeNotify events of the handle's X screen will be
+ * passed to NvCtrlXrandrScreenChanged(), so that its screen
+ * configuration may be cached until then.
+ */
+
+void NvCtrlXrandrTrackScreenChanges(NvCtrlAttributeHandle *handle)
+{
+    NvCtrlAttributePrivateHandle *h;
+
+    if (!handle) return;
+
+    h = (NvCtrlAttributePrivateHandle *) handle;
+
+    NvCtrlInitSubsystems(h, NV_CTRL_ATTRIBUTES_XRANDR_SUBSYSTEM);
+    if (!h->xrandr) return;
+
+    NvCtrlXrandrTrackScreenConfig(h);
+
+} /* NvCtrlXrandrTrackScreenChanges() */
+
+
 /*
  * NvCtrlGetServerVendor() - return the server vendor
  * information string associated with this
@@ -548,12 +617,16 @@ NvCtrlGetDisplayAttribute64(NvCtrlAttributeHandle *handle,
           case NV_CTRL_ATTR_EXT_NV_PRESENT:
             *val = (h->nv) ? True : False; break;
           case NV_CTRL_ATTR_EXT_VM_PRESENT:
+            NvCtrlInitSubsystems(h, NV_CTRL_ATTRIBUTES_XF86VIDMODE_SUBSYSTEM);
             *val = (h->vm) ? True : False; break;
           case NV_CTRL_ATTR_EXT_XV_OVERLAY_PRESENT:
+            NvCtrlInitSubsystems(h, NV_CTRL_ATTRIBUTES_XVIDEO_SUBSYSTEM);
             *val = (h->xv && h->xv->overlay) ? True : False; break;
           case NV_CTRL_ATTR_EXT_XV_TEXTURE_PRESENT:
+            NvCtrlInitSubsystems(h, NV_CTRL_ATTRIBUTES_XVIDEO_SUBSYSTEM);
             *val = (h->xv && h->xv->texture) ? True : False; break;
           case NV_CTRL_ATTR_EXT_XV_BLITTER_PRESENT:
+            NvCtrlInitSubsystems(h, NV_CTRL_ATTRIBUTES_XVIDEO_SUBSYSTEM);
             *val = (h->xv && h->xv->blitter) ? True : False; break;
           default:
             return NvCtrlNoAttribute;
@@ -565,11 +638,23 @@ NvCtrlGetDisplayAttribute64(NvCtrlAttributeHandle *handle,
         ((attr >= NV_CTRL_ATTR_NV_BASE) &&
          (attr <= NV_CTRL_ATTR_NV_LAST_ATTRIBUTE))) {
         if (!h->nv) return NvCtrlMissingExtension;
-        return NvCtrlNvControlGetAttribute(h, display_mask, attr, val);
+        if ((attr <= NV_CTRL_LAST_ATTRIBUTE) &&
+            NvCtrlAttributeCacheLookup(h, display_mask, attr, val, &status)) {
+            return status;
+        }
+        status = NvCtrlNvControlGetAttribute(h, display_mask, attr, val);
+        if (attr <= NV_CTRL_LAST_ATTRIBUTE) {
+            NvCtrlAttributeCacheStore(h, display_mask, attr, *val, status);
+            if (status == NvCtrlSuccess) {
+                NvCtrlAttributeStateStore(h, display_mask, attr, *val);
+            }
+        }
+        return status;
     }
 
     if ((attr >= NV_CTRL_ATTR_XV_BASE) &&
         (attr <= NV_CTRL_ATTR_XV_LAST_ATTRIBUTE)) {
+        NvCtrlInitSubsystems(h, NV_CTRL_ATTRIBUTES_XVIDEO_SUBSYSTEM);
         status = NvCtrlXvGetAttribute(h, attr, &value_32);
         *val = value_32;
         return status;
@@ -577,6 +662,7 @@ NvCtrlGetDisplayAttribute64(NvCtrlAttributeHandle *handle,
 
     if ((attr >= NV_CTRL_ATTR_XRANDR_BASE) &&
         (attr <= NV_CTRL_ATTR_XRANDR_LAST_ATTRIBUTE)) {
+        NvCtrlInitSubsystems(h, NV_CTRL_ATTRIBUTES_XRANDR_SUBSYSTEM);
         status = NvCtrlXrandrGetAttribute(h, attr, &value_32);
         *val = value_32;
         return status;
@@ -606,23 +692,30 @@ NvCtrlSetDisplayAttribute(NvCtrlAttributeHandle *handle,
                           unsigned int display_mask, int attr, int val)
 {
     NvCtrlAttributePrivateHandle *h;
+    ReturnStatus status;
 
     h = (NvCtrlAttributePrivateHandle *) handle;
+
+    NvCtrlAttributeCacheFlushAll();
     
     if ((attr >= 0) && (attr <= NV_CTRL_LAST_ATTRIBUTE)) {
         if (!h->nv) return NvCtrlMissingExtension;
-        return NvCtrlNvControlSetAttribute(h, display_mask, attr, val);
+        status = NvCtrlNvControlSetAttribute(h, display_mask, attr, val);
+        if (status == NvCtrlSuccess) {
+            NvCtrlAttributeStateStore(h, display_mask, attr, val);
+        }
+        return status;
     }
 
     if ((attr >= NV_CTRL_ATTR_XV_BASE) &&
         (attr <= NV_CTRL_ATTR_XV_LAST_ATTRIBUTE)) {
-        
+        NvCtrlInitSubsystems(h, NV_CTRL_ATTRIBUTES_XVIDEO_SUBSYSTEM);
         return NvCtrlXvSetAttribute(h, attr, val);
     }
     
     if ((attr >= NV_CTRL_ATTR_XRANDR_BASE) &&
         (attr <= NV_CTRL_ATTR_XRANDR_LAST_ATTRIBUTE)) {
-        
+        NvCtrlInitSubsystems(h, NV_CTRL_ATTRIBUTES_XRANDR_SUBSYSTEM);
         return NvCtrlXrandrSetAttribute(h, attr, val);
     }
 
@@ -637,13 +730,20 @@ NvCtrlSetDisplayAttributeWithReply(NvCtrlAttributeHandle *handle,
                                    int attr, int val)
 {
     NvCtrlAttributePrivateHandle *h;
+    ReturnStatus status;
     
     h = (NvCtrlAttributePrivateHandle *) handle;
+
+    NvCtrlAttributeCacheFlushAll();
     
     if ((attr >= 0) && (attr <= NV_CTRL_LAST_ATTRIBUTE)) {
         if (!h->nv) return NvCtrlMissingExtension;
-        return NvCtrlNvControlSetAttributeWithReply(h, display_mask,
-                                                    attr, val);
+        status = NvCtrlNvControlSetAttributeWithReply(h, display_mask,
+                                                      attr, val);
+        if (status == NvCtrlSuccess) {
+            NvCtrlAttributeStateStore(h, display_mask, attr, val);
+        }
+        return status;
     }
     
     return NvCtrlNoAttribute;
@@ -660,6 +760,7 @@ NvCtrlGetVoidDisplayAttribute(NvCtrlAttributeHandle *handle,
 
     if ( attr >= NV_CTRL_ATTR_GLX_BASE &&
          attr >= NV_CTRL_ATTR_GLX_LAST_ATTRIBUTE ) {
+        NvCtrlInitSubsystems(h, NV_CTRL_ATTRIBUTES_GLX_SUBSYSTEM);
         if ( !(h->glx) ) return NvCtrlMissingExtension;
         return NvCtrlGlxGetVoidAttribute(h, display_mask, attr, ptr);
     }
@@ -679,14 +780,25 @@ NvCtrlGetValidDisplayAttributeValues(NvCtrlAttributeHandle *handle,
     h = (NvCtrlAttributePrivateHandle *) handle;
     
     if ((attr >= 0) && (attr <= NV_CTRL_LAST_ATTRIBUTE)) {
+        ReturnStatus status;
+
         if (!h->nv) return NvCtrlMissingExtension;
-        return NvCtrlNvControlGetValidAttributeValues(h, display_mask,
-                                                      attr, val);
+        if (NvCtrlValidValuesCacheLookup(h, display_mask, attr, val)) {
+            NvCtrlAttributeStateStorePermissions(h, attr, val->permissions);
+            return NvCtrlSuccess;
+        }
+        status = NvCtrlNvControlGetValidAttributeValues(h, display_mask,
+                                                        attr, val);
+        if (status == NvCtrlSuccess) {
+            NvCtrlValidValuesCacheStore(h, display_mask, attr, val);
+            NvCtrlAttributeStateStorePermissions(h, attr, val->permissions);
+        }
+        return status;
     }
 
     if ((attr >= NV_CTRL_ATTR_XV_BASE) &&
         (attr <= NV_CTRL_ATTR_XV_LAST_ATTRIBUTE)) {
-
+        NvCtrlInitSubsystems(h, NV_CTRL_ATTRIBUTES_XVIDEO_SUBSYSTEM);
         return NvCtrlXvGetValidAttributeValues(h, attr, val);
     }
     
@@ -753,24 +865,28 @@ NvCtrlGetValidStringDisplayAttributeValues(NvCtrlAttributeHandle *handle,
 
     if ((attr >= NV_CTRL_STRING_GLX_BASE) &&
         (attr <= NV_CTRL_STRING_GLX_LAST_ATTRIBUTE)) {
+        NvCtrlInitSubsystems(h, NV_CTRL_ATTRIBUTES_GLX_SUBSYSTEM);
         if (!h->glx) return NvCtrlMissingExtension;
         return GetValidStringDisplayAttributeValuesExtraAttr(val);
     }
 
     if ((attr >= NV_CTRL_STRING_XRANDR_BASE) &&
         (attr <= NV_CTRL_STRING_XRANDR_LAST_ATTRIBUTE)) {
+        NvCtrlInitSubsystems(h, NV_CTRL_ATTRIBUTES_XRANDR_SUBSYSTEM);
         if (!h->xrandr) return NvCtrlMissingExtension;
         return GetValidStringDisplayAttributeValuesExtraAttr(val);
     }
 
     if ((attr >= NV_CTRL_STRING_XF86VIDMODE_BASE) &&
         (attr <= NV_CTRL_STRING_XF86VIDMODE_LAST_ATTRIBUTE)) {
+        NvCtrlInitSubsystems(h, NV_CTRL_ATTRIBUTES_XF86VIDMODE_SUBSYSTEM);
         if (!h->vm) return NvCtrlMissingExtension;
         return GetValidStringDisplayAttributeValuesExtraAttr(val);
     }
 
     if ((attr >= NV_CTRL_STRING_XV_BASE) &&
         (attr <= NV_CTRL_STRING_XV_LAST_ATTRIBUTE)) {
+        NvCtrlInitSubsystems(h, NV_CTRL_ATTRIBUTES_XVIDEO_SUBSYSTEM);
         if (!h->xv) return NvCtrlMissingExtension;
         return GetValidStringDisplayAttributeValuesExtraAttr(val);
     }
@@ -802,24 +918,28 @@ NvCtrlGetStringDisplayAttribute(NvCtrlAttributeHandle *handle,
 
     if ((attr >= NV_CTRL_STRING_GLX_BASE) &&
         (attr <= NV_CTRL_STRING_GLX_LAST_ATTRIBUTE)) {
+        NvCtrlInitSubsystems(h, NV_CTRL_ATTRIBUTES_GLX_SUBSYSTEM);
         if (!h->glx) return NvCtrlMissingExtension;
         return NvCtrlGlxGetStringAttribute(h, display_mask, attr, ptr);
     }
 
     if ((attr >= NV_CTRL_STRING_XRANDR_BASE) &&
         (attr <= NV_CTRL_STRING_XRANDR_LAST_ATTRIBUTE)) {
+        NvCtrlInitSubsystems(h, NV_CTRL_ATTRIBUTES_XRANDR_SUBSYSTEM);
         if (!h->xrandr) return NvCtrlMissingExtension;
         return NvCtrlXrandrGetStringAttribute(h, display_mask, attr, ptr);
     }
 
     if ((attr >= NV_CTRL_STRING_XF86VIDMODE_BASE) &&
         (attr <= NV_CTRL_STRING_XF86VIDMODE_LAST_ATTRIBUTE)) {
+        NvCtrlInitSubsystems(h, NV_CTRL_ATTRIBUTES_XF86VIDMODE_SUBSYSTEM);
         if (!h->vm) return NvCtrlMissingExtension;
         return NvCtrlVidModeGetStringAttribute(h, display_mask, attr, ptr);
     }
 
     if ((attr >= NV_CTRL_STRING_XV_BASE) &&
         (attr <= NV_CTRL_STRING_XV_LAST_ATTRIBUTE)) {
+        NvCtrlInitSubsystems(h, NV_CTRL_ATTRIBUTES_XVIDEO_SUBSYSTEM);
         if (!h->xv) return NvCtrlMissingExtension;
         return NvCtrlXvGetStringAttribute(h, display_mask, attr, ptr);
     }
@@ -838,6 +958,8 @@ NvCtrlSetStringDisplayAttribute(NvCtrlAttributeHandle *handle,
 
     h = (NvCtrlAttributePrivateHandle *) handle;
 
+    NvCtrlAttributeCacheFlushAll();
+
     if ((attr >= 0) && (attr <= NV_CTRL_STRING_LAST_ATTRIBUTE)) {
         if (!h->nv) return NvCtrlMissingExtension;
         return NvCtrlNvControlSetStringAttribute(h, display_mask, attr,
@@ -871,6 +993,8 @@ NvCtrlStringOperation(NvCtrlAttributeHandle *handle,
     NvCtrlAttributePrivateHandle *h;
     
     h = (NvCtrlAttributePrivateHandle *) handle;
+
+    NvCtrlAttributeCacheFlushAll();
     
     if ((attr >= 0) && (attr <= NV_CTRL_STRING_OPERATION_LAST_ATTRIBUTE)) {
         if (!h->nv) return NvCtrlMissingExtension;
@@ -883,6 +1007,138 @@ NvCtrlStringOperation(NvCtrlAttributeHandle *handle,
 } /* NvCtrlStringOperation() */
 
 
+/*
+ * NvCtrlBatchQueryIsNvControl() - return whether the given batch
+ * entry is answered by the NV-CONTROL extension, and can therefore be
+ * sent as part of an NV-CONTROL batch.
+ */
+
+static Bool NvCtrlBatchQueryIsNvControl(const NvCtrlBatchQuery *q)
+{
+    NvCtrlAttributePrivateHandle *h;
+
+    h = (NvCtrlAttributePrivateHandle *) q->handle;
+
+    if (!h->nv || q->attr < 0) return False;
+
+    switch (q->query_type) {
+    case NV_CTRL_BATCH_GET_ATTRIBUTE:
+    case NV_CTRL_BATCH_GET_VALID_VALUES:
+        return (q->attr <= NV_CTRL_LAST_ATTRIBUTE);
+    case NV_CTRL_BATCH_GET_STRING_ATTRIBUTE:
+        return (q->attr <= NV_CTRL_STRING_LAST_ATTRIBUTE);
+    case NV_CTRL_BATCH_SET_ATTRIBUTE:
+        /* only X screens can report the status of an assignment */
+        return (q->attr <= NV_CTRL_LAST_ATTRIBUTE) &&
+            (h->target_type == NV_CTRL_TARGET_TYPE_X_SCREEN);
+    default:
+        return False;
+    }
+
+} /* NvCtrlBatchQueryIsNvControl() */
+
+
+ReturnStatus NvCtrlQueryBatch(NvCtrlBatchQuery *queries, int count)
+{
+    NvCtrlAttributePrivateHandle *h;
+    NvCtrlBatchQuery **nv_queries;
+    Display *dpy = NULL;
+    ReturnStatus status;
+    int i, n = 0;
+
+    if (!queries || count <= 0) return NvCtrlBadArgument;
+
+    /* all the handles must share one connection */
+
+    for (i = 0; i < count; i++) {
+        h = (NvCtrlAttributePrivateHandle *) queries[i].handle;
+        if (!h) return NvCtrlBadHandle;
+        if (!dpy) {
+            dpy = h->dpy;
+        } else if (h->dpy != dpy) {
+            return NvCtrlBadArgument;
+        }
+    }
+
+    nv_queries = malloc(count * sizeof(NvCtrlBatchQuery *));
+    if (!nv_queries) return NvCtrlError;
+
+    for (i = 0; i < count; i++) {
+        NvCtrlBatchQuery *q = &queries[i];
+
+        if (q->query_type == NV_CTRL_BATCH_SET_ATTRIBUTE) {
+            NvCtrlAttributeCacheFlushAll();
+        } else {
+            q->value = 0;
+        }
+        q->string = NULL;
+
+        if (NvCtrlBatchQueryIsNvControl(q)) {
+            nv_queries[n++] = q;
+            continue;
+        }
+
+        switch (q->query_type) {
+        case NV_CTRL_BATCH_GET_ATTRIBUTE:
+            q->status = NvCtrlGetDisplayAttribute64(q->handle,
+                                                    q->display_mask,
+                                                    q->attr, &q->value);
+            break;
+        case NV_CTRL_BATCH_GET_VALID_VALUES:
+            q->status = NvCtrlGetValidDisplayAttributeValues(q->handle,
+                                                             q->display_mask,
+                                                             q->attr,
+                                                             &q->valid_values);
+            break;
+        case NV_CTRL_BATCH_GET_STRING_ATTRIBUTE:
+            q->status = NvCtrlGetStringDisplayAttribute(q->handle,
+                                                        q->display_mask,
+                                                        q->attr, &q->string);
+            break;
+        case NV_CTRL_BATCH_SET_ATTRIBUTE:
+            q->status = NvCtrlSetDisplayAttribute(q->handle, q->display_mask,
+                                                  q->attr, q->value);
+            break;
+        default:
+            q->status = NvCtrlBadArgument;
+            break;
+        }
+    }
+
+    status = NvCtrlNvControlQueryBatch(dpy, nv_queries, n);
+
+    /*
+     * record the values and permissions read, and the values
+     * assigned, through the NV-CONTROL batch
+     */
+
+    for (i = 0; i < n; i++) {
+        NvCtrlBatchQuery *q = nv_queries[i];
+
+        if (q->status != NvCtrlSuccess) continue;
+
+        switch (q->query_type) {
+        case NV_CTRL_BATCH_GET_ATTRIBUTE:
+        case NV_CTRL_BATCH_SET_ATTRIBUTE:
+            NvCtrlAttributeStateStore(q->handle, q->display_mask,
+                                      q->attr, q->value);
+            break;
+        case NV_CTRL_BATCH_GET_VALID_VALUES:
+            NvCtrlAttributeStateStorePermissions
+                (q->handle, q->attr, q->valid_values.permissions);
+            break;
+        default:
+            break;
+        }
+    }
+
+    free(nv_queries);
+
+    return status;
+
+} /* NvCtrlQueryBatch() */
+
+
 char *NvCtrlAttributesStrError(ReturnStatus status)
 {
     switch (status) {
@@ -931,6 +1187,20 @@ void NvCtrlAttributeClose(NvCtrlAttributeHandle *handle)
     if ( h->xv ) {
         NvCtrlXvAttributesClose(h);
     }
+    if ( h->cache ) {
+        unsigned long hits, misses;
+
+        NvCtrlAttributeCacheGetStats(handle, &hits, &misses);
+        if (hits || misses) {
+            nv_info_msg(NULL, "Attribute cache for target %d of type %d: "
+                        "%lu hits, %lu misses.", h->target_id,
+                        h->target_type, hits, misses);
+        }
+        NvCtrlAttributeCacheClose(h);
+    }
+    NvCtrlAttributeStateClose(h);
+
+    NvCtrlValidValuesCacheRelease(h);
 
     free(h);
 } /* NvCtrlAttributeClose() */
@@ -940,6 +1210,10 @@ ReturnStatus
 NvCtrlXrandrSetScreenMode (NvCtrlAttributeHandle *handle,
                            int width, int height, int refresh)
 {
+    NvCtrlInitSubsystems((NvCtrlAttributePrivateHandle *)handle,
+                         NV_CTRL_ATTRIBUTES_XRANDR_SUBSYSTEM);
+    NvCtrlAttributeCacheFlushAll();
+
     return NvCtrlXrandrSetScreenMagicMode
         ((NvCtrlAttributePrivateHandle *)handle, width, height, refresh);
 } /* NvCtrlXrandrSetScreenMode() */
@@ -949,6 +1223,8 @@ ReturnStatus
 NvCtrlXrandrGetScreenMode (NvCtrlAttributeHandle *handle,
                            int *width, int *height, int *refresh)
 {
+    NvCtrlInitSubsystems((NvCtrlAttributePrivateHandle *)handle,
+                         NV_CTRL_ATTRIBUTES_XRANDR_SUBSYSTEM);
     return NvCtrlXrandrGetScreenMagicMode
         ((NvCtrlAttributePrivateHandle *)handle, width, height, refresh);
 } /* NvCtrlXrandrGetScreenMode() */
@@ -214,6 +214,80 @@ typedef struct GLXFBConfigAttrRec {
 } GLXFBConfigAttr;
 
 
+/*
+ * Columnar GLX FBConfig table, as returned by
+ * NvCtrlGlxGetFBConfigTable(): the value of column 'c' (one of the
+ * NV_CTRL_GLX_FBCONFIG_* #defines below, which follow the fields of
+ * GLXFBConfigAttr) for fbconfig 'i' is columns[c][i].
+ */
+
+#define NV_CTRL_GLX_FBCONFIG_FBCONFIG_ID                  0
+#define NV_CTRL_GLX_FBCONFIG_VISUAL_ID                    1
+#define NV_CTRL_GLX_FBCONFIG_BUFFER_SIZE                  2
+#define NV_CTRL_GLX_FBCONFIG_LEVEL                        3
+#define NV_CTRL_GLX_FBCONFIG_DOUBLEBUFFER                 4
+#define NV_CTRL_GLX_FBCONFIG_STEREO                       5
+#define NV_CTRL_GLX_FBCONFIG_AUX_BUFFERS                  6
+#define NV_CTRL_GLX_FBCONFIG_RED_SIZE                     7
+#define NV_CTRL_GLX_FBCONFIG_GREEN_SIZE                   8
+#define NV_CTRL_GLX_FBCONFIG_BLUE_SIZE                    9
+#define NV_CTRL_GLX_FBCONFIG_ALPHA_SIZE                  10
+#define NV_CTRL_GLX_FBCONFIG_DEPTH_SIZE                  11
+#define NV_CTRL_GLX_FBCONFIG_STENCIL_SIZE                12
+#define NV_CTRL_GLX_FBCONFIG_ACCUM_RED_SIZE              13
+#define NV_CTRL_GLX_FBCONFIG_ACCUM_GREEN_SIZE            14
+#define NV_CTRL_GLX_FBCONFIG_ACCUM_BLUE_SIZE             15
+#define NV_CTRL_GLX_FBCONFIG_ACCUM_ALPHA_SIZE            16
+#define NV_CTRL_GLX_FBCONFIG_RENDER_TYPE                 17
+#define NV_CTRL_GLX_FBCONFIG_DRAWABLE_TYPE               18
+#define NV_CTRL_GLX_FBCONFIG_X_RENDERABLE                19
+#define NV_CTRL_GLX_FBCONFIG_X_VISUAL_TYPE               20
+#define NV_CTRL_GLX_FBCONFIG_CONFIG_CAVEAT               21
+#define NV_CTRL_GLX_FBCONFIG_TRANSPARENT_TYPE            22
+#define NV_CTRL_GLX_FBCONFIG_TRANSPARENT_INDEX_VALUE     23
+#define NV_CTRL_GLX_FBCONFIG_TRANSPARENT_RED_VALUE       24
+#define NV_CTRL_GLX_FBCONFIG_TRANSPARENT_GREEN_VALUE     25
+#define NV_CTRL_GLX_FBCONFIG_TRANSPARENT_BLUE_VALUE      26
+#define NV_CTRL_GLX_FBCONFIG_TRANSPARENT_ALPHA_VALUE     27
+#define NV_CTRL_GLX_FBCONFIG_PBUFFER_WIDTH               28
+#define NV_CTRL_GLX_FBCONFIG_PBUFFER_HEIGHT              29
+#define NV_CTRL_GLX_FBCONFIG_PBUFFER_MAX                 30
+#define NV_CTRL_GLX_FBCONFIG_MULTI_SAMPLE_VALID          31
+#define NV_CTRL_GLX_FBCONFIG_MULTI_SAMPLES               32
+#define NV_CTRL_GLX_FBCONFIG_MULTI_SAMPLE_BUFFERS        33
+#define NV_CTRL_GLX_FBCONFIG_MULTI_SAMPLE_COVERAGE_VALID 34
+#define NV_CTRL_GLX_FBCONFIG_MULTI_SAMPLES_COLOR         35
+
+#define NV_CTRL_GLX_FBCONFIG_NUM_COLUMNS                 36
+
+typedef struct NvCtrlGlxFBConfigTableRec {
+    int num_fbconfigs;
+    int *columns[NV_CTRL_GLX_FBCONFIG_NUM_COLUMNS];
+} NvCtrlGlxFBConfigTable;
+
+
+/*
+ * Filter for NvCtrlGlxFilterFBConfigs(): an fbconfig matches if its
+ * value 'v' in 'column' satisfies:
+ *
+ *   NV_CTRL_GLX_FBCONFIG_FILTER_EQUAL:    v == value
+ *   NV_CTRL_GLX_FBCONFIG_FILTER_AT_LEAST: v >= value
+ *   NV_CTRL_GLX_FBCONFIG_FILTER_AT_MOST:  v <= value
+ *   NV_CTRL_GLX_FBCONFIG_FILTER_HAS_BITS: (v & value) == value
+ */
+
+#define NV_CTRL_GLX_FBCONFIG_FILTER_EQUAL     0
+#define NV_CTRL_GLX_FBCONFIG_FILTER_AT_LEAST  1
+#define NV_CTRL_GLX_FBCONFIG_FILTER_AT_MOST   2
+#define NV_CTRL_GLX_FBCONFIG_FILTER_HAS_BITS  3
+
+typedef struct NvCtrlGlxFBConfigFilterRec {
+    int column;
+    int op;
+    int value;
+} NvCtrlGlxFBConfigFilter;
+
+
 /*
  * Additional NV-CONTROL string attributes for NvCtrlGetStringDisplayAttribute();
  * these are in addition to the ones in NVCtrl.h
@@ -253,6 +327,9 @@ typedef struct GLXFBConfigAttrRec {
 #define NV_CTRL_STRING_GLX_LAST_ATTRIBUTE \
        (NV_CTRL_STRING_GLX_OPENGL_EXTENSIONS)
 
+#define NV_CTRL_STRING_GLX_NUM \
+       (NV_CTRL_STRING_GLX_LAST_ATTRIBUTE - NV_CTRL_STRING_GLX_BASE + 1)
+
 /*
  * Additional XRANDR string attributes for NvCtrlGetStringDisplayAttribute();
  */
@@ -292,6 +369,10 @@ typedef struct GLXFBConfigAttrRec {
  * initial state of attributes, etc.  Takes a Display pointer and
  * screen number, and returns an opaque handle on success; returns
  * NULL if the backend cannot use this screen.
+ *
+ * Only the NV-CONTROL subsystem is initialized here; the other
+ * requested subsystems are initialized the first time one of their
+ * attributes is used.
  */
 
 
@@ -323,6 +404,8 @@ int NvCtrlGetScreenWidth(NvCtrlAttributeHandle *handle);
 int NvCtrlGetScreenHeight(NvCtrlAttributeHandle *handle);
 int NvCtrlGetEventBase(NvCtrlAttributeHandle *handle);
 int NvCtrlGetXrandrEventBase(NvCtrlAttributeHandle *handle);
+void NvCtrlXrandrScreenChanged(NvCtrlAttributeHandle *handle);
+void NvCtrlXrandrTrackScreenChanges(NvCtrlAttributeHandle *handle);
 char *NvCtrlGetServerVendor(NvCtrlAttributeHandle *handle);
 int NvCtrlGetVendorRelease(NvCtrlAttributeHandle *handle);
 int NvCtrlGetProtocolVersion(NvCtrlAttributeHandle *handle);
@@ -486,6 +569,141 @@ NvCtrlStringOperation(NvCtrlAttributeHandle *handle,
                       unsigned int display_mask, int attr,
                       char *ptrIn, char **ptrOut);
 
+/*
+ * NvCtrlQueryBatch() - perform several queries at once.  Each entry
+ * names the handle (target) and display mask to query, the attribute,
+ * and which kind of query to make:
+ *
+ *   NV_CTRL_BATCH_GET_ATTRIBUTE: as NvCtrlGetDisplayAttribute64();
+ *     the result is returned in 'value'.
+ *
+ *   NV_CTRL_BATCH_GET_VALID_VALUES: as
+ *     NvCtrlGetValidDisplayAttributeValues(); the result is returned
+ *     in 'valid_values'.
+ *
+ *   NV_CTRL_BATCH_GET_STRING_ATTRIBUTE: as
+ *     NvCtrlGetStringDisplayAttribute(); the result is returned in
+ *     'string', which the caller should free().
+ *
+ *   NV_CTRL_BATCH_SET_ATTRIBUTE: as
+ *     NvCtrlSetDisplayAttributeWithReply(), assigning 'value'; the
+ *     server's status is returned in 'status'.  On targets other than
+ *     X screens, which cannot report a status, the attribute is
+ *     assigned as by NvCtrlSetDisplayAttribute().
+ *
+ * NV-CONTROL queries are sent to the server back to back and their
+ * replies collected together, so the whole batch costs one round
+ * trip; any other queries are answered one at a time, exactly as by
+ * the single-query functions above.  Entries are processed in order
+ * within each of those two groups.  All handles in the batch must
+ * share the same Display connection.  The per-entry 'status' holds the
+ * result of each query; the return value is NvCtrlSuccess unless the
+ * batch itself could not be processed.
+ */
+
+#define NV_CTRL_BATCH_GET_ATTRIBUTE         0
+#define NV_CTRL_BATCH_GET_VALID_VALUES      1
+#define NV_CTRL_BATCH_GET_STRING_ATTRIBUTE  2
+#define NV_CTRL_BATCH_SET_ATTRIBUTE         3
+
+typedef struct NvCtrlBatchQueryRec {
+    NvCtrlAttributeHandle *handle;
+    int query_type;
+    unsigned int display_mask;
+    int attr;
+
+    /* results */
+    ReturnStatus status;
+    int64_t value;
+    NVCTRLAttributeValidValuesRec valid_values;
+    char *string;
+} NvCtrlBatchQuery;
+
+ReturnStatus
+NvCtrlQueryBatch(NvCtrlBatchQuery *queries, int count);
+
+/*
+ * NvCtrlAttributeCacheEnable() - enable (or disable and flush) the
+ * client-side cache of NV-CONTROL integer attribute values for the
+ * given handle.  While enabled, NvCtrlGetDisplayAttribute64() (and the
+ * functions built on it) answer repeated queries of the same
+ * (display_mask, attribute) pair without a round trip to the X server.
+ *
+ * The cache is only correct if it is told about changes made by
+ * other clients: the owner of the handle must pass every NV-CONTROL
+ * attribute event received for the handle's target to
+ * NvCtrlAttributeCacheAttributeChanged().  Volatile attributes (e.g.,
+ * temperatures and clock frequencies) expire after a short,
+ * per-attribute time to live; some (e.g., the current scanline) are
+ * never cached.  Any Set request made through this library flushes
+ * the caches of all handles.
+ */
+
+void NvCtrlAttributeCacheEnable(NvCtrlAttributeHandle *handle, Bool enable);
+
+/*
+ * NvCtrlAttributeCacheAttributeChanged() - update the cache of the
+ * given handle for an NV-CONTROL attribute event.  If 'available' is
+ * True, 'value' becomes the cached value of (display_mask, attr);
+ * otherwise the attribute is dropped from the cache.
+ */
+
+void NvCtrlAttributeCacheAttributeChanged(NvCtrlAttributeHandle *handle,
+                                          unsigned int display_mask,
+                                          int attr, int64_t value,
+                                          Bool available);
+
+/*
+ * NvCtrlAttributeCacheInvalidate() - drop all cached values of the
+ * given handle.
+ */
+
+void NvCtrlAttributeCacheInvalidate(NvCtrlAttributeHandle *handle);
+
+/*
+ * NvCtrlAttributeCacheGetStats() - return the number of queries that
+ * the cache of the given handle answered (hits) and that had to be
+ * sent to the server (misses).
+ */
+
+void NvCtrlAttributeCacheGetStats(NvCtrlAttributeHandle *handle,
+                                  unsigned long *hits,
+                                  unsigned long *misses);
+
+/*
+ * NvCtrlAttributeStateEnable() - enable (or disable and free) the
+ * record of the NV-CONTROL integer attribute values seen through the
+ * given handle: values read from or assigned to the server, values
+ * reported by the events passed to
+ * NvCtrlAttributeCacheAttributeChanged(), and the permissions of the
+ * valid values queried.
+ */
+
+void NvCtrlAttributeStateEnable(NvCtrlAttributeHandle *handle, Bool enable);
+
+Bool NvCtrlAttributeStateIsEnabled(NvCtrlAttributeHandle *handle);
+
+/*
+ * NvCtrlAttributeStateLookup() - return, in 'val', the last value seen
+ * for (display_mask, attr) through the given handle, without querying
+ * the server.  A display_mask of 0 returns the last value seen for any
+ * display mask.  Returns False if no value is known.
+ */
+
+Bool NvCtrlAttributeStateLookup(NvCtrlAttributeHandle *handle,
+                                unsigned int display_mask, int attr,
+                                int64_t *val);
+
+/*
+ * NvCtrlAttributeStateLookupPermissions() - return the ATTRIBUTE_TYPE_*
+ * permissions last seen in the valid values of the given attribute.
+ * Returns False if they are not known.
+ */
+
+Bool NvCtrlAttributeStateLookupPermissions(NvCtrlAttributeHandle *handle,
+                                           int attr,
+                                           unsigned int *permissions);
+
 /*
  * NvCtrl[SG]etGvoColorConversion() - get and set the color conversion
  * matrix and offset used in the Graphics to Video Out (GVO)
@@ -505,6 +723,30 @@ NvCtrlGetGvoColorConversion(NvCtrlAttributeHandle *handle,
                             float colorOffset[3],
                             float colorScale[3]);
 
+/*
+ * NvCtrlGlxGetFBConfigTable() - return the GLX FBConfig table of the
+ * X screen, with every column filled in.  The table is built the
+ * first time it is requested, and belongs to the handle: the caller
+ * must not modify or free it.
+ */
+
+ReturnStatus
+NvCtrlGlxGetFBConfigTable(NvCtrlAttributeHandle *handle,
+                          const NvCtrlGlxFBConfigTable **table);
+
+/*
+ * NvCtrlGlxFilterFBConfigs() - return, in 'indices', the indices (in
+ * the table of NvCtrlGlxGetFBConfigTable()) of the fbconfigs of the X
+ * screen that match all of the given filters, in table order, and
+ * their number in 'count'.  Only the columns named by the filters are
+ * read from GLX.  The caller should free() 'indices'.
+ */
+
+ReturnStatus
+NvCtrlGlxFilterFBConfigs(NvCtrlAttributeHandle *handle,
+                         const NvCtrlGlxFBConfigFilter *filters,
+                         int num_filters, int **indices, int *count);
+
 const char *NvCtrlGetMultisampleModeName(int multisample_mode);
 
 char *NvCtrlAttributesStrError (ReturnStatus status);
@@ -0,0 +1,460 @@
+/*
+ * nvidia-settings: A tool for configuring the NVIDIA X driver on Unix
+ * and Linux systems.
+ *
+ * Copyright (C) 2004 NVIDIA Corporation.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of Version 2 of the GNU General Public
+ * License as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See Version 2
+ * of the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the:
+ *
+ *           Free Software Foundation, Inc.
+ *           59 Temple Place - Suite 330
+ *           Boston, MA 02111-1307, USA
+ *
+ */
+
+/*
+ * Client-side cache of NV-CONTROL integer attribute values.
+ *
+ * Each handle has its own cache (a handle always refers to a single
+ * target), keyed on (display_mask, attribute).  The cache is kept
+ * coherent with changes made by other clients through the NV-CONTROL
+ * attribute events, which the owner of the handle passes to
+ * NvCtrlAttributeCacheAttributeChanged().  The X server does not send
+ * those events to the client that made the change, so every Set
+ * request made through NvCtrlAttributes bumps a global generation
+ * count, which invalidates everything cached before it.
+ */
+
+#include "NvCtrlAttributes.h"
+#include "NvCtrlAttributesPrivate.h"
+
+#include <stdlib.h>
+#include <sys/time.h>
+
+
+#define NV_CTRL_ATTRIBUTE_CACHE_BUCKETS 64
+
+/* time to live, in milliseconds, of cached values */
+
+#define TTL_FOREVER   -1
+#define TTL_NEVER      0
+#define TTL_VOLATILE 500
+
+typedef struct __NvCtrlAttributeCacheEntry NvCtrlAttributeCacheEntry;
+
+struct __NvCtrlAttributeCacheEntry {
+    unsigned int display_mask;
+    int attr;
+    int64_t value;
+    ReturnStatus status;
+    unsigned int generation;  /* value of 'cache_generation' when stored */
+    long long expires;        /* expiry time in ms; 0 if never */
+    NvCtrlAttributeCacheEntry *next;
+};
+
+struct __NvCtrlAttributeCache {
+    NvCtrlAttributeCacheEntry *buckets[NV_CTRL_ATTRIBUTE_CACHE_BUCKETS];
+    unsigned long hits;
+    unsigned long misses;
+};
+
+/*
+ * bumped by every set, from any thread (see fanout.h), so only ever
+ * accessed atomically, through get_generation() and
+ * NvCtrlAttributeCacheFlushAll()
+ */
+
+static unsigned int cache_generation = 0;
+
+static unsigned int get_generation(void)
+{
+    return __sync_fetch_and_add(&cache_generation, 0);
+}
+
+
+
+/*
+ * get_ttl() - return the time to live of cached values of the given
+ * attribute.  Attributes that the driver updates continuously, and for
+ * which it does not generate events, are either given a short time to
+ * live or are not cached at all.  That includes every attribute that
+ * the gui polls on a timer, since the gui would otherwise show the
+ * first value it read for the whole session.
+ */
+
+static int get_ttl(int attr)
+{
+    switch (attr) {
+
+    case NV_CTRL_BUS_TYPE:
+    case NV_CTRL_BUS_RATE:
+    case NV_CTRL_GPU_PCIE_GENERATION:
+    case NV_CTRL_GPU_PCIE_MAX_LINK_SPEED:
+    case NV_CTRL_GPU_ECC_CONFIGURATION:
+    case NV_CTRL_GPU_ECC_CONFIGURATION_ENABLED:
+    case NV_CTRL_GPU_ADAPTIVE_CLOCK_STATE:
+    case NV_CTRL_THERMAL_COOLER_CONTROL_TYPE:
+    case NV_CTRL_THERMAL_COOLER_TARGET:
+    case NV_CTRL_FRAMELOCK_SYNC_DELAY:
+    case NV_CTRL_FRAMELOCK_VIDEO_MODE:
+    case NV_CTRL_GVO_SYNC_MODE:
+    case NV_CTRL_GVO_SYNC_SOURCE:
+    case NV_CTRL_VCSC_HIGH_PERF_MODE:
+    case NV_CTRL_GPU_CORE_TEMPERATURE:
+    case NV_CTRL_AMBIENT_TEMPERATURE:
+    case NV_CTRL_THERMAL_SENSOR_READING:
+    case NV_CTRL_THERMAL_COOLER_LEVEL:
+    case NV_CTRL_GPU_CURRENT_CLOCK_FREQS:
+    case NV_CTRL_GPU_CURRENT_PROCESSOR_CLOCK_FREQS:
+    case NV_CTRL_GPU_CURRENT_PERFORMANCE_LEVEL:
+    case NV_CTRL_GPU_CURRENT_PERFORMANCE_MODE:
+    case NV_CTRL_GPU_POWER_SOURCE:
+        return TTL_VOLATILE;
+
+    case NV_CTRL_CURRENT_SCANLINE:
+    case NV_CTRL_GPU_ECC_SINGLE_BIT_ERRORS:
+    case NV_CTRL_GPU_ECC_DOUBLE_BIT_ERRORS:
+    case NV_CTRL_GPU_ECC_AGGREGATE_SINGLE_BIT_ERRORS:
+    case NV_CTRL_GPU_ECC_AGGREGATE_DOUBLE_BIT_ERRORS:
+    case NV_CTRL_FRAMELOCK_STEREO_SYNC:
+    case NV_CTRL_FRAMELOCK_TEST_SIGNAL:
+    case NV_CTRL_GVO_SYNC_LOCK_STATUS:
+    case NV_CTRL_GVO_INPUT_VIDEO_FORMAT_REACQUIRE:
+    case NV_CTRL_3D_VISION_PRO_PAIR_GLASSES:
+    case NV_CTRL_FRAMELOCK_PORT0_STATUS:
+    case NV_CTRL_FRAMELOCK_PORT1_STATUS:
+    case NV_CTRL_FRAMELOCK_HOUSE_STATUS:
+    case NV_CTRL_FRAMELOCK_SYNC_READY:
+    case NV_CTRL_FRAMELOCK_ETHERNET_DETECTED:
+    case NV_CTRL_FRAMELOCK_SYNC_RATE:
+    case NV_CTRL_FRAMELOCK_SYNC_RATE_4:
+    case NV_CTRL_FRAMELOCK_TIMING:
+    case NV_CTRL_GVO_COMPOSITE_SYNC_INPUT_DETECTED:
+    case NV_CTRL_GVO_SDI_SYNC_INPUT_DETECTED:
+    case NV_CTRL_GVIO_DETECTED_VIDEO_FORMAT:
+    case NV_CTRL_GVI_DETECTED_CHANNEL_BITS_PER_COMPONENT:
+    case NV_CTRL_GVI_DETECTED_CHANNEL_COMPONENT_SAMPLING:
+    case NV_CTRL_GVI_DETECTED_CHANNEL_COLOR_SPACE:
+    case NV_CTRL_GVI_DETECTED_CHANNEL_LINK_ID:
+    case NV_CTRL_GVI_DETECTED_CHANNEL_SMPTE352_IDENTIFIER:
+    case NV_CTRL_GVO_LOCK_OWNER:
+    case NV_CTRL_GPU_OPTIMAL_CLOCK_FREQS:
+    case NV_CTRL_GPU_OPTIMAL_CLOCK_FREQS_DETECTION_STATE:
+    case NV_CTRL_3D_VISION_PRO_GLASSES_MISSED_SYNC_CYCLES:
+    case NV_CTRL_3D_VISION_PRO_GLASSES_BATTERY_LEVEL:
+        return TTL_NEVER;
+
+    default:
+        return TTL_FOREVER;
+    }
+
+} /* get_ttl() */
+
+
+
+/*
+ * get_time_ms() - return the current time in milliseconds.
+ */
+
+static long long get_time_ms(void)
+{
+    struct timeval tv;
+
+    gettimeofday(&tv, NULL);
+
+    return ((long long) tv.tv_sec * 1000) + (tv.tv_usec / 1000);
+
+} /* get_time_ms() */
+
+
+
+static unsigned int hash(unsigned int display_mask, int attr)
+{
+    return ((unsigned int) attr * 31 + display_mask) %
+        NV_CTRL_ATTRIBUTE_CACHE_BUCKETS;
+}
+
+
+
+/*
+ * find_entry() - return the pointer that links in the entry for
+ * (display_mask, attr), or the pointer at the end of its bucket if
+ * there is no such entry.
+ */
+
+static NvCtrlAttributeCacheEntry **find_entry(NvCtrlAttributeCache *cache,
+                                              unsigned int display_mask,
+                                              int attr)
+{
+    NvCtrlAttributeCacheEntry **e;
+
+    e = &cache->buckets[hash(display_mask, attr)];
+
+    while (*e) {
+        if ((*e)->display_mask == display_mask && (*e)->attr == attr) {
+            break;
+        }
+        e = &(*e)->next;
+    }
+
+    return e;
+
+} /* find_entry() */
+
+
+
+/*
+ * remove_attribute() - drop the entries of the given attribute for all
+ * display masks.
+ */
+
+static void remove_attribute(NvCtrlAttributeCache *cache, int attr)
+{
+    NvCtrlAttributeCacheEntry **e, *tmp;
+    int i;
+
+    for (i = 0; i < NV_CTRL_ATTRIBUTE_CACHE_BUCKETS; i++) {
+        e = &cache->buckets[i];
+        while (*e) {
+            if ((*e)->attr == attr) {
+                tmp = *e;
+                *e = tmp->next;
+                free(tmp);
+            } else {
+                e = &(*e)->next;
+            }
+        }
+    }
+
+} /* remove_attribute() */
+
+
+
+static void flush_cache(NvCtrlAttributeCache *cache)
+{
+    NvCtrlAttributeCacheEntry *e, *tmp;
+    int i;
+
+    for (i = 0; i < NV_CTRL_ATTRIBUTE_CACHE_BUCKETS; i++) {
+        e = cache->buckets[i];
+        while (e) {
+            tmp = e->next;
+            free(e);
+            e = tmp;
+        }
+        cache->buckets[i] = NULL;
+    }
+
+} /* flush_cache() */
+
+
+
+/*
+ * store_entry() - add or replace the cached value of
+ * (display_mask, attr).
+ */
+
+static void store_entry(NvCtrlAttributeCache *cache,
+                        unsigned int display_mask, int attr,
+                        int64_t value, ReturnStatus status)
+{
+    NvCtrlAttributeCacheEntry **e;
+    int ttl = get_ttl(attr);
+
+    if (ttl == TTL_NEVER) return;
+
+    e = find_entry(cache, display_mask, attr);
+
+    if (!*e) {
+        *e = calloc(1, sizeof(NvCtrlAttributeCacheEntry));
+        if (!*e) return;
+        (*e)->display_mask = display_mask;
+        (*e)->attr = attr;
+    }
+
+    (*e)->value = value;
+    (*e)->status = status;
+    (*e)->generation = get_generation();
+    (*e)->expires = (ttl == TTL_FOREVER) ? 0 : (get_time_ms() + ttl);
+
+} /* store_entry() */
+
+
+
+/*
+ * NvCtrlAttributeCacheLookup() - if the handle has a valid cached
+ * value for (display_mask, attr), return it in 'val' and 'status' and
+ * return True; otherwise, return False, in which case the caller
+ * should query the server and pass the result to
+ * NvCtrlAttributeCacheStore().
+ */
+
+Bool NvCtrlAttributeCacheLookup(NvCtrlAttributePrivateHandle *h,
+                                unsigned int display_mask, int attr,
+                                int64_t *val, ReturnStatus *status)
+{
+    NvCtrlAttributeCache *cache = h->cache;
+    NvCtrlAttributeCacheEntry **e, *tmp;
+
+    if (!cache) return False;
+
+    e = find_entry(cache, display_mask, attr);
+
+    if (*e) {
+        if (((*e)->generation == get_generation()) &&
+            (((*e)->expires == 0) || ((*e)->expires > get_time_ms()))) {
+            *val = (*e)->value;
+            *status = (*e)->status;
+            cache->hits++;
+            return True;
+        }
+
+        /* stale; drop it */
+
+        tmp = *e;
+        *e = tmp->next;
+        free(tmp);
+    }
+
+    cache->misses++;
+
+    return False;
+
+} /* NvCtrlAttributeCacheLookup() */
+
+
+
+/*
+ * NvCtrlAttributeCacheStore() - record the result of querying
+ * (display_mask, attr) from the server.  Only answers from the server
+ * (the value, or the attribute not being available) are cached.
+ */
+
+void NvCtrlAttributeCacheStore(NvCtrlAttributePrivateHandle *h,
+                               unsigned int display_mask, int attr,
+                               int64_t val, ReturnStatus status)
+{
+    if (!h->cache) return;
+
+    if ((status != NvCtrlSuccess) &&
+        (status != NvCtrlAttributeNotAvailable)) {
+        return;
+    }
+
+    store_entry(h->cache, display_mask, attr, val, status);
+
+} /* NvCtrlAttributeCacheStore() */
+
+
+
+/*
+ * NvCtrlAttributeCacheFlushAll() - invalidate the caches of all
+ * handles; called whenever this client changes anything on the
+ * server.
+ */
+
+void NvCtrlAttributeCacheFlushAll(void)
+{
+    __sync_fetch_and_add(&cache_generation, 1);
+
+} /* NvCtrlAttributeCacheFlushAll() */
+
+
+
+void NvCtrlAttributeCacheClose(NvCtrlAttributePrivateHandle *h)
+{
+    if (!h->cache) return;
+
+    flush_cache(h->cache);
+    free(h->cache);
+    h->cache = NULL;
+
+} /* NvCtrlAttributeCacheClose() */
+
+
+
+void NvCtrlAttributeCacheEnable(NvCtrlAttributeHandle *handle, Bool enable)
+{
+    NvCtrlAttributePrivateHandle *h = (NvCtrlAttributePrivateHandle *) handle;
+
+    if (!h) return;
+
+    if (!enable) {
+        NvCtrlAttributeCacheClose(h);
+        return;
+    }
+
+    if (!h->cache) {
+        h->cache = calloc(1, sizeof(NvCtrlAttributeCache));
+    }
+
+} /* NvCtrlAttributeCacheEnable() */
+
+
+
+void NvCtrlAttributeCacheAttributeChanged(NvCtrlAttributeHandle *handle,
+                                          unsigned int display_mask,
+                                          int attr, int64_t value,
+                                          Bool available)
+{
+    NvCtrlAttributePrivateHandle *h = (NvCtrlAttributePrivateHandle *) handle;
+
+    if (!h) return;
+
+    if (available) {
+        NvCtrlAttributeStateStore(h, display_mask, attr, value);
+    } else {
+        NvCtrlAttributeStateRemove(h, attr);
+        NvCtrlValidValuesCacheDrop(h, attr);
+    }
+
+    if (!h->cache) return;
+
+    /*
+     * A change for one display mask may be visible through others
+     * (e.g., a query with a display mask of 0), so drop the attribute
+     * entirely before recording the new value.
+     */
+
+    remove_attribute(h->cache, attr);
+
+    if (available) {
+        store_entry(h->cache, display_mask, attr, value, NvCtrlSuccess);
+    }
+
+} /* NvCtrlAttributeCacheAttributeChanged() */
+
+
+
+void NvCtrlAttributeCacheInvalidate(NvCtrlAttributeHandle *handle)
+{
+    NvCtrlAttributePrivateHandle *h = (NvCtrlAttributePrivateHandle *) handle;
+
+    if (!h || !h->cache) return;
+
+    flush_cache(h->cache);
+
+} /* NvCtrlAttributeCacheInvalidate() */
+
+
+
+void NvCtrlAttributeCacheGetStats(NvCtrlAttributeHandle *handle,
+                                  unsigned long *hits,
+                                  unsigned long *misses)
+{
+    NvCtrlAttributePrivateHandle *h = (NvCtrlAttributePrivateHandle *) handle;
+
+    if (hits) *hits = (h && h->cache) ? h->cache->hits : 0;
+    if (misses) *misses = (h && h->cache) ? h->cache->misses : 0;
+
+} /* NvCtrlAttributeCacheGetStats() */
@@ -36,6 +36,7 @@
 #include <stdlib.h>
 #include <string.h>
 #include <stdio.h>
+#include <stddef.h>
 #include <assert.h>
 
 #include <sys/utsname.h>
@@ -304,6 +305,29 @@ NvCtrlInitGlxAttributes (NvCtrlAttributePrivateHandle *h)
 
 
 
+/*
+ * The GLX fbconfigs of an X screen, and the columnar table of their
+ * attributes; see get_fbconfigs().
+ */
+
+struct __NvCtrlGlxFBConfigs {
+    NvCtrlGlxFBConfigTable table;
+    GLXFBConfig *fbconfigs;
+    Bool filled[NV_CTRL_GLX_FBCONFIG_NUM_COLUMNS];
+};
+
+static void free_fbconfigs(NvCtrlGlxFBConfigs *fb)
+{
+    if ( fb->fbconfigs ) {
+        XFree(fb->fbconfigs);
+    }
+    free(fb->table.columns[0]);
+    free(fb);
+
+} /* free_fbconfigs() */
+
+
+
 /******************************************************************************
  *
  * NvCtrlGlxAttributesClose()
@@ -316,9 +340,24 @@ NvCtrlInitGlxAttributes (NvCtrlAttributePrivateHandle *h)
 void
 NvCtrlGlxAttributesClose (NvCtrlAttributePrivateHandle *h)
 {
+    int i;
+
     if ( !h || !h->glx ) {
         return;
     }
+
+    if ( h->glx_strings ) {
+        for ( i = 0; i < NV_CTRL_STRING_GLX_NUM; i++ ) {
+            free(h->glx_strings[i]);
+        }
+        free(h->glx_strings);
+        h->glx_strings = NULL;
+    }
+
+    if ( h->glx_fbconfigs ) {
+        free_fbconfigs(h->glx_fbconfigs);
+        h->glx_fbconfigs = NULL;
+    }
  
     close_libgl();
 
@@ -328,244 +367,470 @@ NvCtrlGlxAttributesClose (NvCtrlAttributePrivateHandle *h)
 
 
 
+#ifdef GLX_VERSION_1_3
+
+/*
+ * The GLX attribute read into each column with glXGetFBConfigAttrib()
+ * (0 for the columns filled in some other way), and the offset of the
+ * corresponding field in GLXFBConfigAttr.
+ */
+
+#define FBCONFIG_COLUMN(col, glx, field) \
+    [NV_CTRL_GLX_FBCONFIG_##col] = { glx, offsetof(GLXFBConfigAttr, field) }
+
+static const struct {
+    int glx_attrib;
+    size_t offset;
+} fbconfig_columns[NV_CTRL_GLX_FBCONFIG_NUM_COLUMNS] = {
+    FBCONFIG_COLUMN(FBCONFIG_ID, GLX_FBCONFIG_ID, fbconfig_id),
+    FBCONFIG_COLUMN(VISUAL_ID, 0, visual_id),
+    FBCONFIG_COLUMN(BUFFER_SIZE, GLX_BUFFER_SIZE, buffer_size),
+    FBCONFIG_COLUMN(LEVEL, GLX_LEVEL, level),
+    FBCONFIG_COLUMN(DOUBLEBUFFER, GLX_DOUBLEBUFFER, doublebuffer),
+    FBCONFIG_COLUMN(STEREO, GLX_STEREO, stereo),
+    FBCONFIG_COLUMN(AUX_BUFFERS, GLX_AUX_BUFFERS, aux_buffers),
+    FBCONFIG_COLUMN(RED_SIZE, GLX_RED_SIZE, red_size),
+    FBCONFIG_COLUMN(GREEN_SIZE, GLX_GREEN_SIZE, green_size),
+    FBCONFIG_COLUMN(BLUE_SIZE, GLX_BLUE_SIZE, blue_size),
+    FBCONFIG_COLUMN(ALPHA_SIZE, GLX_ALPHA_SIZE, alpha_size),
+    FBCONFIG_COLUMN(DEPTH_SIZE, GLX_DEPTH_SIZE, depth_size),
+    FBCONFIG_COLUMN(STENCIL_SIZE, GLX_STENCIL_SIZE, stencil_size),
+    FBCONFIG_COLUMN(ACCUM_RED_SIZE, GLX_ACCUM_RED_SIZE, accum_red_size),
+    FBCONFIG_COLUMN(ACCUM_GREEN_SIZE, GLX_ACCUM_GREEN_SIZE, accum_green_size),
+    FBCONFIG_COLUMN(ACCUM_BLUE_SIZE, GLX_ACCUM_BLUE_SIZE, accum_blue_size),
+    FBCONFIG_COLUMN(ACCUM_ALPHA_SIZE, GLX_ACCUM_ALPHA_SIZE, accum_alpha_size),
+    FBCONFIG_COLUMN(RENDER_TYPE, GLX_RENDER_TYPE, render_type),
+    FBCONFIG_COLUMN(DRAWABLE_TYPE, GLX_DRAWABLE_TYPE, drawable_type),
+    FBCONFIG_COLUMN(X_RENDERABLE, GLX_X_RENDERABLE, x_renderable),
+    FBCONFIG_COLUMN(X_VISUAL_TYPE, GLX_X_VISUAL_TYPE, x_visual_type),
+    FBCONFIG_COLUMN(CONFIG_CAVEAT, GLX_CONFIG_CAVEAT, config_caveat),
+    FBCONFIG_COLUMN(TRANSPARENT_TYPE, GLX_TRANSPARENT_TYPE,
+                    transparent_type),
+    FBCONFIG_COLUMN(TRANSPARENT_INDEX_VALUE, GLX_TRANSPARENT_INDEX_VALUE,
+                    transparent_index_value),
+    FBCONFIG_COLUMN(TRANSPARENT_RED_VALUE, GLX_TRANSPARENT_RED_VALUE,
+                    transparent_red_value),
+    FBCONFIG_COLUMN(TRANSPARENT_GREEN_VALUE, GLX_TRANSPARENT_GREEN_VALUE,
+                    transparent_green_value),
+    FBCONFIG_COLUMN(TRANSPARENT_BLUE_VALUE, GLX_TRANSPARENT_BLUE_VALUE,
+                    transparent_blue_value),
+    FBCONFIG_COLUMN(TRANSPARENT_ALPHA_VALUE, GLX_TRANSPARENT_ALPHA_VALUE,
+                    transparent_alpha_value),
+    FBCONFIG_COLUMN(PBUFFER_WIDTH, GLX_MAX_PBUFFER_WIDTH, pbuffer_width),
+    FBCONFIG_COLUMN(PBUFFER_HEIGHT, GLX_MAX_PBUFFER_HEIGHT, pbuffer_height),
+    FBCONFIG_COLUMN(PBUFFER_MAX, GLX_MAX_PBUFFER_PIXELS, pbuffer_max),
+    FBCONFIG_COLUMN(MULTI_SAMPLE_VALID, 0, multi_sample_valid),
+    FBCONFIG_COLUMN(MULTI_SAMPLES, 0, multi_samples),
+    FBCONFIG_COLUMN(MULTI_SAMPLE_BUFFERS, 0, multi_sample_buffers),
+    FBCONFIG_COLUMN(MULTI_SAMPLE_COVERAGE_VALID, 0,
+                    multi_sample_coverage_valid),
+    FBCONFIG_COLUMN(MULTI_SAMPLES_COLOR, 0, multi_samples_color),
+};
+
+#undef FBCONFIG_COLUMN
+
+
+
 /******************************************************************************
  *
- * get_fbconfig_attribs()
- *
+ * get_fbconfigs()
  *
- * Returns an array of GLX Frame Buffer Configuration Attributes for the
- * given Display/Screen.
  *
- * NOTE: A seperate display connection is used to avoid the dependence on
- *       libGL when an XCloseDisplay is issued.   If we did not, calling
- *       XCloseDisplay AFTER the libGL library has been dlclose'ed (after
- *       having made at least one GLX call) would cause a segfault.
+ * Returns the GLX Frame Buffer Configurations of the given Display/Screen,
+ * fetching the list of fbconfigs on first use.  The columnar table of their
+ * attributes is filled in one column at a time, only when a column is
+ * needed (see fill_column()).  The fbconfigs are kept on the handle and
+ * freed by NvCtrlGlxAttributesClose().
  *
  ****/
 
-#ifdef GLX_VERSION_1_3
-
-static GLXFBConfigAttr *
-get_fbconfig_attribs(NvCtrlAttributePrivateHandle *h)
+static NvCtrlGlxFBConfigs *get_fbconfigs(NvCtrlAttributePrivateHandle *h)
 {
-    XVisualInfo     * visinfo;
-
-    GLXFBConfigAttr * fbcas      = NULL;
-    GLXFBConfig     * fbconfigs  = NULL;
-
-    int               nfbconfigs;
-    int               i;   /* Used for indexing */
-    int               ret; /* Return value of glXGetFBConfigAttr */
-
-
+    NvCtrlGlxFBConfigs *fb;
+    int nfbconfigs, col;
+    int *data;
 
     assert(h->target_type == NV_CTRL_TARGET_TYPE_X_SCREEN);
 
+    if ( h->glx_fbconfigs ) {
+        return h->glx_fbconfigs;
+    }
+
+    fb = calloc(1, sizeof(NvCtrlGlxFBConfigs));
+    if ( fb == NULL ) {
+        return NULL;
+    }
 
     /* Get all fbconfigs for the display/screen */
-    fbconfigs = (* (__libGL->glXGetFBConfigs)) (h->dpy, h->target_id,
-                                                &nfbconfigs);
-    if ( fbconfigs == NULL || nfbconfigs == 0 ) {
+    fb->fbconfigs = (* (__libGL->glXGetFBConfigs)) (h->dpy, h->target_id,
+                                                    &nfbconfigs);
+    if ( fb->fbconfigs == NULL || nfbconfigs == 0 ) {
         goto fail;
     }
 
-    /* Allocate to hold the fbconfig attributes */
-    fbcas = calloc(nfbconfigs + 1, sizeof(GLXFBConfigAttr));
-    if ( fbcas == NULL ) {
-        goto fail;        
+    /* Allocate the table, with all columns in one block */
+    data = calloc(nfbconfigs * NV_CTRL_GLX_FBCONFIG_NUM_COLUMNS, sizeof(int));
+    if ( data == NULL ) {
+        goto fail;
+    }
+    fb->table.num_fbconfigs = nfbconfigs;
+    for ( col = 0; col < NV_CTRL_GLX_FBCONFIG_NUM_COLUMNS; col++ ) {
+        fb->table.columns[col] = data + (col * nfbconfigs);
     }
 
-    /* Query each fbconfig's attributes and populate the attrib array */
-    for ( i = 0; i < nfbconfigs; i++ ) {
+    h->glx_fbconfigs = fb;
+    return fb;
 
+ fail:
+    free_fbconfigs(fb);
+    return NULL;
+
+} /* get_fbconfigs() */
+
+
+
+/*
+ * fill_column() - read the values of column 'col' for all fbconfigs, if
+ * not done yet; each pass walks a single contiguous array.  The
+ * multisample columns are read together.  Returns False on failure.
+ */
+
+static Bool fill_column(NvCtrlAttributePrivateHandle *h,
+                        NvCtrlGlxFBConfigs *fb, int col)
+{
+    NvCtrlGlxFBConfigTable *table = &fb->table;
+    XVisualInfo *visinfo;
+    int i, ret;
+
+    if ( fb->filled[col] ) {
+        return True;
+    }
+
+    switch ( col ) {
+
+    case NV_CTRL_GLX_FBCONFIG_VISUAL_ID:
         /* Get related visual id if any */
-        visinfo = (* (__libGL->glXGetVisualFromFBConfig)) (h->dpy,
-                                                           fbconfigs[i]);
-        if ( visinfo ) {
-            fbcas[i].visual_id = visinfo->visualid;
-            XFree(visinfo);
-        } else {
-            fbcas[i].visual_id = 0;           
+        for ( i = 0; i < table->num_fbconfigs; i++ ) {
+            visinfo = (* (__libGL->glXGetVisualFromFBConfig))
+                (h->dpy, fb->fbconfigs[i]);
+            if ( visinfo ) {
+                table->columns[col][i] = visinfo->visualid;
+                XFree(visinfo);
+            }
         }
+        break;
 
-        ret = (* (__libGL->glXGetFBConfigAttrib))(h->dpy,
-                                                  fbconfigs[i],
-                                                  GLX_FBCONFIG_ID,
-                                                  &(fbcas[i].fbconfig_id));
-        if ( ret != Success ) goto fail;
-        ret = (* (__libGL->glXGetFBConfigAttrib))(h->dpy, fbconfigs[i],
-                                                  GLX_BUFFER_SIZE,
-                                                  &(fbcas[i].buffer_size));
-        if ( ret != Success ) goto fail;
-        ret = (* (__libGL->glXGetFBConfigAttrib))(h->dpy, fbconfigs[i],
-                                                  GLX_LEVEL,
-                                                  &(fbcas[i].level));
-        if ( ret != Success ) goto fail;
-        ret = (* (__libGL->glXGetFBConfigAttrib))(h->dpy, fbconfigs[i],
-                                                  GLX_DOUBLEBUFFER,
-                                                  &(fbcas[i].doublebuffer));
-        if ( ret != Success ) goto fail;
-        ret = (* (__libGL->glXGetFBConfigAttrib))(h->dpy, fbconfigs[i],
-                                                  GLX_STEREO,
-                                                  &(fbcas[i].stereo));
-        if ( ret != Success ) goto fail;
-        ret = (* (__libGL->glXGetFBConfigAttrib))(h->dpy, fbconfigs[i],
-                                                  GLX_AUX_BUFFERS,
-                                                  &(fbcas[i].aux_buffers));
-        if ( ret != Success ) goto fail;
-        ret = (* (__libGL->glXGetFBConfigAttrib))(h->dpy, fbconfigs[i],
-                                                  GLX_RED_SIZE,
-                                                  &(fbcas[i].red_size));
-        if ( ret != Success ) goto fail;
-        ret = (* (__libGL->glXGetFBConfigAttrib))(h->dpy, fbconfigs[i],
-                                                  GLX_GREEN_SIZE,
-                                                  &(fbcas[i].green_size));
-        if ( ret != Success ) goto fail;
-        ret = (* (__libGL->glXGetFBConfigAttrib))(h->dpy, fbconfigs[i],
-                                                  GLX_BLUE_SIZE,
-                                                  &(fbcas[i].blue_size));
-        if ( ret != Success ) goto fail;
-        ret = (* (__libGL->glXGetFBConfigAttrib))(h->dpy, fbconfigs[i],
-                                                  GLX_ALPHA_SIZE,
-                                                  &(fbcas[i].alpha_size));
-        if ( ret != Success ) goto fail;
-        ret = (* (__libGL->glXGetFBConfigAttrib))(h->dpy, fbconfigs[i],
-                                                  GLX_DEPTH_SIZE,
-                                                  &(fbcas[i].depth_size));
-        if ( ret != Success ) goto fail;
-        ret = (* (__libGL->glXGetFBConfigAttrib))(h->dpy, fbconfigs[i],
-                                                  GLX_STENCIL_SIZE,
-                                                  &(fbcas[i].stencil_size));
-        if ( ret != Success ) goto fail;
-        ret = (* (__libGL->glXGetFBConfigAttrib))(h->dpy, fbconfigs[i],
-                                                  GLX_ACCUM_RED_SIZE,
-                                                  &(fbcas[i].accum_red_size));
-        if ( ret != Success ) goto fail;
-        ret = (* (__libGL->glXGetFBConfigAttrib))(h->dpy, fbconfigs[i],
-                                                  GLX_ACCUM_GREEN_SIZE,
-                                                  &(fbcas[i].accum_green_size));
-        if ( ret != Success ) goto fail;
-        ret = (* (__libGL->glXGetFBConfigAttrib))(h->dpy, fbconfigs[i],
-                                                  GLX_ACCUM_BLUE_SIZE,
-                                                  &(fbcas[i].accum_blue_size));
-        if ( ret != Success ) goto fail;
-        ret = (* (__libGL->glXGetFBConfigAttrib))(h->dpy, fbconfigs[i],
-                                                  GLX_ACCUM_ALPHA_SIZE,
-                                                  &(fbcas[i].accum_alpha_size));
-        if ( ret != Success ) goto fail;
-        ret = (* (__libGL->glXGetFBConfigAttrib))(h->dpy, fbconfigs[i],
-                                                  GLX_RENDER_TYPE,
-                                                  &(fbcas[i].render_type));
-        if ( ret != Success ) goto fail;
-        ret = (* (__libGL->glXGetFBConfigAttrib))(h->dpy, fbconfigs[i],
-                                                  GLX_DRAWABLE_TYPE,
-                                                  &(fbcas[i].drawable_type));
-        if ( ret != Success ) goto fail;
-        ret = (* (__libGL->glXGetFBConfigAttrib))(h->dpy, fbconfigs[i],
-                                                  GLX_X_RENDERABLE,
-                                                  &(fbcas[i].x_renderable));
-        if ( ret != Success ) goto fail;
-        ret = (* (__libGL->glXGetFBConfigAttrib))(h->dpy, fbconfigs[i],
-                                                  GLX_X_VISUAL_TYPE,
-                                                  &(fbcas[i].x_visual_type));
-        if ( ret != Success ) goto fail;
-        ret = (* (__libGL->glXGetFBConfigAttrib))(h->dpy, fbconfigs[i],
-                                                  GLX_CONFIG_CAVEAT,
-                                                  &(fbcas[i].config_caveat));
-        if ( ret != Success ) goto fail;
-        ret = (* (__libGL->glXGetFBConfigAttrib))(h->dpy, fbconfigs[i],
-                                                  GLX_TRANSPARENT_TYPE,
-                                                  &(fbcas[i].transparent_type));
-        if ( ret != Success ) goto fail;
-        ret = (* (__libGL->glXGetFBConfigAttrib))(h->dpy, fbconfigs[i],
-                                                  GLX_TRANSPARENT_INDEX_VALUE,
-                                                  &(fbcas[i].transparent_index_value));
-        if ( ret != Success ) goto fail;
-        ret = (* (__libGL->glXGetFBConfigAttrib))(h->dpy, fbconfigs[i],
-                                                  GLX_TRANSPARENT_RED_VALUE,
-                                                  &(fbcas[i].transparent_red_value));
-        if ( ret != Success ) goto fail;
-        ret = (* (__libGL->glXGetFBConfigAttrib))(h->dpy, fbconfigs[i],
-                                                  GLX_TRANSPARENT_GREEN_VALUE,
-                                                  &(fbcas[i].transparent_green_value));
-        if ( ret != Success ) goto fail;
-        ret = (* (__libGL->glXGetFBConfigAttrib))(h->dpy, fbconfigs[i],
-                                                  GLX_TRANSPARENT_BLUE_VALUE,
-                                                  &(fbcas[i].transparent_blue_value));
-        if ( ret != Success ) goto fail;
-        ret = (* (__libGL->glXGetFBConfigAttrib))(h->dpy, fbconfigs[i],
-                                                  GLX_TRANSPARENT_ALPHA_VALUE,
-                                                  &(fbcas[i].transparent_alpha_value));
-        if ( ret != Success ) goto fail;
-        ret = (* (__libGL->glXGetFBConfigAttrib))(h->dpy, fbconfigs[i],
-                                                  GLX_MAX_PBUFFER_WIDTH,
-                                                  &(fbcas[i].pbuffer_width));
-        if ( ret != Success ) goto fail;
-        ret = (* (__libGL->glXGetFBConfigAttrib))(h->dpy, fbconfigs[i],
-                                                  GLX_MAX_PBUFFER_HEIGHT,
-                                                  &(fbcas[i].pbuffer_height));
-        if ( ret != Success ) goto fail;
-        ret = (* (__libGL->glXGetFBConfigAttrib))(h->dpy, fbconfigs[i],
-                                                  GLX_MAX_PBUFFER_PIXELS,
-                                                  &(fbcas[i].pbuffer_max));
-        if ( ret != Success ) goto fail;
-
+    case NV_CTRL_GLX_FBCONFIG_MULTI_SAMPLE_VALID:
+    case NV_CTRL_GLX_FBCONFIG_MULTI_SAMPLES:
+    case NV_CTRL_GLX_FBCONFIG_MULTI_SAMPLE_BUFFERS:
 #if defined(GLX_SAMPLES_ARB) && defined (GLX_SAMPLE_BUFFERS_ARB)
-        fbcas[i].multi_sample_valid = 1;
-        ret = (* (__libGL->glXGetFBConfigAttrib))(h->dpy, fbconfigs[i],
-                                                  GLX_SAMPLES_ARB,
-                                                  &(fbcas[i].multi_samples));
-        if ( ret != Success ) {
-            fbcas[i].multi_sample_valid = 0;
-        } else {
-            ret = (* (__libGL->glXGetFBConfigAttrib))(h->dpy,
-                                                      fbconfigs[i],
-                                                      GLX_SAMPLE_BUFFERS_ARB,
-                                                      &(fbcas[i].multi_sample_buffers));
+        for ( i = 0; i < table->num_fbconfigs; i++ ) {
+            int *valid =
+                &table->columns[NV_CTRL_GLX_FBCONFIG_MULTI_SAMPLE_VALID][i];
+
+            *valid = 1;
+            ret = (* (__libGL->glXGetFBConfigAttrib))
+                (h->dpy, fb->fbconfigs[i], GLX_SAMPLES_ARB,
+                 &(table->columns[NV_CTRL_GLX_FBCONFIG_MULTI_SAMPLES][i]));
             if ( ret != Success ) {
-                fbcas[i].multi_sample_valid = 0;
+                *valid = 0;
+            } else {
+                ret = (* (__libGL->glXGetFBConfigAttrib))
+                    (h->dpy, fb->fbconfigs[i], GLX_SAMPLE_BUFFERS_ARB,
+                     &(table->columns[NV_CTRL_GLX_FBCONFIG_MULTI_SAMPLE_BUFFERS][i]));
+                if ( ret != Success ) {
+                    *valid = 0;
+                }
             }
         }
-#if defined(GLX_COLOR_SAMPLES_NV)
-        fbcas[i].multi_sample_coverage_valid = 1;
-        ret = (* (__libGL->glXGetFBConfigAttrib))(h->dpy, fbconfigs[i],
-                                                  GLX_COLOR_SAMPLES_NV,
-                                                  &(fbcas[i].multi_samples_color));
-
-        if ( ret != Success ) {
-            fbcas[i].multi_sample_coverage_valid = 0;
-        }
-#else
-        fbcas[i].multi_sample_coverage_valid = 0;
-#endif
 #else
 #warning Multisample extension not found, will not print multisample information!
-        fbcas[i].multi_sample_valid = 0;
 #endif /* Multisample extension */
+        fb->filled[NV_CTRL_GLX_FBCONFIG_MULTI_SAMPLE_VALID] = True;
+        fb->filled[NV_CTRL_GLX_FBCONFIG_MULTI_SAMPLES] = True;
+        fb->filled[NV_CTRL_GLX_FBCONFIG_MULTI_SAMPLE_BUFFERS] = True;
+        break;
 
-    } /* Done reading fbconfig information */
+    case NV_CTRL_GLX_FBCONFIG_MULTI_SAMPLE_COVERAGE_VALID:
+    case NV_CTRL_GLX_FBCONFIG_MULTI_SAMPLES_COLOR:
+#if defined(GLX_SAMPLES_ARB) && defined (GLX_SAMPLE_BUFFERS_ARB) && \
+    defined(GLX_COLOR_SAMPLES_NV)
+        for ( i = 0; i < table->num_fbconfigs; i++ ) {
+            ret = (* (__libGL->glXGetFBConfigAttrib))
+                (h->dpy, fb->fbconfigs[i], GLX_COLOR_SAMPLES_NV,
+                 &(table->columns[NV_CTRL_GLX_FBCONFIG_MULTI_SAMPLES_COLOR][i]));
+            table->columns[NV_CTRL_GLX_FBCONFIG_MULTI_SAMPLE_COVERAGE_VALID][i] =
+                (ret == Success);
+        }
+#endif
+        fb->filled[NV_CTRL_GLX_FBCONFIG_MULTI_SAMPLE_COVERAGE_VALID] = True;
+        fb->filled[NV_CTRL_GLX_FBCONFIG_MULTI_SAMPLES_COLOR] = True;
+        break;
 
+    default:
+        /* Columns that map directly to a GLX attribute */
+        for ( i = 0; i < table->num_fbconfigs; i++ ) {
+            ret = (* (__libGL->glXGetFBConfigAttrib))
+                (h->dpy, fb->fbconfigs[i], fbconfig_columns[col].glx_attrib,
+                 &(table->columns[col][i]));
+            if ( ret != Success ) {
+                return False;
+            }
+        }
+        break;
+    }
 
-    XFree(fbconfigs);
-    return fbcas;
+    fb->filled[col] = True;
 
+    return True;
 
-    /* Handle failures */
- fail:
-    if ( fbcas ) {
-        free(fbcas);
+} /* fill_column() */
+
+
+
+/*
+ * get_fbconfig_table() - return the columnar fbconfig table, with
+ * every column filled in.
+ */
+
+static const NvCtrlGlxFBConfigTable *
+get_fbconfig_table(NvCtrlAttributePrivateHandle *h)
+{
+    NvCtrlGlxFBConfigs *fb;
+    int col;
+
+    fb = get_fbconfigs(h);
+    if ( !fb ) {
+        return NULL;
+    }
+
+    for ( col = 0; col < NV_CTRL_GLX_FBCONFIG_NUM_COLUMNS; col++ ) {
+        if ( !fill_column(h, fb, col) ) {
+            return NULL;
+        }
     }
-    if ( fbconfigs ) {
-        XFree(fbconfigs);
+
+    return &fb->table;
+
+} /* get_fbconfig_table() */
+
+
+
+/******************************************************************************
+ *
+ * get_fbconfig_attribs()
+ *
+ *
+ * Returns an array of GLX Frame Buffer Configuration Attributes for the
+ * given Display/Screen, terminated by an entry with an fbconfig_id of 0;
+ * the caller should free() it.
+ *
+ ****/
+
+static GLXFBConfigAttr *
+get_fbconfig_attribs(NvCtrlAttributePrivateHandle *h)
+{
+    const NvCtrlGlxFBConfigTable *table;
+    GLXFBConfigAttr *fbcas;
+    int i, col;
+
+    table = get_fbconfig_table(h);
+    if ( !table ) {
+        return NULL;
     }
 
-    return NULL;
+    fbcas = calloc(table->num_fbconfigs + 1, sizeof(GLXFBConfigAttr));
+    if ( fbcas == NULL ) {
+        return NULL;
+    }
+
+    for ( col = 0; col < NV_CTRL_GLX_FBCONFIG_NUM_COLUMNS; col++ ) {
+        for ( i = 0; i < table->num_fbconfigs; i++ ) {
+            *(int *)((char *)&fbcas[i] + fbconfig_columns[col].offset) =
+                table->columns[col][i];
+        }
+    }
+
+    return fbcas;
+
 } /* get_fbconfig_attribs() */
 
 #endif /* GLX_VERSION_1_3 */
 
 
 
+/*
+ * check_glx_handle() - common checks of the NvCtrlGlx*FBConfig*()
+ * entry points; returns NvCtrlSuccess if the handle can be used.
+ */
+
+static ReturnStatus check_glx_handle(NvCtrlAttributePrivateHandle *h)
+{
+    if ( !h || !h->dpy || h->target_type != NV_CTRL_TARGET_TYPE_X_SCREEN ) {
+        return NvCtrlBadHandle;
+    }
+
+    NvCtrlInitSubsystems(h, NV_CTRL_ATTRIBUTES_GLX_SUBSYSTEM);
+    if ( !h->glx || !__libGL ) {
+        return NvCtrlMissingExtension;
+    }
+
+#ifdef GLX_VERSION_1_3
+    return NvCtrlSuccess;
+#else
+    return NvCtrlNoAttribute;
+#endif
+
+} /* check_glx_handle() */
+
+
+
+/******************************************************************************
+ *
+ * NvCtrlGlxGetFBConfigTable()
+ *
+ * Returns the columnar GLX Frame Buffer Configuration table, with all
+ * columns filled in.
+ *
+ ****/
+
+ReturnStatus
+NvCtrlGlxGetFBConfigTable(NvCtrlAttributeHandle *handle,
+                          const NvCtrlGlxFBConfigTable **table)
+{
+    NvCtrlAttributePrivateHandle *h = (NvCtrlAttributePrivateHandle *) handle;
+    ReturnStatus status;
+
+    if ( !table ) {
+        return NvCtrlBadArgument;
+    }
+
+    status = check_glx_handle(h);
+    if ( status != NvCtrlSuccess ) {
+        return status;
+    }
+
+#ifdef GLX_VERSION_1_3
+    *table = get_fbconfig_table(h);
+    if ( *table == NULL ) {
+        return NvCtrlError;
+    }
+#endif
+
+    return NvCtrlSuccess;
+
+} /* NvCtrlGlxGetFBConfigTable() */
+
+
+
+/******************************************************************************
+ *
+ * NvCtrlGlxFilterFBConfigs()
+ *
+ * Selects the fbconfigs that match all of the given filters.  Each filter
+ * reads only its own column, fetching it from GLX if no one has asked for
+ * it yet, and narrows the list of candidates left by the previous ones.
+ *
+ ****/
+
+ReturnStatus
+NvCtrlGlxFilterFBConfigs(NvCtrlAttributeHandle *handle,
+                         const NvCtrlGlxFBConfigFilter *filters,
+                         int num_filters, int **indices, int *count)
+{
+    NvCtrlAttributePrivateHandle *h = (NvCtrlAttributePrivateHandle *) handle;
+    ReturnStatus status;
+
+    if ( !indices || !count || (num_filters && !filters) ) {
+        return NvCtrlBadArgument;
+    }
+
+    *indices = NULL;
+    *count = 0;
+
+    status = check_glx_handle(h);
+    if ( status != NvCtrlSuccess ) {
+        return status;
+    }
+
+#ifdef GLX_VERSION_1_3
+    {
+        NvCtrlGlxFBConfigs *fb;
+        int *idx;
+        int i, f, n;
+
+        for ( f = 0; f < num_filters; f++ ) {
+            if ( filters[f].column < 0 ||
+                 filters[f].column >= NV_CTRL_GLX_FBCONFIG_NUM_COLUMNS ||
+                 filters[f].op < NV_CTRL_GLX_FBCONFIG_FILTER_EQUAL ||
+                 filters[f].op > NV_CTRL_GLX_FBCONFIG_FILTER_HAS_BITS ) {
+                return NvCtrlBadArgument;
+            }
+        }
+
+        fb = get_fbconfigs(h);
+        if ( !fb ) {
+            return NvCtrlError;
+        }
+
+        idx = malloc(fb->table.num_fbconfigs * sizeof(int));
+        if ( !idx ) {
+            return NvCtrlError;
+        }
+
+        for ( i = 0; i < fb->table.num_fbconfigs; i++ ) {
+            idx[i] = i;
+        }
+        n = fb->table.num_fbconfigs;
+
+        for ( f = 0; f < num_filters && n > 0; f++ ) {
+            const int *column;
+            int value = filters[f].value;
+            int matched = 0;
+
+            if ( !fill_column(h, fb, filters[f].column) ) {
+                free(idx);
+                return NvCtrlError;
+            }
+            column = fb->table.columns[filters[f].column];
+
+            for ( i = 0; i < n; i++ ) {
+                int v = column[idx[i]];
+                Bool match = False;
+
+                switch ( filters[f].op ) {
+                case NV_CTRL_GLX_FBCONFIG_FILTER_EQUAL:
+                    match = (v == value);
+                    break;
+                case NV_CTRL_GLX_FBCONFIG_FILTER_AT_LEAST:
+                    match = (v >= value);
+                    break;
+                case NV_CTRL_GLX_FBCONFIG_FILTER_AT_MOST:
+                    match = (v <= value);
+                    break;
+                case NV_CTRL_GLX_FBCONFIG_FILTER_HAS_BITS:
+                    match = ((v & value) == value);
+                    break;
+                }
+
+                if ( match ) {
+                    idx[matched++] = idx[i];
+                }
+            }
+            n = matched;
+        }
+
+        *indices = idx;
+        *count = n;
+    }
+#endif
+
+    return NvCtrlSuccess;
+
+} /* NvCtrlGlxFilterFBConfigs() */
+
+
+
 /******************************************************************************
  *
  * NvCtrlGlxGetVoidAttribute()
@@ -641,20 +906,22 @@ NvCtrlGlxGetVoidAttribute (NvCtrlAttributePrivateHandle *h,
  ****/
 
 /*
- * Helper function for NvCtrlGlxGetStringAttribute for queries that require a
- * current context.  If getDirect is true, then check if we can create a direct
- * GLX context and return "Yes" or "No".  Otherwise, create a context and query
- * the GLX implementation for the string specified in prop.
+ * Helper function for NvCtrlGlxGetStringAttribute: reads every GLX and
+ * OpenGL string into h->glx_strings, indexed by attribute -
+ * NV_CTRL_STRING_GLX_BASE.  The window and context needed for the OpenGL
+ * and 'Direct rendering' strings are created once and used for all of
+ * them.  Strings that could not be retrieved are left NULL.
  */
-static const char *getString(NvCtrlAttributePrivateHandle *h,
-                             Bool getDirect, GLenum prop)
+static Bool snapshot_strings(NvCtrlAttributePrivateHandle *h)
 {
-    const char *str = NULL;
+    char **strs;
+    const char *str;
+    int i;
 
     /* These variables are required for getting some OpenGL/GLX Information */
-    Window win;
+    Window win = None;
     Window root;
-    GLXContext ctx;
+    GLXContext ctx = NULL;
     XVisualInfo *visinfo;
     XSetWindowAttributes win_attr;       /* Used for creating a gc */
     unsigned long mask;
@@ -666,45 +933,93 @@ static const char *getString(NvCtrlAttributePrivateHandle *h,
                                    GLX_GREEN_SIZE, 1,
                                    GLX_BLUE_SIZE, 1,
                                    None };
+
+    static const GLenum gl_strings[] = {
+        GL_VENDOR, GL_RENDERER, GL_VERSION, GL_EXTENSIONS
+    };
+
+    strs = calloc(NV_CTRL_STRING_GLX_NUM, sizeof(char *));
+    if ( !strs ) {
+        return False;
+    }
+
+#define SET_STRING(attr, s)                                       \
+    do {                                                          \
+        const char *__s = (s);                                    \
+        strs[(attr) - NV_CTRL_STRING_GLX_BASE] =                  \
+            __s ? strdup(__s) : NULL;                             \
+    } while (0)
+
+    /* Strings that do not need a context */
+
+    SET_STRING(NV_CTRL_STRING_GLX_GLX_EXTENSIONS,
+               (* (__libGL->glXQueryExtensionsString))(h->dpy, h->target_id));
+    SET_STRING(NV_CTRL_STRING_GLX_SERVER_VENDOR,
+               (* (__libGL->glXQueryServerString))(h->dpy, h->target_id,
+                                                   GLX_VENDOR));
+    SET_STRING(NV_CTRL_STRING_GLX_SERVER_VERSION,
+               (* (__libGL->glXQueryServerString))(h->dpy, h->target_id,
+                                                   GLX_VERSION));
+    SET_STRING(NV_CTRL_STRING_GLX_SERVER_EXTENSIONS,
+               (* (__libGL->glXQueryServerString))(h->dpy, h->target_id,
+                                                   GLX_EXTENSIONS));
+    SET_STRING(NV_CTRL_STRING_GLX_CLIENT_VENDOR,
+               (* (__libGL->glXGetClientString))(h->dpy, GLX_VENDOR));
+    SET_STRING(NV_CTRL_STRING_GLX_CLIENT_VERSION,
+               (* (__libGL->glXGetClientString))(h->dpy, GLX_VERSION));
+    SET_STRING(NV_CTRL_STRING_GLX_CLIENT_EXTENSIONS,
+               (* (__libGL->glXGetClientString))(h->dpy, GLX_EXTENSIONS));
+
+    /* Strings that need a current context; create it once for all of them */
+
     root    = RootWindow(h->dpy, h->target_id);
     visinfo = __libGL->glXChooseVisual(h->dpy, h->target_id,
                                        &(attribListSgl[0]));
-    if (!visinfo) {
-        return NULL;
-    }
-    win_attr.background_pixel = 0;
-    win_attr.border_pixel     = 0;
-    win_attr.colormap         = XCreateColormap(h->dpy, root,
-                                                visinfo->visual, AllocNone);
-    win_attr.event_mask       = 0;
-    mask                      = CWBackPixel | CWBorderPixel | CWColormap |
-                                CWEventMask;
-    win  = XCreateWindow(h->dpy, root, 0, 0, width, height,
-                         0, visinfo->depth, InputOutput,
-                         visinfo->visual, mask, &win_attr);
-    ctx  = __libGL->glXCreateContext(h->dpy, visinfo, NULL, True );
-    if ( ctx ) {
-        __libGL->glXMakeCurrent(h->dpy, win, ctx);
-    }
+    if ( visinfo ) {
+        win_attr.background_pixel = 0;
+        win_attr.border_pixel     = 0;
+        win_attr.colormap         = XCreateColormap(h->dpy, root,
+                                                    visinfo->visual,
+                                                    AllocNone);
+        win_attr.event_mask       = 0;
+        mask                      = CWBackPixel | CWBorderPixel |
+                                    CWColormap | CWEventMask;
+        win  = XCreateWindow(h->dpy, root, 0, 0, width, height,
+                             0, visinfo->depth, InputOutput,
+                             visinfo->visual, mask, &win_attr);
+        ctx  = __libGL->glXCreateContext(h->dpy, visinfo, NULL, True );
+        if ( ctx ) {
+            __libGL->glXMakeCurrent(h->dpy, win, ctx);
+
+            SET_STRING(NV_CTRL_STRING_GLX_DIRECT_RENDERING,
+                       ((*(__libGL->glXIsDirect))(h->dpy, ctx)) ?
+                       "Yes" : "No");
+
+            for ( i = 0; i < sizeof(gl_strings) / sizeof(gl_strings[0]); i++ ) {
+                str = (const char *) (* (__libGL->glGetString))(gl_strings[i]);
+                SET_STRING(NV_CTRL_STRING_GLX_OPENGL_VENDOR + i, str);
+            }
 
-    if (getDirect) {
-        str = ((*(__libGL->glXIsDirect))(h->dpy, ctx)) ? "Yes" : "No";
-    } else {
-        str = (const char *) (* (__libGL->glGetString))(prop);
-    }
+            __libGL->glXMakeCurrent(h->dpy, None, NULL);
+            __libGL->glXDestroyContext(h->dpy, ctx);
+        } else {
+            SET_STRING(NV_CTRL_STRING_GLX_DIRECT_RENDERING, "No");
+        }
 
-    if (visinfo) {
-        XFree(visinfo);
-    }
-    if (ctx) {
-        __libGL->glXDestroyContext(h->dpy, ctx);
-    }
-    if (win) {
         XDestroyWindow(h->dpy, win);
+        XFreeColormap(h->dpy, win_attr.colormap);
+        XFree(visinfo);
     }
 
-    return str;
-}
+#undef SET_STRING
+
+    h->glx_strings = strs;
+
+    return True;
+
+} /* snapshot_strings() */
+
+
 
 ReturnStatus
 NvCtrlGlxGetStringAttribute (NvCtrlAttributePrivateHandle *h,
@@ -725,53 +1040,17 @@ NvCtrlGlxGetStringAttribute (NvCtrlAttributePrivateHandle *h,
     }
 
 
-    /* Get the right string */
-    switch (attr) {
-        
-    case NV_CTRL_STRING_GLX_DIRECT_RENDERING:
-        str = getString(h, True, 0);
-        break;
-    case NV_CTRL_STRING_GLX_GLX_EXTENSIONS:
-        str = (* (__libGL->glXQueryExtensionsString))(h->dpy, h->target_id);
-        break;
-    case NV_CTRL_STRING_GLX_SERVER_VENDOR:
-        str = (* (__libGL->glXQueryServerString))(h->dpy, h->target_id,
-                                                  GLX_VENDOR);
-        break;
-    case NV_CTRL_STRING_GLX_SERVER_VERSION:
-        str = (* (__libGL->glXQueryServerString))(h->dpy, h->target_id,
-                                                  GLX_VERSION);
-        break;
-    case NV_CTRL_STRING_GLX_SERVER_EXTENSIONS:
-        str = (* (__libGL->glXQueryServerString))(h->dpy, h->target_id,
-                                                  GLX_EXTENSIONS);
-        break;
-    case NV_CTRL_STRING_GLX_CLIENT_VENDOR:
-        str = (* (__libGL->glXGetClientString))(h->dpy, GLX_VENDOR);
-        break;
-    case NV_CTRL_STRING_GLX_CLIENT_VERSION:
-        str = (* (__libGL->glXGetClientString))(h->dpy, GLX_VERSION);
-        break;
-    case NV_CTRL_STRING_GLX_CLIENT_EXTENSIONS:
-        str = (* (__libGL->glXGetClientString))(h->dpy, GLX_EXTENSIONS);
-        break;
-    case NV_CTRL_STRING_GLX_OPENGL_VENDOR:
-        str = getString(h, False, GL_VENDOR);
-        break;
-    case NV_CTRL_STRING_GLX_OPENGL_RENDERER:
-        str = getString(h, False, GL_RENDERER);
-        break;
-    case NV_CTRL_STRING_GLX_OPENGL_VERSION:
-        str = getString(h, False, GL_VERSION);
-        break;
-    case NV_CTRL_STRING_GLX_OPENGL_EXTENSIONS:
-        str = getString(h, False, GL_EXTENSIONS);
-        break;
-        
-    default:
+    if ( attr < NV_CTRL_STRING_GLX_BASE ||
+         attr > NV_CTRL_STRING_GLX_LAST_ATTRIBUTE ) {
         return NvCtrlNoAttribute;
-        break;
-    } /* Done - Fetching corresponding string attribute */
+    }
+
+
+    /* Read all the strings on first use */
+    if ( !h->glx_strings && !snapshot_strings(h) ) {
+        return NvCtrlError;
+    }
+    str = h->glx_strings[attr - NV_CTRL_STRING_GLX_BASE];
 
 
     /* Copy the string and return it */
@@ -27,6 +27,11 @@
 
 #include "NVCtrlLib.h"
 
+#if defined(XNVCTRL_USE_XCB)
+#include <X11/Xlib-xcb.h>
+#include "NVCtrlXcb.h"
+#endif
+
 #include "msg.h"
 
 #include <stdlib.h>
@@ -415,6 +420,218 @@ NvCtrlNvControlStringOperation(NvCtrlAttributePrivateHandle *h,
 } /* NvCtrlNvControlStringOperation() */
 
 
+#if defined(XNVCTRL_USE_XCB)
+
+/*
+ * query_batch_xcb() - send the batch through the XCB backend: every
+ * request is sent before the first reply is waited for, and an X
+ * error only fails its own entry, rather than reaching the Xlib error
+ * handler.  NV-CONTROL 1.8 and 1.9, which need the target swapped,
+ * are older than NV_MINMAJOR.NV_MINMINOR, so the requests can be sent
+ * as is.
+ */
+
+static ReturnStatus query_batch_xcb(Display *dpy, NvCtrlBatchQuery **queries,
+                                    int count)
+{
+    xcb_connection_t *c = XGetXCBConnection(dpy);
+    XNVCTRLXcbCookie *cookies;
+    NvCtrlAttributePrivateHandle *h;
+    Bool use_64;
+    int i, ret;
+
+    cookies = calloc(count, sizeof(XNVCTRLXcbCookie));
+    if (!cookies) return NvCtrlError;
+
+    for (i = 0; i < count; i++) {
+        NvCtrlBatchQuery *q = queries[i];
+
+        h = (NvCtrlAttributePrivateHandle *) q->handle;
+
+        /* the 64-bit requests were added in NV-CONTROL 1.21 */
+
+        use_64 = (h->nv->major_version > 1) ||
+            ((h->nv->major_version == 1) && (h->nv->minor_version > 20));
+
+        switch (q->query_type) {
+        case NV_CTRL_BATCH_GET_ATTRIBUTE:
+            cookies[i] = use_64 ?
+                XNVCTRLXcbQueryTargetAttribute64(c, h->target_type,
+                                                 h->target_id,
+                                                 q->display_mask, q->attr) :
+                XNVCTRLXcbQueryTargetAttribute(c, h->target_type,
+                                               h->target_id,
+                                               q->display_mask, q->attr);
+            break;
+        case NV_CTRL_BATCH_GET_VALID_VALUES:
+            cookies[i] = use_64 ?
+                XNVCTRLXcbQueryValidTargetAttributeValues64
+                    (c, h->target_type, h->target_id, q->display_mask,
+                     q->attr) :
+                XNVCTRLXcbQueryValidTargetAttributeValues
+                    (c, h->target_type, h->target_id, q->display_mask,
+                     q->attr);
+            break;
+        case NV_CTRL_BATCH_GET_STRING_ATTRIBUTE:
+            cookies[i] =
+                XNVCTRLXcbQueryTargetStringAttribute(c, h->target_type,
+                                                     h->target_id,
+                                                     q->display_mask,
+                                                     q->attr);
+            break;
+        case NV_CTRL_BATCH_SET_ATTRIBUTE:
+            cookies[i] =
+                XNVCTRLXcbSetTargetAttributeAndGetStatus(c, h->target_type,
+                                                         h->target_id,
+                                                         q->display_mask,
+                                                         q->attr,
+                                                         (int) q->value);
+            break;
+        }
+    }
+
+    for (i = 0; i < count; i++) {
+        NvCtrlBatchQuery *q = queries[i];
+
+        switch (q->query_type) {
+        case NV_CTRL_BATCH_GET_ATTRIBUTE:
+            ret = XNVCTRLXcbQueryTargetAttributeReply(c, cookies[i],
+                                                      &q->value);
+            break;
+        case NV_CTRL_BATCH_GET_VALID_VALUES:
+            ret = XNVCTRLXcbQueryValidTargetAttributeValuesReply
+                (c, cookies[i], &q->valid_values);
+            break;
+        case NV_CTRL_BATCH_GET_STRING_ATTRIBUTE:
+            ret = XNVCTRLXcbQueryTargetStringAttributeReply(c, cookies[i],
+                                                            &q->string);
+            break;
+        case NV_CTRL_BATCH_SET_ATTRIBUTE:
+        default:
+            ret = XNVCTRLXcbSetTargetAttributeAndGetStatusReply(c,
+                                                                cookies[i]);
+            break;
+        }
+
+        if (ret) {
+            q->status = NvCtrlSuccess;
+        } else {
+            q->status = (q->query_type == NV_CTRL_BATCH_SET_ATTRIBUTE) ?
+                NvCtrlError : NvCtrlAttributeNotAvailable;
+        }
+    }
+
+    free(cookies);
+
+    return NvCtrlSuccess;
+
+} /* query_batch_xcb() */
+
+#endif /* XNVCTRL_USE_XCB */
+
+
+/*
+ * NvCtrlNvControlQueryBatch() - send the given NV-CONTROL queries (and
+ * assignments) as a single batch; every entry must refer to an
+ * NV-CONTROL attribute on a handle with the NV-CONTROL subsystem
+ * initialized.
+ *
+ * When built with XNVCTRL_USE_XCB, the batch is sent through the XCB
+ * backend (see NVCtrlXcb.h), unless XNVCTRL_BACKEND=xlib is set in
+ * the environment; otherwise, it is sent with
+ * XNVCTRLQueryTargetBatch().
+ */
+
+ReturnStatus NvCtrlNvControlQueryBatch(Display *dpy,
+                                       NvCtrlBatchQuery **queries,
+                                       int count)
+{
+    XNVCTRLBatchQueryRec *batch;
+    NvCtrlAttributePrivateHandle *h;
+    Bool bRet;
+    int i;
+
+    if (count <= 0) return NvCtrlSuccess;
+
+    for (i = 0; i < count; i++) {
+        switch (queries[i]->query_type) {
+        case NV_CTRL_BATCH_GET_ATTRIBUTE:
+        case NV_CTRL_BATCH_GET_VALID_VALUES:
+        case NV_CTRL_BATCH_GET_STRING_ATTRIBUTE:
+        case NV_CTRL_BATCH_SET_ATTRIBUTE:
+            break;
+        default:
+            return NvCtrlBadArgument;
+        }
+    }
+
+#if defined(XNVCTRL_USE_XCB)
+    {
+        const char *backend = getenv("XNVCTRL_BACKEND");
+
+        if (!backend || strcmp(backend, "xlib") != 0) {
+            return query_batch_xcb(dpy, queries, count);
+        }
+    }
+#endif
+
+    batch = calloc(count, sizeof(XNVCTRLBatchQueryRec));
+    if (!batch) return NvCtrlError;
+
+    for (i = 0; i < count; i++) {
+        h = (NvCtrlAttributePrivateHandle *) queries[i]->handle;
+
+        switch (queries[i]->query_type) {
+        case NV_CTRL_BATCH_GET_ATTRIBUTE:
+            batch[i].query_type = XNVCTRL_BATCH_QUERY_ATTRIBUTE;
+            break;
+        case NV_CTRL_BATCH_GET_VALID_VALUES:
+            batch[i].query_type = XNVCTRL_BATCH_QUERY_VALID_VALUES;
+            break;
+        case NV_CTRL_BATCH_GET_STRING_ATTRIBUTE:
+            batch[i].query_type = XNVCTRL_BATCH_QUERY_STRING_ATTRIBUTE;
+            break;
+        case NV_CTRL_BATCH_SET_ATTRIBUTE:
+            batch[i].query_type = XNVCTRL_BATCH_SET_ATTRIBUTE;
+            batch[i].value = queries[i]->value;
+            break;
+        }
+        batch[i].target_type = h->target_type;
+        batch[i].target_id = h->target_id;
+        batch[i].display_mask = queries[i]->display_mask;
+        batch[i].attribute = queries[i]->attr;
+    }
+
+    bRet = XNVCTRLQueryTargetBatch(dpy, batch, count);
+
+    for (i = 0; i < count; i++) {
+        NvCtrlBatchQuery *q = queries[i];
+
+        if (!bRet) {
+            q->status = NvCtrlError;
+            continue;
+        }
+        if (!batch[i].status) {
+            q->status = (q->query_type == NV_CTRL_BATCH_SET_ATTRIBUTE) ?
+                NvCtrlError : NvCtrlAttributeNotAvailable;
+            continue;
+        }
+
+        q->status = NvCtrlSuccess;
+        if (q->query_type == NV_CTRL_BATCH_SET_ATTRIBUTE) continue;
+
+        q->value = batch[i].value;
+        q->valid_values = batch[i].valid_values;
+        q->string = batch[i].string;
+    }
+
+    free(batch);
+
+    return bRet ? NvCtrlSuccess : NvCtrlError;
+
+} /* NvCtrlNvControlQueryBatch() */
+
+
 ReturnStatus
 NvCtrlSetGvoColorConversion(NvCtrlAttributeHandle *handle,
                             float colorMatrix[3][3],
@@ -86,6 +86,10 @@ typedef struct __NvCtrlXvTextureAttributes NvCtrlXvTextureAttributes;
 typedef struct __NvCtrlXvBlitterAttributes NvCtrlXvBlitterAttributes;
 typedef struct __NvCtrlXvAttribute NvCtrlXvAttribute;
 typedef struct __NvCtrlXrandrAttributes NvCtrlXrandrAttributes;
+typedef struct __NvCtrlAttributeCache NvCtrlAttributeCache;
+typedef struct __NvCtrlAttributeState NvCtrlAttributeState;
+typedef struct __NvCtrlGlxFBConfigs NvCtrlGlxFBConfigs;
+typedef struct __NvCtrlValidValuesCache NvCtrlValidValuesCache;
 
 struct __NvCtrlNvControlAttributes {
     int event_base;
@@ -103,6 +107,9 @@ struct __NvCtrlVidModeAttributes {
     float brightness[3];
     float contrast[3];
     float gamma[3];
+    int *ramp[3];                   /* per-channel ramp before brightness */
+    float ramp_contrast[3];         /* contrast ramp[] was computed for */
+    float ramp_gamma[3];            /* gamma ramp[] was computed for */
 };
 
 struct __NvCtrlXvAttribute {
@@ -148,6 +155,9 @@ struct __NvCtrlXrandrAttributes {
     int error_base;
     int major_version;
     int minor_version;
+    XRRScreenConfiguration *sc;     /* cached screen configuration */
+    unsigned int sc_generation;     /* screen config generation of sc */
+    Bool sc_tracked;                /* screen changes are reported */
 };
 
 struct __NvCtrlAttributePrivateHandle {
@@ -162,9 +172,20 @@ struct __NvCtrlAttributePrivateHandle {
     NvCtrlVidModeAttributes *vm;    /* XF86VidMode extension info */
     NvCtrlXvAttributes *xv;         /* XVideo info */
     Bool glx;                       /* GLX extension available */
+    NvCtrlGlxFBConfigs *glx_fbconfigs; /* GLX fbconfigs, once queried */
+    char **glx_strings;             /* GLX/GL strings, once queried */
     NvCtrlXrandrAttributes *xrandr; /* XRandR extension info */
+
+    NvCtrlAttributeCache *cache;    /* NV-CONTROL attribute cache */
+    NvCtrlAttributeState *state;    /* values seen during the session */
+    NvCtrlValidValuesCache *valid_values_cache; /* once used */
+
+    unsigned int uninitialized_subsystems; /* requested, not yet probed */
 };
 
+void
+NvCtrlInitSubsystems (NvCtrlAttributePrivateHandle *, unsigned int);
+
 NvCtrlNvControlAttributes *
 NvCtrlInitNvControlAttributes (NvCtrlAttributePrivateHandle *);
 
@@ -237,6 +258,12 @@ ReturnStatus
 NvCtrlXrandrGetStringAttribute (NvCtrlAttributePrivateHandle *,
                                 unsigned int, int, char **);
 
+void
+NvCtrlXrandrInvalidateScreenConfig (NvCtrlAttributePrivateHandle *);
+
+void
+NvCtrlXrandrTrackScreenConfig (NvCtrlAttributePrivateHandle *);
+
 
 /* XF86 Video Mode extension attribute functions */
 
@@ -291,4 +318,59 @@ NvCtrlNvControlStringOperation (NvCtrlAttributePrivateHandle *h,
                                 unsigned int display_mask, int attr,
                                 char *ptrIn, char **ptrOut);
 
+ReturnStatus
+NvCtrlNvControlQueryBatch (Display *dpy, NvCtrlBatchQuery **queries,
+                           int count);
+
+
+/* NV-CONTROL attribute cache functions */
+
+Bool
+NvCtrlAttributeCacheLookup (NvCtrlAttributePrivateHandle *, unsigned int,
+                            int, int64_t *, ReturnStatus *);
+
+void
+NvCtrlAttributeCacheStore (NvCtrlAttributePrivateHandle *, unsigned int,
+                           int, int64_t, ReturnStatus);
+
+void
+NvCtrlAttributeCacheFlushAll (void);
+
+void
+NvCtrlAttributeCacheClose (NvCtrlAttributePrivateHandle *);
+
+
+/* NV-CONTROL attribute session state functions */
+
+void
+NvCtrlAttributeStateStore (NvCtrlAttributePrivateHandle *, unsigned int,
+                           int, int64_t);
+
+void
+NvCtrlAttributeStateStorePermissions (NvCtrlAttributePrivateHandle *, int,
+                                      unsigned int);
+
+void
+NvCtrlAttributeStateRemove (NvCtrlAttributePrivateHandle *, int);
+
+void
+NvCtrlAttributeStateClose (NvCtrlAttributePrivateHandle *);
+
+
+/* Persistent valid values cache functions */
+
+Bool
+NvCtrlValidValuesCacheLookup (NvCtrlAttributePrivateHandle *, unsigned int,
+                              int, NVCTRLAttributeValidValuesRec *);
+
+void
+NvCtrlValidValuesCacheStore (NvCtrlAttributePrivateHandle *, unsigned int,
+                             int, const NVCTRLAttributeValidValuesRec *);
+
+void
+NvCtrlValidValuesCacheRelease (NvCtrlAttributePrivateHandle *);
+
+void
+NvCtrlValidValuesCacheDrop (NvCtrlAttributePrivateHandle *, int);
+
 #endif /* __NVCTRL_ATTRIBUTES_PRIVATE__ */
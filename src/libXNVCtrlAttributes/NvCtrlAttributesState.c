@@ -0,0 +1,245 @@
+/*
+ * nvidia-settings: A tool for configuring the NVIDIA X driver on Unix
+ * and Linux systems.
+ *
+ * Copyright (C) 2004 NVIDIA Corporation.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of Version 2 of the GNU General Public
+ * License as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See Version 2
+ * of the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the:
+ *
+ *           Free Software Foundation, Inc.
+ *           59 Temple Place - Suite 330
+ *           Boston, MA 02111-1307, USA
+ *
+ */
+
+
+/*
+ * Record of the NV-CONTROL integer attribute values seen through a
+ * handle during a session.
+ *
+ * Unlike the attribute cache, which is flushed by every Set request
+ * and only saves round trips, the session state keeps the last value
+ * known for each (display device, attribute) of the handle's target:
+ * values read from the server, values this client assigned, and
+ * values reported by attribute events (passed to
+ * NvCtrlAttributeCacheAttributeChanged()).  This lets the
+ * configuration file be written at exit without querying the server
+ * again.
+ */
+
+#include "NvCtrlAttributes.h"
+#include "NvCtrlAttributesPrivate.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+
+#define NV_CTRL_ATTRIBUTE_STATE_DISPLAYS 24
+
+typedef struct {
+    Bool permissions_known;
+    unsigned int permissions;     /* ATTRIBUTE_TYPE_* permission bits */
+    Bool value_known;
+    int64_t value;                /* last value, for any display mask */
+    unsigned int display_known;   /* display devices with a known value */
+    int64_t *display_values;      /* allocated on first per display value */
+} NvCtrlAttributeStateEntry;
+
+struct __NvCtrlAttributeState {
+    NvCtrlAttributeStateEntry entries[NV_CTRL_LAST_ATTRIBUTE + 1];
+};
+
+
+
+/*
+ * NvCtrlAttributeStateStore() - record that (display_mask, attr) of
+ * the handle's target has the value 'val'.  A value for several
+ * display devices applies to each of them.
+ */
+
+void NvCtrlAttributeStateStore(NvCtrlAttributePrivateHandle *h,
+                               unsigned int display_mask, int attr,
+                               int64_t val)
+{
+    NvCtrlAttributeStateEntry *e;
+    int bit;
+
+    if (!h->state || (attr < 0) || (attr > NV_CTRL_LAST_ATTRIBUTE)) return;
+
+    e = &h->state->entries[attr];
+
+    e->value_known = True;
+    e->value = val;
+
+    display_mask &= (1 << NV_CTRL_ATTRIBUTE_STATE_DISPLAYS) - 1;
+
+    if (!display_mask) return;
+
+    if (!e->display_values) {
+        e->display_values = calloc(NV_CTRL_ATTRIBUTE_STATE_DISPLAYS,
+                                   sizeof(int64_t));
+        if (!e->display_values) return;
+    }
+
+    for (bit = 0; bit < NV_CTRL_ATTRIBUTE_STATE_DISPLAYS; bit++) {
+        if (display_mask & (1 << bit)) {
+            e->display_values[bit] = val;
+        }
+    }
+
+    e->display_known |= display_mask;
+
+} /* NvCtrlAttributeStateStore() */
+
+
+
+/*
+ * NvCtrlAttributeStateStorePermissions() - record the permissions
+ * reported in the valid values of the given attribute.
+ */
+
+void NvCtrlAttributeStateStorePermissions(NvCtrlAttributePrivateHandle *h,
+                                          int attr, unsigned int permissions)
+{
+    NvCtrlAttributeStateEntry *e;
+
+    if (!h->state || (attr < 0) || (attr > NV_CTRL_LAST_ATTRIBUTE)) return;
+
+    e = &h->state->entries[attr];
+
+    e->permissions_known = True;
+    e->permissions = permissions;
+
+} /* NvCtrlAttributeStateStorePermissions() */
+
+
+
+/*
+ * NvCtrlAttributeStateRemove() - forget everything known about the
+ * given attribute; e.g., when an event reports that it is no longer
+ * available.
+ */
+
+void NvCtrlAttributeStateRemove(NvCtrlAttributePrivateHandle *h, int attr)
+{
+    NvCtrlAttributeStateEntry *e;
+
+    if (!h->state || (attr < 0) || (attr > NV_CTRL_LAST_ATTRIBUTE)) return;
+
+    e = &h->state->entries[attr];
+
+    free(e->display_values);
+    memset(e, 0, sizeof(*e));
+
+} /* NvCtrlAttributeStateRemove() */
+
+
+
+void NvCtrlAttributeStateClose(NvCtrlAttributePrivateHandle *h)
+{
+    int attr;
+
+    if (!h->state) return;
+
+    for (attr = 0; attr <= NV_CTRL_LAST_ATTRIBUTE; attr++) {
+        free(h->state->entries[attr].display_values);
+    }
+
+    free(h->state);
+    h->state = NULL;
+
+} /* NvCtrlAttributeStateClose() */
+
+
+
+void NvCtrlAttributeStateEnable(NvCtrlAttributeHandle *handle, Bool enable)
+{
+    NvCtrlAttributePrivateHandle *h = (NvCtrlAttributePrivateHandle *) handle;
+
+    if (!h) return;
+
+    if (!enable) {
+        NvCtrlAttributeStateClose(h);
+        return;
+    }
+
+    if (!h->state) {
+        h->state = calloc(1, sizeof(NvCtrlAttributeState));
+    }
+
+} /* NvCtrlAttributeStateEnable() */
+
+
+
+Bool NvCtrlAttributeStateIsEnabled(NvCtrlAttributeHandle *handle)
+{
+    NvCtrlAttributePrivateHandle *h = (NvCtrlAttributePrivateHandle *) handle;
+
+    return (h && h->state) ? True : False;
+
+} /* NvCtrlAttributeStateIsEnabled() */
+
+
+
+Bool NvCtrlAttributeStateLookup(NvCtrlAttributeHandle *handle,
+                                unsigned int display_mask, int attr,
+                                int64_t *val)
+{
+    NvCtrlAttributePrivateHandle *h = (NvCtrlAttributePrivateHandle *) handle;
+    NvCtrlAttributeStateEntry *e;
+    int bit;
+
+    if (!h || !h->state || (attr < 0) || (attr > NV_CTRL_LAST_ATTRIBUTE)) {
+        return False;
+    }
+
+    e = &h->state->entries[attr];
+
+    if (!display_mask) {
+        if (!e->value_known) return False;
+        *val = e->value;
+        return True;
+    }
+
+    if ((e->display_known & display_mask) != display_mask) return False;
+
+    for (bit = 0; !(display_mask & (1 << bit)); bit++);
+
+    *val = e->display_values[bit];
+
+    return True;
+
+} /* NvCtrlAttributeStateLookup() */
+
+
+
+Bool NvCtrlAttributeStateLookupPermissions(NvCtrlAttributeHandle *handle,
+                                           int attr,
+                                           unsigned int *permissions)
+{
+    NvCtrlAttributePrivateHandle *h = (NvCtrlAttributePrivateHandle *) handle;
+    NvCtrlAttributeStateEntry *e;
+
+    if (!h || !h->state || (attr < 0) || (attr > NV_CTRL_LAST_ATTRIBUTE)) {
+        return False;
+    }
+
+    e = &h->state->entries[attr];
+
+    if (!e->permissions_known) return False;
+
+    *permissions = e->permissions;
+
+    return True;
+
+} /* NvCtrlAttributeStateLookupPermissions() */
@@ -0,0 +1,752 @@
+/*
+ * nvidia-settings: A tool for configuring the NVIDIA X driver on Unix
+ * and Linux systems.
+ *
+ * Copyright (C) 2004 NVIDIA Corporation.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of Version 2 of the GNU General Public
+ * License as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See Version 2
+ * of the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the:
+ *
+ *           Free Software Foundation, Inc.
+ *           59 Temple Place - Suite 330
+ *           Boston, MA 02111-1307, USA
+ *
+ */
+
+/*
+ * Persistent cache of the valid values of NV-CONTROL integer
+ * attributes.
+ *
+ * The valid values (type, range or bits, and permissions) of an
+ * attribute only change with the driver, so they are saved, per X
+ * display, in ~/.nvidia-settings-cache/valid-values-<display>.  The
+ * file is a header, recording the driver version it was built
+ * against, followed by an array of fixed size records sorted by
+ * (target type, target id, display mask, attribute); it is mmap()'ed
+ * and searched in place.  A file written against a different driver
+ * version is ignored, and replaced when the cache is next saved.
+ *
+ * Values learned from the server while running are kept in a sorted
+ * in-memory array, and merged with the mapped records when the cache
+ * is saved, once the last handle that used it is closed (see
+ * NvCtrlValidValuesCacheRelease()).
+ *
+ * Attributes whose valid values or permissions depend on the state of
+ * the server are never cached (see uncacheable()); an attribute that
+ * is reported as no longer available is dropped from the cache.
+ *
+ * Handles may be used from several threads at once (see fanout.c), so
+ * the list of caches, and each cache, is protected by caches_lock.
+ */
+
+#include "NvCtrlAttributes.h"
+#include "NvCtrlAttributesPrivate.h"
+
+#include "NVCtrlLib.h"
+
+#include "common-utils.h"
+#include "parse.h"
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdio.h>
+#include <pthread.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <sys/mman.h>
+
+
+#define VALID_VALUES_CACHE_DIR    "~/.nvidia-settings-cache"
+#define VALID_VALUES_CACHE_MAGIC  0x4e565656 /* "NVVV" */
+#define VALID_VALUES_CACHE_FORMAT 1
+
+#define DRIVER_VERSION_LEN 64
+
+typedef struct {
+    uint32_t magic;
+    uint32_t format;
+    uint32_t count;
+    uint32_t record_size;
+    char driver_version[DRIVER_VERSION_LEN];
+} ValidValuesCacheHeader;
+
+typedef struct {
+    int32_t target_type;
+    int32_t target_id;
+    uint32_t display_mask;
+    int32_t attr;
+    int32_t type;
+    uint32_t permissions;
+    int64_t min;  /* also holds the bits of ATTRIBUTE_TYPE_INT_BITS */
+    int64_t max;
+} ValidValuesCacheRecord;
+
+typedef struct __NvCtrlValidValuesCache ValidValuesCache;
+
+struct __NvCtrlValidValuesCache {
+    Display *dpy;        /* connection that last used this cache */
+    int refs;            /* handles using this cache */
+    char *display_name;
+    char *filename;
+    Bool disabled;       /* the driver version could not be queried */
+    char driver_version[DRIVER_VERSION_LEN];
+
+    void *map;           /* mmap()'ed cache file */
+    size_t map_size;
+    const ValidValuesCacheRecord *records;
+    int num_records;
+
+    ValidValuesCacheRecord *added;  /* learned since the file was loaded */
+    int num_added;
+    int added_alloc;
+
+    ValidValuesCacheRecord *dropped; /* attributes no longer available */
+    int num_dropped;
+
+    Bool dirty;
+
+    ValidValuesCache *next;
+};
+
+static ValidValuesCache *caches = NULL;
+static pthread_mutex_t caches_lock = PTHREAD_MUTEX_INITIALIZER;
+
+
+
+/*
+ * init_uncacheable() - find the attributes whose valid values or
+ * permissions depend on the state of the server, rather than only on
+ * the driver and hardware:
+ *
+ * - the SDI (GVO and GVI) attributes, which depend on the video
+ *   format, the sync signal, and what is attached to the SDI jacks;
+ *
+ * - the frame lock attributes, which depend on the frame lock
+ *   configuration and the house sync signal;
+ *
+ * - the clock attributes, which depend on whether overclocking is
+ *   enabled, and the cooler attributes, whose permissions depend on
+ *   whether manual cooler control is enabled.
+ */
+
+static Bool uncacheable_attrs[NV_CTRL_LAST_ATTRIBUTE + 1];
+static pthread_once_t uncacheable_once = PTHREAD_ONCE_INIT;
+
+static void init_uncacheable(void)
+{
+    static const int attrs[] = {
+        NV_CTRL_GPU_OVERCLOCKING_STATE,
+        NV_CTRL_GPU_2D_CLOCK_FREQS,
+        NV_CTRL_GPU_3D_CLOCK_FREQS,
+        NV_CTRL_GPU_DEFAULT_2D_CLOCK_FREQS,
+        NV_CTRL_GPU_DEFAULT_3D_CLOCK_FREQS,
+        NV_CTRL_GPU_CURRENT_CLOCK_FREQS,
+        NV_CTRL_GPU_OPTIMAL_CLOCK_FREQS,
+        NV_CTRL_GPU_OPTIMAL_CLOCK_FREQS_DETECTION,
+        NV_CTRL_GPU_OPTIMAL_CLOCK_FREQS_DETECTION_STATE,
+        NV_CTRL_GPU_CURRENT_PROCESSOR_CLOCK_FREQS,
+        NV_CTRL_GPU_ADAPTIVE_CLOCK_STATE,
+        NV_CTRL_GPU_COOLER_MANUAL_CONTROL,
+        NV_CTRL_THERMAL_COOLER_LEVEL,
+        NV_CTRL_THERMAL_COOLER_LEVEL_SET_DEFAULT,
+    };
+    const AttributeTableEntry *a;
+    int i;
+
+    for (a = attributeTable; a->name; a++) {
+        if ((a->flags & (NV_PARSER_TYPE_SDI | NV_PARSER_TYPE_FRAMELOCK)) &&
+            !(a->flags & NV_PARSER_TYPE_STRING_ATTRIBUTE) &&
+            (a->attr >= 0) && (a->attr <= NV_CTRL_LAST_ATTRIBUTE)) {
+            uncacheable_attrs[a->attr] = True;
+        }
+    }
+
+    for (i = 0; i < sizeof(attrs) / sizeof(attrs[0]); i++) {
+        uncacheable_attrs[attrs[i]] = True;
+    }
+
+} /* init_uncacheable() */
+
+
+
+/*
+ * uncacheable() - return whether the valid values of the attribute may
+ * change while the server is running; those are never cached.
+ */
+
+static Bool uncacheable(int attr)
+{
+    if ((attr < 0) || (attr > NV_CTRL_LAST_ATTRIBUTE)) return True;
+
+    pthread_once(&uncacheable_once, init_uncacheable);
+
+    return uncacheable_attrs[attr];
+
+} /* uncacheable() */
+
+
+
+static int compare_records(const void *a, const void *b)
+{
+    const ValidValuesCacheRecord *ra = a;
+    const ValidValuesCacheRecord *rb = b;
+
+    if (ra->target_type != rb->target_type) {
+        return (ra->target_type < rb->target_type) ? -1 : 1;
+    }
+    if (ra->target_id != rb->target_id) {
+        return (ra->target_id < rb->target_id) ? -1 : 1;
+    }
+    if (ra->display_mask != rb->display_mask) {
+        return (ra->display_mask < rb->display_mask) ? -1 : 1;
+    }
+    if (ra->attr != rb->attr) {
+        return (ra->attr < rb->attr) ? -1 : 1;
+    }
+    return 0;
+
+} /* compare_records() */
+
+
+
+/*
+ * is_dropped() - return whether the record's attribute was reported as
+ * no longer available for its target; called with caches_lock held.
+ */
+
+static Bool is_dropped(const ValidValuesCache *cache,
+                       const ValidValuesCacheRecord *r)
+{
+    int i;
+
+    for (i = 0; i < cache->num_dropped; i++) {
+        if (cache->dropped[i].target_type == r->target_type &&
+            cache->dropped[i].target_id == r->target_id &&
+            cache->dropped[i].attr == r->attr) {
+            return True;
+        }
+    }
+
+    return False;
+
+} /* is_dropped() */
+
+
+
+/*
+ * load_cache_file() - map the cache file, if it exists and was written
+ * against the current driver version.
+ */
+
+static void load_cache_file(ValidValuesCache *cache)
+{
+    const ValidValuesCacheHeader *header;
+    struct stat stat_buf;
+    void *map;
+    int fd;
+
+    fd = open(cache->filename, O_RDONLY);
+    if (fd == -1) return;
+
+    if ((fstat(fd, &stat_buf) == -1) ||
+        (stat_buf.st_size < sizeof(ValidValuesCacheHeader))) {
+        close(fd);
+        return;
+    }
+
+    map = mmap(NULL, stat_buf.st_size, PROT_READ, MAP_SHARED, fd, 0);
+    close(fd);
+
+    if (map == MAP_FAILED) return;
+
+    header = map;
+
+    if ((header->magic != VALID_VALUES_CACHE_MAGIC) ||
+        (header->format != VALID_VALUES_CACHE_FORMAT) ||
+        (header->record_size != sizeof(ValidValuesCacheRecord)) ||
+        (stat_buf.st_size != sizeof(ValidValuesCacheHeader) +
+         (size_t) header->count * sizeof(ValidValuesCacheRecord)) ||
+        (strncmp(header->driver_version, cache->driver_version,
+                 DRIVER_VERSION_LEN) != 0)) {
+        munmap(map, stat_buf.st_size);
+        return;
+    }
+
+    cache->map = map;
+    cache->map_size = stat_buf.st_size;
+    cache->records = (const ValidValuesCacheRecord *) (header + 1);
+    cache->num_records = header->count;
+
+} /* load_cache_file() */
+
+
+
+/*
+ * find_cache() - return the cache for the handle's X display, if there
+ * is one yet; called with caches_lock held.
+ */
+
+static ValidValuesCache *find_cache(NvCtrlAttributePrivateHandle *h,
+                                    const char *display_name)
+{
+    ValidValuesCache *cache;
+
+    for (cache = caches; cache; cache = cache->next) {
+        if (cache->dpy == h->dpy) return cache;
+    }
+
+    for (cache = caches; cache; cache = cache->next) {
+        if (strcmp(cache->display_name, display_name) == 0) {
+            cache->dpy = h->dpy;
+            return cache;
+        }
+    }
+
+    return NULL;
+
+} /* find_cache() */
+
+
+
+/*
+ * get_cache() - return the valid values cache for the handle's X
+ * display, creating (and loading) it on first use.  Returns NULL if
+ * the cache cannot be used.
+ *
+ * The cache is remembered in the handle, so that only its first use
+ * has to look for the cache of its display.
+ *
+ * Called with caches_lock held; the lock is dropped while the driver
+ * version is queried, so that a slow X server does not hold up the
+ * threads talking to other X servers.
+ */
+
+static ValidValuesCache *bind_cache(NvCtrlAttributePrivateHandle *h,
+                                    ValidValuesCache *cache)
+{
+    h->valid_values_cache = cache;
+    cache->refs++;
+
+    return cache->disabled ? NULL : cache;
+
+} /* bind_cache() */
+
+static ValidValuesCache *get_cache(NvCtrlAttributePrivateHandle *h)
+{
+    ValidValuesCache *cache;
+    char *display_name, *dir, *c;
+    char *driver_version = NULL;
+    Bool have_version;
+
+    cache = h->valid_values_cache;
+    if (cache) {
+        return cache->disabled ? NULL : cache;
+    }
+
+    for (cache = caches; cache; cache = cache->next) {
+        if (cache->dpy == h->dpy) {
+            return bind_cache(h, cache);
+        }
+    }
+
+    display_name = nv_standardize_screen_name(DisplayString(h->dpy), -2);
+    if (!display_name) return NULL;
+
+    cache = find_cache(h, display_name);
+    if (cache) {
+        free(display_name);
+        return bind_cache(h, cache);
+    }
+
+    /*
+     * the cache is only valid for the driver version it was built
+     * with; ask GPU 0, as not every target type answers this query
+     */
+
+    pthread_mutex_unlock(&caches_lock);
+
+    have_version =
+        XNVCTRLQueryTargetStringAttribute(h->dpy, NV_CTRL_TARGET_TYPE_GPU,
+                                          0, 0,
+                                          NV_CTRL_STRING_NVIDIA_DRIVER_VERSION,
+                                          &driver_version) &&
+        driver_version;
+
+    pthread_mutex_lock(&caches_lock);
+
+    /* another thread may have created the cache in the meantime */
+
+    cache = find_cache(h, display_name);
+    if (cache) {
+        free(display_name);
+        free(driver_version);
+        return bind_cache(h, cache);
+    }
+
+    cache = calloc(1, sizeof(ValidValuesCache));
+    if (!cache) {
+        free(display_name);
+        free(driver_version);
+        return NULL;
+    }
+
+    cache->dpy = h->dpy;
+    cache->display_name = display_name;
+    cache->next = caches;
+    caches = cache;
+
+    if (!have_version) {
+        cache->disabled = True;
+        return bind_cache(h, cache);
+    }
+
+    strncpy(cache->driver_version, driver_version, DRIVER_VERSION_LEN - 1);
+    free(driver_version);
+
+    /* build the file name; the display name may not contain '/' */
+
+    dir = tilde_expansion(VALID_VALUES_CACHE_DIR);
+    cache->filename = nvstrcat(dir, "/valid-values-", display_name, NULL);
+    free(dir);
+
+    for (c = cache->filename + strlen(cache->filename) - strlen(display_name);
+         *c; c++) {
+        if (*c == '/') *c = '_';
+    }
+
+    load_cache_file(cache);
+
+    return bind_cache(h, cache);
+
+} /* get_cache() */
+
+
+
+static void init_record(ValidValuesCacheRecord *r,
+                        NvCtrlAttributePrivateHandle *h,
+                        unsigned int display_mask, int attr)
+{
+    memset(r, 0, sizeof(ValidValuesCacheRecord));
+    r->target_type = h->target_type;
+    r->target_id = h->target_id;
+    r->display_mask = display_mask;
+    r->attr = attr;
+
+} /* init_record() */
+
+
+
+/*
+ * NvCtrlValidValuesCacheLookup() - look up the valid values of an
+ * NV-CONTROL integer attribute in the persistent cache; returns True
+ * and fills in 'val' if found.
+ */
+
+Bool NvCtrlValidValuesCacheLookup(NvCtrlAttributePrivateHandle *h,
+                                  unsigned int display_mask, int attr,
+                                  NVCTRLAttributeValidValuesRec *val)
+{
+    ValidValuesCache *cache;
+    const ValidValuesCacheRecord *r = NULL;
+    ValidValuesCacheRecord key;
+
+    if (uncacheable(attr)) return False;
+
+    pthread_mutex_lock(&caches_lock);
+
+    cache = get_cache(h);
+    if (!cache) {
+        pthread_mutex_unlock(&caches_lock);
+        return False;
+    }
+
+    init_record(&key, h, display_mask, attr);
+
+    if (cache->num_added) {
+        r = bsearch(&key, cache->added, cache->num_added,
+                    sizeof(ValidValuesCacheRecord), compare_records);
+    }
+    if (!r && cache->num_records && !is_dropped(cache, &key)) {
+        r = bsearch(&key, cache->records, cache->num_records,
+                    sizeof(ValidValuesCacheRecord), compare_records);
+    }
+    if (!r) {
+        pthread_mutex_unlock(&caches_lock);
+        return False;
+    }
+
+    memset(val, 0, sizeof(NVCTRLAttributeValidValuesRec));
+    val->type = r->type;
+    val->permissions = r->permissions;
+
+    if (r->type == ATTRIBUTE_TYPE_RANGE) {
+        val->u.range.min = r->min;
+        val->u.range.max = r->max;
+    } else if (r->type == ATTRIBUTE_TYPE_INT_BITS) {
+        val->u.bits.ints = r->min;
+    }
+
+    pthread_mutex_unlock(&caches_lock);
+
+    return True;
+
+} /* NvCtrlValidValuesCacheLookup() */
+
+
+
+/*
+ * NvCtrlValidValuesCacheStore() - add the valid values of an
+ * NV-CONTROL integer attribute, as returned by the server, to the
+ * persistent cache.
+ */
+
+void NvCtrlValidValuesCacheStore(NvCtrlAttributePrivateHandle *h,
+                                 unsigned int display_mask, int attr,
+                                 const NVCTRLAttributeValidValuesRec *val)
+{
+    ValidValuesCache *cache;
+    ValidValuesCacheRecord r, *tmp;
+    int i;
+
+    if (uncacheable(attr)) return;
+
+    pthread_mutex_lock(&caches_lock);
+
+    cache = get_cache(h);
+    if (!cache) goto done;
+
+    init_record(&r, h, display_mask, attr);
+    r.type = val->type;
+    r.permissions = val->permissions;
+
+    if (val->type == ATTRIBUTE_TYPE_RANGE) {
+        r.min = val->u.range.min;
+        r.max = val->u.range.max;
+    } else if (val->type == ATTRIBUTE_TYPE_INT_BITS) {
+        r.min = val->u.bits.ints;
+    }
+
+    /* keep the added records sorted, replacing any existing record */
+
+    for (i = 0; i < cache->num_added; i++) {
+        int cmp = compare_records(&r, &cache->added[i]);
+        if (cmp == 0) {
+            cache->added[i] = r;
+            cache->dirty = True;
+            goto done;
+        }
+        if (cmp < 0) break;
+    }
+
+    if (cache->num_added == cache->added_alloc) {
+        int n = cache->added_alloc ? (cache->added_alloc * 2) : 64;
+        tmp = realloc(cache->added, n * sizeof(ValidValuesCacheRecord));
+        if (!tmp) goto done;
+        cache->added = tmp;
+        cache->added_alloc = n;
+    }
+
+    memmove(&cache->added[i + 1], &cache->added[i],
+            (cache->num_added - i) * sizeof(ValidValuesCacheRecord));
+    cache->added[i] = r;
+    cache->num_added++;
+    cache->dirty = True;
+
+ done:
+    pthread_mutex_unlock(&caches_lock);
+
+} /* NvCtrlValidValuesCacheStore() */
+
+
+
+/*
+ * NvCtrlValidValuesCacheDrop() - the attribute is no longer available
+ * for the handle's target: forget its valid values, for all display
+ * devices, so that they are queried from the server again.
+ */
+
+void NvCtrlValidValuesCacheDrop(NvCtrlAttributePrivateHandle *h, int attr)
+{
+    ValidValuesCache *cache;
+    ValidValuesCacheRecord r, *tmp;
+    int i, n;
+
+    if (uncacheable(attr)) return;
+
+    pthread_mutex_lock(&caches_lock);
+
+    cache = get_cache(h);
+    if (!cache) goto done;
+
+    init_record(&r, h, 0, attr);
+
+    for (i = 0, n = 0; i < cache->num_added; i++) {
+        if (cache->added[i].target_type == r.target_type &&
+            cache->added[i].target_id == r.target_id &&
+            cache->added[i].attr == r.attr) {
+            continue;
+        }
+        cache->added[n++] = cache->added[i];
+    }
+    cache->num_added = n;
+
+    if (!is_dropped(cache, &r)) {
+        tmp = realloc(cache->dropped, (cache->num_dropped + 1) *
+                      sizeof(ValidValuesCacheRecord));
+        if (!tmp) goto done;
+        cache->dropped = tmp;
+        cache->dropped[cache->num_dropped++] = r;
+    }
+
+    cache->dirty = True;
+
+ done:
+    pthread_mutex_unlock(&caches_lock);
+
+} /* NvCtrlValidValuesCacheDrop() */
+
+
+
+/*
+ * write_records() - write the merge of the mapped and added records;
+ * where both have a record for the same key, the added one wins.
+ * Mapped records of dropped attributes are left out.
+ */
+
+static int write_records(FILE *fp, const ValidValuesCache *cache)
+{
+    int i = 0, j = 0, n = 0;
+    const ValidValuesCacheRecord *r;
+
+    while (i < cache->num_records || j < cache->num_added) {
+        if (i < cache->num_records &&
+            is_dropped(cache, &cache->records[i])) {
+            i++;
+            continue;
+        }
+
+        if (i == cache->num_records) {
+            r = &cache->added[j++];
+        } else if (j == cache->num_added) {
+            r = &cache->records[i++];
+        } else {
+            int cmp = compare_records(&cache->records[i], &cache->added[j]);
+            if (cmp < 0) {
+                r = &cache->records[i++];
+            } else {
+                if (cmp == 0) i++;
+                r = &cache->added[j++];
+            }
+        }
+        if (fwrite(r, sizeof(ValidValuesCacheRecord), 1, fp) != 1) {
+            return -1;
+        }
+        n++;
+    }
+
+    return n;
+
+} /* write_records() */
+
+
+
+/*
+ * save_cache() - write the cache back to disk, if anything was added
+ * to it.  The file is written under a temporary name and renamed into
+ * place, so that other nvidia-settings processes never map a partial
+ * file.  Called with caches_lock held.
+ */
+
+static void save_cache(ValidValuesCache *cache)
+{
+    ValidValuesCacheHeader header;
+    char *dir, *tmpname, pid[16];
+    FILE *fp;
+    int n;
+
+    if (cache->disabled || !cache->dirty) return;
+
+    dir = tilde_expansion(VALID_VALUES_CACHE_DIR);
+    mkdir(dir, 0700);
+    free(dir);
+
+    snprintf(pid, sizeof(pid), ".%d", (int) getpid());
+    tmpname = nvstrcat(cache->filename, pid, NULL);
+
+    fp = fopen(tmpname, "w");
+    if (!fp) {
+        free(tmpname);
+        return;
+    }
+
+    memset(&header, 0, sizeof(header));
+    header.magic = VALID_VALUES_CACHE_MAGIC;
+    header.format = VALID_VALUES_CACHE_FORMAT;
+    header.record_size = sizeof(ValidValuesCacheRecord);
+    memcpy(header.driver_version, cache->driver_version,
+           DRIVER_VERSION_LEN);
+
+    /* write the header again, with the count, once it is known */
+
+    n = -1;
+    if (fwrite(&header, sizeof(header), 1, fp) == 1) {
+        n = write_records(fp, cache);
+    }
+    if (n >= 0) {
+        header.count = n;
+        if ((fseek(fp, 0, SEEK_SET) != 0) ||
+            (fwrite(&header, sizeof(header), 1, fp) != 1)) {
+            n = -1;
+        }
+    }
+
+    if ((fclose(fp) != 0) || (n < 0) ||
+        (rename(tmpname, cache->filename) != 0)) {
+        unlink(tmpname);
+    } else {
+        cache->dirty = False;
+    }
+
+    free(tmpname);
+
+} /* save_cache() */
+
+
+
+/*
+ * NvCtrlValidValuesCacheRelease() - the handle is being closed; when
+ * it is the last handle using its display's cache (i.e., the display
+ * is about to be closed), save the cache, and forget the Display: the
+ * same pointer may later be handed out for a connection to a
+ * different X server.
+ */
+
+void NvCtrlValidValuesCacheRelease(NvCtrlAttributePrivateHandle *h)
+{
+    ValidValuesCache *cache;
+
+    pthread_mutex_lock(&caches_lock);
+
+    cache = h->valid_values_cache;
+    h->valid_values_cache = NULL;
+
+    if (cache && --cache->refs == 0) {
+        save_cache(cache);
+        cache->dpy = NULL;
+    }
+
+    pthread_mutex_unlock(&caches_lock);
+
+} /* NvCtrlValidValuesCacheRelease() */
@@ -33,8 +33,10 @@
 #include <string.h>
 #include <math.h>
 
-static unsigned short computeVal(NvCtrlAttributePrivateHandle *,
-                                 int, float, float, float);
+static void computeRamp(NvCtrlAttributePrivateHandle *, int *, float, float);
+
+static Bool applyBrightness(NvCtrlAttributePrivateHandle *, unsigned short *,
+                            const int *, float);
 
 #define RED   RED_CHANNEL_INDEX
 #define GREEN GREEN_CHANNEL_INDEX
@@ -53,16 +55,29 @@ static unsigned short computeVal(NvCtrlAttributePrivateHandle *,
  * protocol; older versions trigger an error on
  * XF86VidModeGetGammaRampSize(), but newer versions appear to only
  * error on XF86VidModeSetGammaRamp().
+ *
+ * The error handler is process-wide, but other threads may be using
+ * other displays meanwhile (see fanout.h); so only errors from the
+ * display being probed are checked, and each probe records whether
+ * its own display blocked us.  NvCtrlInitSubsystems() serializes the
+ * probes, so only one is in progress at a time.
  */
 
-static Bool vidModeBlocked = False;
-static int vidModeErrorBase = 0;
+typedef struct {
+    Display *dpy;
+    int error_base;
+    Bool blocked;
+} VidModeProbe;
+
+static VidModeProbe *vidModeProbe = NULL;
 static int (*prev_error_handler)(Display *, XErrorEvent *) = NULL;
 
 static int vidModeErrorHandler(Display *dpy, XErrorEvent *err)
 {
-    if (err->error_code == (XF86VidModeClientNotLocal + vidModeErrorBase)) {
-        vidModeBlocked = True;
+    if (vidModeProbe && (dpy == vidModeProbe->dpy) &&
+        (err->error_code ==
+         (XF86VidModeClientNotLocal + vidModeProbe->error_base))) {
+        vidModeProbe->blocked = True;
     } else {
         if (prev_error_handler) prev_error_handler(dpy, err);
     }
@@ -76,6 +91,7 @@ NvCtrlVidModeAttributes *
 NvCtrlInitVidModeAttributes(NvCtrlAttributePrivateHandle *h)
 {
     NvCtrlVidModeAttributes *vm = NULL;
+    VidModeProbe probe;
     int ret, event, i;
     
 
@@ -84,10 +100,13 @@ NvCtrlInitVidModeAttributes(NvCtrlAttributePrivateHandle *h)
         goto failed;
     }
 
-    ret = XF86VidModeQueryExtension(h->dpy, &event, &vidModeErrorBase);
+    memset(&probe, 0, sizeof(probe));
+    probe.dpy = h->dpy;
+
+    ret = XF86VidModeQueryExtension(h->dpy, &event, &probe.error_base);
     if (ret != True) goto failed;
 
-    vm = malloc(sizeof(NvCtrlVidModeAttributes));
+    vm = calloc(1, sizeof(NvCtrlVidModeAttributes));
 
     ret = XF86VidModeQueryVersion(h->dpy, &(vm->major_version), &(vm->minor_version));
     if (ret != True) goto failed;
@@ -108,13 +127,14 @@ NvCtrlInitVidModeAttributes(NvCtrlAttributePrivateHandle *h)
      * original error handler below
      */
     
+    vidModeProbe = &probe;
     prev_error_handler = XSetErrorHandler(vidModeErrorHandler);
     
     ret = XF86VidModeGetGammaRampSize(h->dpy, h->target_id, &vm->n);
     
     /* check if XF86VidModeGetGammaRampSize was blocked */
     
-    if (vidModeBlocked) {
+    if (probe.blocked) {
         goto blocked;
     }
     
@@ -129,7 +149,7 @@ NvCtrlInitVidModeAttributes(NvCtrlAttributePrivateHandle *h)
     
     /* check if XF86VidModeGetGammaRamp was blocked */
 
-    if (vidModeBlocked) {
+    if (probe.blocked) {
         goto blocked;
     }
 
@@ -157,13 +177,15 @@ NvCtrlInitVidModeAttributes(NvCtrlAttributePrivateHandle *h)
 
     /* check if XF86VidModeSetGammaRamp was blocked */
     
-    if (vidModeBlocked) {
+    if (probe.blocked) {
         goto blocked;
     }
     
     /* finally, restore the original error handler */
     
     XSetErrorHandler(prev_error_handler);
+    prev_error_handler = NULL;
+    vidModeProbe = NULL;
     
     /*
      * XXX can we initialize this to anything based on the current
@@ -174,6 +196,7 @@ NvCtrlInitVidModeAttributes(NvCtrlAttributePrivateHandle *h)
         vm->brightness[i] = BRIGHTNESS_DEFAULT;
         vm->contrast[i]   = CONTRAST_DEFAULT;
         vm->gamma[i]      = GAMMA_DEFAULT;
+        vm->ramp[i]       = NULL; /* computed on first use */
     }
     
     /* take log2 of vm->n to find the sigbits */
@@ -199,9 +222,11 @@ NvCtrlInitVidModeAttributes(NvCtrlAttributePrivateHandle *h)
     /* restore the original error handler, if we overrode it */
 
     if (prev_error_handler) {
+        XSync(h->dpy, False);
         XSetErrorHandler(prev_error_handler);
         prev_error_handler = NULL;
     }
+    vidModeProbe = NULL;
 
     return NULL;
 
@@ -218,6 +243,7 @@ ReturnStatus NvCtrlGetColorAttributes(NvCtrlAttributeHandle *handle,
     
     h = (NvCtrlAttributePrivateHandle *) handle;
 
+    NvCtrlInitSubsystems(h, NV_CTRL_ATTRIBUTES_XF86VIDMODE_SUBSYSTEM);
     if (!h->vm) return NvCtrlMissingExtension;
 
     for (i = RED; i <= BLUE; i++) {
@@ -242,12 +268,13 @@ ReturnStatus NvCtrlGetColorAttributes(NvCtrlAttributeHandle *handle,
  * GREEN_CHANNEL, and BLUE_CHANNEL) and which values (CONTRAST_VALUE,
  * BRIGHTNESS_VALUE, GAMMA_VALUE) should be updated.
  *
- * XXX future optimization: if each channel has the same c/b/g values,
- * don't need to compute the ramp separately per channel.
- *
- * XXX future optimization: if the input is the same as what we
- * already have, we don't actually need to recompute the ramp and send
- * it to the X server.
+ * The ramp is computed in two steps: contrast and gamma (which need
+ * pow()) produce a per-channel ramp that is kept in h->vm->ramp[] and
+ * only recomputed when that channel's contrast or gamma changes, or
+ * copied from another channel with the same contrast and gamma;
+ * brightness is then applied to it with integer arithmetic.  If the
+ * resulting LUT is identical to the one last sent, nothing is sent to
+ * the X server.
  */
 
 ReturnStatus NvCtrlSetColorAttributes(NvCtrlAttributeHandle *handle,
@@ -256,8 +283,8 @@ ReturnStatus NvCtrlSetColorAttributes(NvCtrlAttributeHandle *handle,
                                       float g[3],
                                       unsigned int bitmask)
 {
-    int i, ch;
-    Bool ret;
+    int ch, other;
+    Bool ret, changed = False;
     
     NvCtrlAttributePrivateHandle *h;
 
@@ -267,6 +294,7 @@ ReturnStatus NvCtrlSetColorAttributes(NvCtrlAttributeHandle *handle,
     if (!h || !h->dpy || h->target_type != NV_CTRL_TARGET_TYPE_X_SCREEN) {
         return NvCtrlBadHandle;
     }
+    NvCtrlInitSubsystems(h, NV_CTRL_ATTRIBUTES_XF86VIDMODE_SUBSYSTEM);
     if (!h->vm) return NvCtrlMissingExtension;
 
     /* clamp input, but only the input specified in the bitmask */
@@ -310,12 +338,41 @@ ReturnStatus NvCtrlSetColorAttributes(NvCtrlAttributeHandle *handle,
 
     for (ch = RED; ch <= BLUE; ch++) {
         if ( !(bitmask & (1 << ch))) continue; /* don't update this channel */
-        for (i = 0; i < h->vm->n; i++) {
-            h->vm->lut[ch][i] = computeVal(h, i, h->vm->contrast[ch],
-                                           h->vm->brightness[ch],
-                                           h->vm->gamma[ch]);
+
+        if (!h->vm->ramp[ch]) {
+            h->vm->ramp[ch] = malloc(sizeof(int) * h->vm->n);
+            if (!h->vm->ramp[ch]) return NvCtrlError;
+        } else if (h->vm->ramp_contrast[ch] == h->vm->contrast[ch] &&
+                   h->vm->ramp_gamma[ch] == h->vm->gamma[ch]) {
+            goto apply; /* contrast and gamma unchanged */
         }
+
+        /* reuse another channel's ramp if it has the same parameters */
+
+        for (other = RED; other <= BLUE; other++) {
+            if (other != ch && h->vm->ramp[other] &&
+                h->vm->ramp_contrast[other] == h->vm->contrast[ch] &&
+                h->vm->ramp_gamma[other] == h->vm->gamma[ch]) break;
+        }
+
+        if (other <= BLUE) {
+            memcpy(h->vm->ramp[ch], h->vm->ramp[other],
+                   sizeof(int) * h->vm->n);
+        } else {
+            computeRamp(h, h->vm->ramp[ch], h->vm->contrast[ch],
+                        h->vm->gamma[ch]);
+        }
+        h->vm->ramp_contrast[ch] = h->vm->contrast[ch];
+        h->vm->ramp_gamma[ch] = h->vm->gamma[ch];
+
+    apply:
+        changed |= applyBrightness(h, h->vm->lut[ch], h->vm->ramp[ch],
+                                   h->vm->brightness[ch]);
     }
+
+    /* nothing to send if the LUT did not change */
+
+    if (!changed) return NvCtrlSuccess;
     
     ret = XF86VidModeSetGammaRamp(h->dpy, h->target_id, h->vm->n,
                                   h->vm->lut[RED],
@@ -342,6 +399,7 @@ ReturnStatus NvCtrlGetColorRamp(NvCtrlAttributeHandle *handle,
     if (!h || !h->dpy || h->target_type != NV_CTRL_TARGET_TYPE_X_SCREEN) {
         return NvCtrlBadHandle;
     }
+    NvCtrlInitSubsystems(h, NV_CTRL_ATTRIBUTES_XF86VIDMODE_SUBSYSTEM);
     if (!h->vm) return NvCtrlMissingExtension;
 
     *n = h->vm->n;
@@ -358,62 +416,91 @@ ReturnStatus NvCtrlGetColorRamp(NvCtrlAttributeHandle *handle,
 
 
 /*
- * computeVal() - compute the LUT entry given its index, and the
- * contrast, brightness, and gamma.
+ * computeRamp() - compute the ramp for the given contrast and gamma,
+ * before brightness is applied, into ramp[0..n-1].
  */
-static unsigned short computeVal(NvCtrlAttributePrivateHandle *h,
-                                 int i, float c, float b, float g)
+static void computeRamp(NvCtrlAttributePrivateHandle *h,
+                        int *ramp, float c, float g)
 {
-    double j, half, scale;
-    int shift, val, num;
+    double j, half, factor, scale;
+    int i, num;
     
     num = h->vm->n - 1;
-    shift = 16 - h->vm->sigbits;
     
     scale = (double) num / 3.0; /* how much brightness and contrast
                                    affect the value */
-    j = (double) i;
-    
-    /* contrast */
+
+    /* contrast is a linear function of the index */
 
     c *= scale;
 
     if (c > 0.0) {
         half = ((double) num / 2.0) - 1.0;
-        j -= half;
-        j *= half / (half - c);
-        j += half;
+        factor = half / (half - c);
     } else {
         half = (double) num / 2.0;
-        j -= half;
-        j *= (half + c) / half;
-        j += half;
+        factor = (half + c) / half;
     }
-    
-    if (j < 0.0) j = 0.0;
-            
-    /* gamma */
 
     g = 1.0 / (double) g;
     
-    if (g == 1.0) {
-        val = (int) j;
-    } else {
-        val = (int) (pow (j / (double)num, g) * (double)num + 0.5);
-    }
+    for (i = 0; i <= num; i++) {
+
+        /* contrast */
 
-    /* brightness */
+        j = (double) i;
+        j -= half;
+        j *= factor;
+        j += half;
+
+        if (j < 0.0) j = 0.0;
+
+        /* gamma */
+
+        if (g == 1.0) {
+            ramp[i] = (int) j;
+        } else {
+            ramp[i] = (int) (pow (j / (double)num, g) * (double)num + 0.5);
+        }
+    }
     
+} /* computeRamp() */
+
+
+
+/*
+ * applyBrightness() - apply the brightness to a ramp computed by
+ * computeRamp(), and store the result in lut[0..n-1]; returns True if
+ * lut changed.
+ */
+static Bool applyBrightness(NvCtrlAttributePrivateHandle *h,
+                            unsigned short *lut, const int *ramp, float b)
+{
+    double scale;
+    int i, val, num, shift, offset;
+    Bool changed = False;
+
+    num = h->vm->n - 1;
+    shift = 16 - h->vm->sigbits;
+
+    scale = (double) num / 3.0; /* how much brightness and contrast
+                                   affect the value */
     b *= scale;
+    offset = (int) b;
 
-    val += (int)b;
-    if (val > num) val = num;
-    if (val < 0) val = 0;
-    
-    val <<= shift;
-    return (unsigned short) val;
-    
-} /* computeVal() */
+    for (i = 0; i <= num; i++) {
+        val = ramp[i] + offset;
+        if (val > num) val = num;
+        if (val < 0) val = 0;
+
+        val <<= shift;
+        changed |= (lut[i] != (unsigned short) val);
+        lut[i] = (unsigned short) val;
+    }
+
+    return changed;
+
+} /* applyBrightness() */
 
 
 /*
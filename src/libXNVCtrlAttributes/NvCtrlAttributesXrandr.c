@@ -244,14 +244,23 @@ static void close_libxrandr(void)
  * that by temporarily installing an error handler, trying the call, and then
  * disabling the rotation page if it fails.
  *
+ * The error handler is process-wide, but other threads may be using
+ * other displays meanwhile (see fanout.h); errors from those displays
+ * are passed on to the original handler.  NvCtrlInitSubsystems()
+ * serializes the probes, so only one is in progress at a time.
+ *
  ****/
 
 static int errors = 0;
+static Display *error_dpy = NULL;
 static int (*old_error_handler)(Display *, XErrorEvent *);
 
 static int
 error_handler (Display *dpy, XErrorEvent *err)
 {
+    if ( dpy != error_dpy ) {
+        return old_error_handler ? old_error_handler(dpy, err) : 0;
+    }
     errors++;
     return 0;
 
@@ -259,6 +268,80 @@ error_handler (Display *dpy, XErrorEvent *err)
 
 
 
+/******************************************************************************
+ *
+ * XRRGetScreenInfo() issues several requests, so the screen configuration
+ * is kept on the handle until the screen changes.  Any RRScreenChangeNotify
+ * event, or any change made through this library, bumps the generation
+ * below; a cached configuration from an older generation is refetched.
+ *
+ * The configuration is only kept when the caller passes the
+ * RRScreenChangeNotify events of the screen on to this library (see
+ * NvCtrlXrandrTrackScreenChanges()); otherwise, there is no telling
+ * when another client changed the screen, and it is always refetched.
+ * It is also refetched before any change, so that XRRSetScreenConfig()
+ * is given the current configuration timestamp.
+ *
+ ****/
+
+static unsigned int screen_config_generation = 1;
+
+static XRRScreenConfiguration *
+get_screen_config(NvCtrlAttributePrivateHandle *h, Bool for_set)
+{
+    NvCtrlXrandrAttributes *xrandr = h->xrandr;
+
+    if ( xrandr->sc && xrandr->sc_tracked && !for_set &&
+         xrandr->sc_generation == screen_config_generation ) {
+        return xrandr->sc;
+    }
+
+    if ( xrandr->sc ) {
+        __libXrandr->XRRFreeScreenConfigInfo(xrandr->sc);
+    }
+    xrandr->sc = __libXrandr->XRRGetScreenInfo(h->dpy,
+                                               RootWindow(h->dpy,
+                                                          h->target_id));
+    xrandr->sc_generation = screen_config_generation;
+
+    return xrandr->sc;
+
+} /* get_screen_config() */
+
+
+
+/******************************************************************************
+ *
+ * Drops all cached screen configurations; called when an
+ * RRScreenChangeNotify event is received.
+ *
+ ****/
+
+void
+NvCtrlXrandrInvalidateScreenConfig (NvCtrlAttributePrivateHandle *h)
+{
+    screen_config_generation++;
+
+} /* NvCtrlXrandrInvalidateScreenConfig() */
+
+
+
+/******************************************************************************
+ *
+ * Lets the screen configuration be cached, until the next call to
+ * NvCtrlXrandrInvalidateScreenConfig().
+ *
+ ****/
+
+void
+NvCtrlXrandrTrackScreenConfig (NvCtrlAttributePrivateHandle *h)
+{
+    h->xrandr->sc_tracked = True;
+
+} /* NvCtrlXrandrTrackScreenConfig() */
+
+
+
 /******************************************************************************
  *
  * Initializes the NvCtrlXrandrAttributes Extension by linking the
@@ -296,6 +379,7 @@ NvCtrlInitXrandrAttributes (NvCtrlAttributePrivateHandle *h)
 
     XSync(h->dpy, False);
     errors = 0;
+    error_dpy = h->dpy;
     old_error_handler = XSetErrorHandler(error_handler);
     
     /* Verify server support of XRandR extension */
@@ -326,7 +410,8 @@ NvCtrlInitXrandrAttributes (NvCtrlAttributePrivateHandle *h)
     sc = __libXrandr->XRRGetScreenInfo(h->dpy, RootWindow(h->dpy, h->target_id));
     if ( sc ) {
         rotations = __libXrandr->XRRConfigRotations(sc, &rotation);
-        __libXrandr->XRRFreeScreenConfigInfo(sc);
+        xrandr->sc = sc;
+        xrandr->sc_generation = screen_config_generation;
     } else {
         errors++;
     }
@@ -341,6 +426,9 @@ NvCtrlInitXrandrAttributes (NvCtrlAttributePrivateHandle *h)
 
  fail:
     if ( xrandr ) {
+        if ( xrandr->sc ) {
+            __libXrandr->XRRFreeScreenConfigInfo(xrandr->sc);
+        }
         free(xrandr);
     }
     return NULL;
@@ -364,6 +452,10 @@ NvCtrlXrandrAttributesClose (NvCtrlAttributePrivateHandle *h)
         return;
     }
 
+    if ( h->xrandr->sc ) {
+        __libXrandr->XRRFreeScreenConfigInfo(h->xrandr->sc);
+    }
+
     close_libxrandr();
 
     free(h->xrandr);
@@ -400,13 +492,11 @@ NvCtrlXrandrGetAttribute (NvCtrlAttributePrivateHandle *h,
 
 
     /* Get current screen configuration information */
-    sc = __libXrandr->XRRGetScreenInfo(h->dpy, RootWindow(h->dpy,
-                                                          h->target_id));
+    sc = get_screen_config(h, False);
     if ( !sc ) {
         return NvCtrlError;
     }
     rotations = __libXrandr->XRRConfigRotations(sc, &rotation);
-    __libXrandr->XRRFreeScreenConfigInfo(sc);
 
 
     /* Fetch right attribute */
@@ -460,8 +550,7 @@ set_rotation(NvCtrlAttributePrivateHandle *h, Rotation rotation)
     assert(h->target_type == NV_CTRL_TARGET_TYPE_X_SCREEN);
 
     /* Get current screen configuration information */
-    sc = __libXrandr->XRRGetScreenInfo(h->dpy, RootWindow(h->dpy,
-                                                          h->target_id));
+    sc = get_screen_config(h, True);
     if ( !sc ) {
         return NvCtrlError;
     }
@@ -471,7 +560,6 @@ set_rotation(NvCtrlAttributePrivateHandle *h, Rotation rotation)
 
     /* Check orientation we want is supported */
     if ( !(rotations & rotation) ) {
-        __libXrandr->XRRFreeScreenConfigInfo(sc);
         return NvCtrlBadArgument;
     }
 
@@ -480,7 +568,7 @@ set_rotation(NvCtrlAttributePrivateHandle *h, Rotation rotation)
     ret = __libXrandr->XRRSetScreenConfig(h->dpy, sc,
                                           RootWindow(h->dpy, h->target_id),
                                           cur_size, rotation, CurrentTime);
-    __libXrandr->XRRFreeScreenConfigInfo(sc);
+    screen_config_generation++;
     
     return ( ret == Success )?NvCtrlSuccess:NvCtrlError;
 
@@ -586,8 +674,7 @@ NvCtrlXrandrSetScreenMagicMode (NvCtrlAttributePrivateHandle *h,
 
 
     /* Get current screen configuration information */
-    sc = __libXrandr->XRRGetScreenInfo(h->dpy, RootWindow(h->dpy,
-                                                          h->target_id));
+    sc = get_screen_config(h, True);
     if ( !sc ) {
         return NvCtrlError;
     }
@@ -613,7 +700,7 @@ NvCtrlXrandrSetScreenMagicMode (NvCtrlAttributePrivateHandle *h,
                     (h->dpy, sc, RootWindow(h->dpy, h->target_id), nsizes,
                      cur_rotation, magic_ref_rate, CurrentTime);
                 
-                __libXrandr->XRRFreeScreenConfigInfo(sc);
+                screen_config_generation++;
                 return (ret == Success)?NvCtrlSuccess:NvCtrlError;
             }
             rates++;
@@ -621,7 +708,6 @@ NvCtrlXrandrSetScreenMagicMode (NvCtrlAttributePrivateHandle *h,
     }
     
     /* If we are here, then we could not find the correct mode to set */
-    __libXrandr->XRRFreeScreenConfigInfo(sc);
     return NvCtrlError;
 
 } /* NvCtrlXrandrSetScreenMagicMode */
@@ -657,8 +743,7 @@ NvCtrlXrandrGetScreenMagicMode (NvCtrlAttributePrivateHandle *h,
 
 
     /* Get current screen configuration information */
-    sc = __libXrandr->XRRGetScreenInfo(h->dpy, RootWindow(h->dpy,
-                                                          h->target_id));
+    sc = get_screen_config(h, False);
     if ( !sc ) {
         return NvCtrlError;
     }
@@ -666,7 +751,6 @@ NvCtrlXrandrGetScreenMagicMode (NvCtrlAttributePrivateHandle *h,
     cur_rate = __libXrandr->XRRConfigCurrentRate(sc);
     sizes    = __libXrandr->XRRConfigSizes(sc, &nsizes);
     if (cur_size >= nsizes) {
-        __libXrandr->XRRFreeScreenConfigInfo(sc);
         return NvCtrlError;
     }
 
@@ -676,7 +760,6 @@ NvCtrlXrandrGetScreenMagicMode (NvCtrlAttributePrivateHandle *h,
     *height = sizes[cur_size].height;
     *magic_ref_rate = (int)cur_rate;
     
-    __libXrandr->XRRFreeScreenConfigInfo(sc);
     return NvCtrlSuccess;
 
 } /* NvCtrlXrandrGetScreenMagicMode */
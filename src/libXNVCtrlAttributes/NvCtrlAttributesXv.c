@@ -33,8 +33,32 @@
 
 #include "msg.h"
 
-static NvCtrlXvAttribute *getXvAttribute (NvCtrlAttributePrivateHandle *,
-                                          XvPortID, const char *);
+/*
+ * The Xv port attributes that are used; xv_attribute_names[] is indexed
+ * by these.
+ */
+
+enum {
+    XV_ATTR_SATURATION = 0,
+    XV_ATTR_CONTRAST,
+    XV_ATTR_BRIGHTNESS,
+    XV_ATTR_HUE,
+    XV_ATTR_SET_DEFAULTS,
+    XV_ATTR_SYNC_TO_VBLANK,
+    XV_ATTR_NUM
+};
+
+static char *xv_attribute_names[XV_ATTR_NUM] = {
+    [XV_ATTR_SATURATION]     = "XV_SATURATION",
+    [XV_ATTR_CONTRAST]       = "XV_CONTRAST",
+    [XV_ATTR_BRIGHTNESS]     = "XV_BRIGHTNESS",
+    [XV_ATTR_HUE]            = "XV_HUE",
+    [XV_ATTR_SET_DEFAULTS]   = "XV_SET_DEFAULTS",
+    [XV_ATTR_SYNC_TO_VBLANK] = "XV_SYNC_TO_VBLANK",
+};
+
+static void getXvPortAttributes(NvCtrlAttributePrivateHandle *, XvPortID,
+                                const Atom *, NvCtrlXvAttribute **);
 
 static Bool checkAdaptor(NvCtrlAttributePrivateHandle *h,
                          unsigned int attribute);
@@ -181,6 +205,8 @@ NvCtrlXvAttributes * NvCtrlInitXvAttributes(NvCtrlAttributePrivateHandle *h)
     XvAdaptorInfo *ainfo;
     unsigned int req, event_base, error_base, nadaptors;
     int ret, i;
+    Atom atoms[XV_ATTR_NUM];
+    NvCtrlXvAttribute *index[XV_ATTR_NUM];
     const char *error_str = NULL;
     const char *warn_str = NULL;
     
@@ -221,6 +247,10 @@ NvCtrlXvAttributes * NvCtrlInitXvAttributes(NvCtrlAttributePrivateHandle *h)
                                    &nadaptors, &ainfo);
 
     if (ret != Success || !nadaptors || !ainfo) goto fail;
+
+
+    /* Look up the atoms for all the attribute names in one request */
+    XInternAtoms(h->dpy, xv_attribute_names, XV_ATTR_NUM, True, atoms);
     
     for (i = 0; i < nadaptors; i++) {
         
@@ -236,16 +266,13 @@ NvCtrlXvAttributes * NvCtrlInitXvAttributes(NvCtrlAttributePrivateHandle *h)
             }
         
             attrs->port = ainfo[i].base_id;
-            attrs->saturation = getXvAttribute(h, attrs->port,
-                                               "XV_SATURATION");
-            attrs->contrast   = getXvAttribute(h, attrs->port,
-                                               "XV_CONTRAST");
-            attrs->brightness = getXvAttribute(h, attrs->port,
-                                               "XV_BRIGHTNESS");
-            attrs->hue        = getXvAttribute(h, attrs->port,
-                                               "XV_HUE");
-            attrs->defaults   = getXvAttribute(h, attrs->port,
-                                               "XV_SET_DEFAULTS");
+            getXvPortAttributes(h, attrs->port, atoms, index);
+            attrs->saturation = index[XV_ATTR_SATURATION];
+            attrs->contrast   = index[XV_ATTR_CONTRAST];
+            attrs->brightness = index[XV_ATTR_BRIGHTNESS];
+            attrs->hue        = index[XV_ATTR_HUE];
+            attrs->defaults   = index[XV_ATTR_SET_DEFAULTS];
+            free(index[XV_ATTR_SYNC_TO_VBLANK]);
         
             if (!attrs->saturation ||
                 !attrs->contrast ||
@@ -278,22 +305,21 @@ NvCtrlXvAttributes * NvCtrlInitXvAttributes(NvCtrlAttributePrivateHandle *h)
             }
 
             attrs->port = ainfo[i].base_id;
-            attrs->sync_to_vblank = getXvAttribute(h, attrs->port,
-                                                   "XV_SYNC_TO_VBLANK");
-            attrs->contrast       = getXvAttribute(h, attrs->port,
-                                                   "XV_CONTRAST");
-            attrs->brightness     = getXvAttribute(h, attrs->port,
-                                                   "XV_BRIGHTNESS");
-            attrs->saturation     = getXvAttribute(h, attrs->port,
-                                                   "XV_SATURATION");
-            attrs->hue            = getXvAttribute(h, attrs->port,
-                                                   "XV_HUE");
-            attrs->defaults       = getXvAttribute(h, attrs->port,
-                                                   "XV_SET_DEFAULTS");
+            getXvPortAttributes(h, attrs->port, atoms, index);
+            attrs->sync_to_vblank = index[XV_ATTR_SYNC_TO_VBLANK];
+            attrs->contrast       = index[XV_ATTR_CONTRAST];
+            attrs->brightness     = index[XV_ATTR_BRIGHTNESS];
+            attrs->saturation     = index[XV_ATTR_SATURATION];
+            attrs->hue            = index[XV_ATTR_HUE];
+            attrs->defaults       = index[XV_ATTR_SET_DEFAULTS];
             if (!attrs->sync_to_vblank ||
                 !attrs->defaults) {
                 
                 if (attrs->sync_to_vblank) free(attrs->sync_to_vblank);
+                if (attrs->contrast)       free(attrs->contrast);
+                if (attrs->brightness)     free(attrs->brightness);
+                if (attrs->saturation)     free(attrs->saturation);
+                if (attrs->hue)            free(attrs->hue);
                 if (attrs->defaults)       free(attrs->defaults);
                 
                 free(attrs);
@@ -315,10 +341,13 @@ NvCtrlXvAttributes * NvCtrlInitXvAttributes(NvCtrlAttributePrivateHandle *h)
             }
 
             attrs->port = ainfo[i].base_id;
-            attrs->sync_to_vblank = getXvAttribute(h, attrs->port,
-                                                   "XV_SYNC_TO_VBLANK");
-            attrs->defaults       = getXvAttribute(h, attrs->port,
-                                                   "XV_SET_DEFAULTS");
+            getXvPortAttributes(h, attrs->port, atoms, index);
+            attrs->sync_to_vblank = index[XV_ATTR_SYNC_TO_VBLANK];
+            attrs->defaults       = index[XV_ATTR_SET_DEFAULTS];
+            free(index[XV_ATTR_SATURATION]);
+            free(index[XV_ATTR_CONTRAST]);
+            free(index[XV_ATTR_BRIGHTNESS]);
+            free(index[XV_ATTR_HUE]);
             if (!attrs->sync_to_vblank ||
                 !attrs->defaults) {
                 
@@ -490,36 +519,45 @@ NvCtrlXvGetValidAttributeValues(NvCtrlAttributePrivateHandle *h, int attr,
 
 
 /*
- * getXvAttribute() - loop through the attributes for the given port,
- * looking for the attribute specified by 'name'.  If the named
- * attribute is found, get its minimum and maximum values, and (if
- * possible) get its current value.  Return a malloced and initialized
- * NvCtrlXvAttribute struct if successful, otherwise return NULL.
+ * getXvPortAttributes() - query the attributes of the given port once,
+ * and fill in index[] (indexed by the XV_ATTR_* enum) with a malloced
+ * and initialized NvCtrlXvAttribute for each of the attributes in
+ * xv_attribute_names[] that the port supports; entries for attributes
+ * that are missing or not settable are set to NULL.  'atoms' holds the
+ * atoms for xv_attribute_names[], as returned by XInternAtoms().
  */
 
-static NvCtrlXvAttribute *getXvAttribute(NvCtrlAttributePrivateHandle *h,
-                                         XvPortID port,
-                                         const char *name)
+static void getXvPortAttributes(NvCtrlAttributePrivateHandle *h,
+                                XvPortID port, const Atom *atoms,
+                                NvCtrlXvAttribute **index)
 {
-    NvCtrlXvAttribute *attr = NULL;
+    NvCtrlXvAttribute *attr;
     XvAttribute *attributes = NULL;
-    int i, n;
-    
+    int i, j, n;
+
+    memset(index, 0, XV_ATTR_NUM * sizeof(NvCtrlXvAttribute *));
+
     attributes = __libXv->XvQueryPortAttributes(h->dpy, port, &n);
 
-    if (!attributes || !n) goto failed;
+    if (!attributes || !n) goto done;
     
     for (i = 0; i < n; i++) {
-        if (strcmp(attributes[i].name, name) != 0) continue;
+
+        for (j = 0; j < XV_ATTR_NUM; j++) {
+            if (strcmp(attributes[i].name, xv_attribute_names[j]) == 0) break;
+        }
+        if (j == XV_ATTR_NUM || index[j]) continue;
+
+        if (atoms[j] == None) continue;
+        if (! (attributes[i].flags & XvSettable)) continue;
 
         attr = malloc(sizeof(NvCtrlXvAttribute));
+        if (!attr) continue;
+        
         attr->range.type = ATTRIBUTE_TYPE_RANGE;
         attr->range.u.range.min = attributes[i].min_value;
         attr->range.u.range.max = attributes[i].max_value;
-        attr->atom = XInternAtom(h->dpy, name, True);
-        if (attr->atom == None) goto failed;
-        
-        if (! (attributes[i].flags & XvSettable)) goto failed;
+        attr->atom = atoms[j];
         
         attr->range.permissions = ATTRIBUTE_TYPE_WRITE;
         
@@ -531,19 +569,13 @@ static NvCtrlXvAttribute *getXvAttribute(NvCtrlAttributePrivateHandle *h,
 
         attr->range.permissions |= ATTRIBUTE_TYPE_X_SCREEN;
 
-        break;
+        index[j] = attr;
     }
 
+ done:
     if (attributes) XFree(attributes);
 
-    return attr;
-
- failed:
-    if (attr) free(attr);
-    if (attributes) XFree(attributes);
-    return NULL;
-
-} /* getXvAttribute() */
+} /* getXvPortAttributes() */
 
 
 
@@ -8,6 +8,9 @@ LIB_XNVCTRL_ATTRIBUTES_SRC += NvCtrlAttributesVidMode.c
 LIB_XNVCTRL_ATTRIBUTES_SRC += NvCtrlAttributesXv.c
 LIB_XNVCTRL_ATTRIBUTES_SRC += NvCtrlAttributesGlx.c
 LIB_XNVCTRL_ATTRIBUTES_SRC += NvCtrlAttributesXrandr.c
+LIB_XNVCTRL_ATTRIBUTES_SRC += NvCtrlAttributesCache.c
+LIB_XNVCTRL_ATTRIBUTES_SRC += NvCtrlAttributesState.c
+LIB_XNVCTRL_ATTRIBUTES_SRC += NvCtrlAttributesValidValuesCache.c
 
 LIB_XNVCTRL_ATTRIBUTES_EXTRA_DIST += NvCtrlAttributes.h
 LIB_XNVCTRL_ATTRIBUTES_EXTRA_DIST += NvCtrlAttributesPrivate.h
@@ -31,6 +31,7 @@
 #include <ctype.h>
 #include <string.h>
 #include <unistd.h>
+#include <pthread.h>
 #include <sys/ioctl.h>
 #if defined(__sun)
 #include <sys/termios.h>
@@ -40,6 +41,8 @@ extern int __verbosity;
 
 static void format(FILE*, const char*, char *, int);
 static int get_terminal_width(void);
+static FILE *msg_stdout(void);
+static FILE *msg_stderr(void);
 
 #define NV_FORMAT(stream, prefix, fmt, whitespace) \
 do {                                               \
@@ -60,11 +63,11 @@ void nv_error_msg(const char *fmt, ...)
 {
     if (__verbosity < VERBOSITY_ERROR) return;
 
-    fprintf(stderr, "\n");
+    fprintf(msg_stderr(), "\n");
  
-    NV_FORMAT(stderr, "ERROR: ", fmt, False);
+    NV_FORMAT(msg_stderr(), "ERROR: ", fmt, False);
 
-    fprintf(stderr, "\n");
+    fprintf(msg_stderr(), "\n");
 
 } /* nv_error_msg() */
 
@@ -81,11 +84,11 @@ void nv_warning_msg(const char *fmt, ...)
 {
     if (__verbosity < VERBOSITY_WARNING) return;
 
-    fprintf(stdout, "\n");
+    fprintf(msg_stdout(), "\n");
 
-    NV_FORMAT(stdout, "WARNING: ", fmt, False);
+    NV_FORMAT(msg_stdout(), "WARNING: ", fmt, False);
 
-    fprintf(stdout, "\n");
+    fprintf(msg_stdout(), "\n");
     
 } /* nv_warning_msg() */
 
@@ -102,7 +105,7 @@ void nv_info_msg(const char *prefix, const char *fmt, ...)
 {
     if (__verbosity < VERBOSITY_ALL) return;
 
-    NV_FORMAT(stdout, prefix, fmt, False);
+    NV_FORMAT(msg_stdout(), prefix, fmt, False);
     
 } /* nv_info_msg() */
 
@@ -118,7 +121,7 @@ void nv_info_msg(const char *prefix, const char *fmt, ...)
 
 void nv_msg(const char *prefix, const char *fmt, ...)
 {
-    NV_FORMAT(stdout, prefix, fmt, False);
+    NV_FORMAT(msg_stdout(), prefix, fmt, False);
 
 } /* nv_msg() */
 
@@ -131,11 +134,93 @@ void nv_msg(const char *prefix, const char *fmt, ...)
 
 void nv_msg_preserve_whitespace(const char *prefix, const char *fmt, ...)
 {
-    NV_FORMAT(stdout, prefix, fmt, True);
+    NV_FORMAT(msg_stdout(), prefix, fmt, True);
 
 } /* nv_msg_preserve_whitespace() */
 
 
+/*
+ * nv_msg_set_thread_streams() - send the messages printed by the
+ * calling thread to 'out' and 'err' rather than to stdout and stderr;
+ * passing NULL for both restores stdout and stderr.  This lets
+ * threads working in parallel collect their output, so that it can be
+ * printed in a deterministic order once they are done.
+ */
+
+typedef struct {
+    FILE *out;
+    FILE *err;
+} MsgStreams;
+
+static pthread_key_t msg_streams_key;
+static pthread_once_t msg_streams_key_once = PTHREAD_ONCE_INIT;
+
+static void create_msg_streams_key(void)
+{
+    pthread_key_create(&msg_streams_key, free);
+}
+
+void nv_msg_set_thread_streams(FILE *out, FILE *err)
+{
+    MsgStreams *streams;
+
+    pthread_once(&msg_streams_key_once, create_msg_streams_key);
+
+    streams = pthread_getspecific(msg_streams_key);
+
+    if (!out && !err) {
+        free(streams);
+        pthread_setspecific(msg_streams_key, NULL);
+        return;
+    }
+
+    if (!streams) {
+        streams = malloc(sizeof(MsgStreams));
+        if (!streams) return;
+        pthread_setspecific(msg_streams_key, streams);
+    }
+
+    streams->out = out ? out : stdout;
+    streams->err = err ? err : stderr;
+
+} /* nv_msg_set_thread_streams() */
+
+
+static FILE *msg_stdout(void)
+{
+    MsgStreams *streams;
+
+    pthread_once(&msg_streams_key_once, create_msg_streams_key);
+    streams = pthread_getspecific(msg_streams_key);
+
+    return streams ? streams->out : stdout;
+}
+
+
+/*
+ * nv_msg_output_stream() - return the stream that nv_msg() prints to
+ * for the calling thread; for output that is written as is, rather
+ * than formatted as a message.
+ */
+
+FILE *nv_msg_output_stream(void)
+{
+    return msg_stdout();
+}
+
+
+static FILE *msg_stderr(void)
+{
+    MsgStreams *streams;
+
+    pthread_once(&msg_streams_key_once, create_msg_streams_key);
+    streams = pthread_getspecific(msg_streams_key);
+
+    return streams ? streams->err : stderr;
+}
+
+
+
 /*
  * XXX gcc's '-ansi' option causes vsnprintf to not be defined, so
  * declare the prototype here.
@@ -254,14 +339,24 @@ static void format(FILE *stream, const char *prefix,
 
 #define DEFAULT_MAX_WIDTH 75
 
+/*
+ * get_terminal_width() - the width is only looked up for the first
+ * message, rather than with an ioctl(2) for every message.
+ */
+
 static int get_terminal_width(void)
 {
+    static int width = 0;
     struct winsize ws;
+
+    if (width) return width;
     
     if (ioctl(STDERR_FILENO, TIOCGWINSZ, &ws) == -1 || ws.ws_col == 0) {
-        return DEFAULT_MAX_WIDTH;
+        width = DEFAULT_MAX_WIDTH;
     } else {
-        return (ws.ws_col - 1);
+        width = ws.ws_col - 1;
     }
+
+    return width;
 }
 
@@ -34,6 +34,9 @@ void  nv_info_msg(const char*, const char*, ...);
 void  nv_msg(const char*, const char*, ...);
 void  nv_msg_preserve_whitespace(const char*, const char*, ...);
 
+void  nv_msg_set_thread_streams(FILE *out, FILE *err);
+FILE *nv_msg_output_stream(void);
+
 
 /*
  * NV_VSNPRINTF(): macro that assigns buf using vsnprintf().  This is
@@ -30,8 +30,87 @@
 #include "msg.h"
 
 #include "ctkui.h"
+#include "common-utils.h"
 
 #include <stdlib.h>
+#include <string.h>
+#include <dlfcn.h>
+
+
+/*
+ * The gui is built into its own library, NV_GTK_LIB_NAME, and only
+ * loaded when the gui may be used, so that a command line that only
+ * loads the configuration file, or assigns or queries attributes,
+ * neither loads nor initializes GTK+ and GLib.  The library resolves
+ * the rest of nvidia-settings from the nvidia-settings binary, which
+ * exports its symbols for it.
+ */
+
+typedef struct {
+    void *handle;
+    int (*init_check)(int *argc, char **argv[]);
+    char *(*get_display)(void);
+    void (*main)(ParsedAttribute *, ConfigProperties *, CtrlHandles *,
+                 const char *);
+    char *error;
+} GtkLibrary;
+
+
+
+/*
+ * open_gtk_library() - load the gui library: first from the directory
+ * of the nvidia-settings binary (if argv[0] names it with a path, as
+ * when running from the build directory), then from the directory it
+ * was configured to be installed in, and last from the dynamic
+ * linker's search path.  On failure, the reason is saved in
+ * lib->error.
+ */
+
+static int open_gtk_library(GtkLibrary *lib, const char *argv0)
+{
+    const char *slash = strrchr(argv0, '/');
+    char *dir, *path;
+
+    memset(lib, 0, sizeof(GtkLibrary));
+
+    if (slash) {
+        dir = nvstrdup(argv0);
+        dir[slash - argv0 + 1] = '\0';
+        path = nvstrcat(dir, NV_GTK_LIB_NAME, NULL);
+        lib->handle = dlopen(path, RTLD_NOW);
+        free(path);
+        free(dir);
+    }
+
+    if (!lib->handle) {
+        lib->handle = dlopen(NV_GTK_LIB_DIR "/" NV_GTK_LIB_NAME, RTLD_NOW);
+    }
+
+    if (!lib->handle) {
+        lib->handle = dlopen(NV_GTK_LIB_NAME, RTLD_NOW);
+    }
+
+    if (!lib->handle) {
+        lib->error = nvstrdup(dlerror());
+        return NV_FALSE;
+    }
+
+    lib->init_check = dlsym(lib->handle, "ctk_init_check");
+    lib->get_display = dlsym(lib->handle, "ctk_get_display");
+    lib->main = dlsym(lib->handle, "ctk_main");
+
+    if (!lib->init_check || !lib->get_display || !lib->main) {
+        lib->error = nvstrcat("Unable to find the gui entry points in ",
+                              NV_GTK_LIB_NAME, ".", NULL);
+        dlclose(lib->handle);
+        lib->handle = NULL;
+        return NV_FALSE;
+    }
+
+    return NV_TRUE;
+
+} /* open_gtk_library() */
+
 
 
 int main(int argc, char **argv)
@@ -40,24 +119,43 @@ int main(int argc, char **argv)
     ParsedAttribute *p;
     CtrlHandles *h;
     Options *op;
+    GtkLibrary gtk;
     int ret;
     char *dpy = NULL;
     int gui = 0;
 
+    memset(&gtk, 0, sizeof(gtk));
+
+    /*
+     * the parallel processing of several X displays (see fanout.h)
+     * opens one Display per thread; this must be done before any other
+     * Xlib call, including the ones made by the gui toolkit below
+     */
+
+    XInitThreads();
+
     /*
-     * initialize the ui
+     * load and initialize the ui
      *
-     * XXX it would be nice if we didn't do this up front, since we
-     * may not even use the gui, but we want the toolkit to have a
-     * chance to parse the commandline before we do...
+     * The toolkit needs a chance to parse the commandline before we
+     * do; but if the commandline only loads the configuration file,
+     * or assigns or queries attributes, the gui will not be used, so
+     * skip loading it, and control the display named by $DISPLAY
+     * (unless --ctrl-display says otherwise), as the toolkit would.
+     * The same display is controlled when the gui library cannot be
+     * loaded.
      *
      * gui flag used to decide if ctk should be used or not, as
      * the user might just use control the display from a remote console
      * but for some reason cannot initialize the gtk gui. - TY 2005-05-27
      */
 
-    if (ctk_init_check(&argc, &argv)) {
-        dpy = ctk_get_display();
+    if (nv_command_line_is_headless(argc, argv)) {
+        dpy = getenv("DISPLAY");
+    } else if (!open_gtk_library(&gtk, argv[0])) {
+        dpy = getenv("DISPLAY");
+    } else if (gtk.init_check(&argc, &argv)) {
+        dpy = gtk.get_display();
         gui = 1;
     }
     
@@ -68,6 +166,10 @@ int main(int argc, char **argv)
     /* quit here if we don't have a ctrl_display - TY 2005-05-27 */
 
     if (op->ctrl_display == NULL) {
+        if (gtk.error) {
+            nv_error_msg("Unable to load the nvidia-settings GUI (%s).",
+                         gtk.error);
+        }
         nv_error_msg("The control display is undefined; please run "
                      "`%s --help` for usage information.\n", argv[0]);
         return 1;
@@ -77,6 +179,27 @@ int main(int argc, char **argv)
 
     if (op->num_assignments || op->num_queries) {
         ret = nv_process_assignments_and_queries(op);
+        if (!ret || (!op->batch && !op->watch)) return ret ? 0 : 1;
+    }
+
+    /* process the --batch file, instead of starting the gui */
+
+    if (op->batch) {
+        ret = nv_process_batch_file(op);
+        return ret ? 0 : 1;
+    }
+
+    /* sample telemetry with --sample, instead of starting the gui */
+
+    if (op->sample.file) {
+        ret = nv_sampler_run(op->ctrl_display, &op->sample);
+        return ret ? 0 : 1;
+    }
+
+    /* watch attributes given with --watch, instead of starting the gui */
+
+    if (op->watch) {
+        ret = nv_watch_attributes(op);
         return ret ? 0 : 1;
     }
     
@@ -108,7 +231,8 @@ int main(int argc, char **argv)
     /* upload the data from the config file */
     
     if (!op->no_load) {
-        ret = nv_read_config_file(op->config, op->ctrl_display, p, &conf);
+        ret = nv_read_config_file(op->config, op->ctrl_display, p, &conf,
+                                  &op->fanout, op->delta_apply);
     } else {
         ret = 1;
     }
@@ -128,6 +252,10 @@ int main(int argc, char **argv)
      */
 
     if (gui == 0) {
+        if (gtk.error) {
+            nv_error_msg("Unable to load the nvidia-settings GUI (%s).",
+                         gtk.error);
+        }
         nv_error_msg("Unable to create nvidia-settings GUI; please run "
                      "`%s --help` for usage information.\n", argv[0]);
         return 1;
@@ -141,9 +269,16 @@ int main(int argc, char **argv)
         return 1;
     }
 
+    /*
+     * keep track of the attribute values seen by the gui, so that the
+     * configuration file can be written at exit without querying them
+     */
+
+    nv_track_config_file_attributes(h);
+
     /* pass control to the gui */
 
-    ctk_main(p, &conf, h, op->page);
+    gtk.main(p, &conf, h, op->page);
     
     /* write the configuration file */
 
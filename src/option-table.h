@@ -63,6 +63,16 @@ static const NVGetoptOption __options[] = {
       "if <nvidia-settings> has difficulties starting due to problems with "
       "applying settings in the configuration file." },
 
+    { "delta-apply", DELTA_APPLY_OPTION, 0, NULL,
+      "When loading the configuration file, first query the current value "
+      "of every attribute in it (in one batch per X display), and only "
+      "send the assignments that would change a value (again in one batch "
+      "per X display); the number of assignments that were skipped is "
+      "reported.  Color attributes (e.g., <'Gamma'>) are always assigned.  "
+      "Note that all values are queried before anything is assigned, so "
+      "an assignment to an attribute whose value is changed by an earlier "
+      "assignment in the file may be skipped." },
+
     { "rewrite-config-file", 'r', 0, NULL,
       "Write the X server configuration to the configuration file, and exit, "
       "without starting the graphical user interface.  See EXAMPLES section." },
@@ -119,6 +129,26 @@ static const NVGetoptOption __options[] = {
       TAB "--assign=\"SyncToVBlank=1\"\n"
       TAB "-a [gpu:0]/DigitalVibrance[DFP-1]=63\n" },
 
+    { "transaction", TRANSACTION_OPTION, 0, NULL,
+      "Apply all of the <'--assign'> options as one transaction: every "
+      "assignment is parsed and validated, and the current values are "
+      "queried, before anything is assigned; the assignments are then "
+      "sent together, and if any of them fails, the others are restored "
+      "to their previous values.  Color attributes (e.g., <'Gamma'>) "
+      "cannot be assigned in a transaction.  With <'--jobs'>, each X "
+      "display is a separate transaction." },
+
+    { "batch", BATCH_OPTION, NVGETOPT_STRING_ARGUMENT, NULL,
+      "Read queries and assignments, one per line, from the file "
+      "^BATCH> (or from standard input if ^BATCH> is <'-'>), and process "
+      "them in order, without starting the GUI.  A line that contains "
+      "an '=' is an assignment, in the form accepted by <'--assign'>; "
+      "any other line is a query, in the form accepted by <'--query'>.  "
+      "Blank lines and lines starting with '#' are ignored.  Each X "
+      "display is only opened once for the whole batch, and the output "
+      "of each line is flushed as soon as the line is processed, so the "
+      "batch can be driven interactively through a pipe." },
+
     { "query", 'q', NVGETOPT_STRING_ARGUMENT, NULL,
       "The ^QUERY> argument to the <'--query'> command line option is of the "
       "form:\n"
@@ -138,12 +168,87 @@ static const NVGetoptOption __options[] = {
       "only print the current value, rather than the more verbose description "
       "of the attribute, its valid values, and its current value." },
 
+    { "format", QUERY_FORMAT_OPTION, NVGETOPT_STRING_ARGUMENT, NULL,
+      "Print the results of the '--query' option in the given ^FORMAT>, "
+      "for consumption by other programs, rather than as text.  Each "
+      "queried attribute is printed as one record, with one record per "
+      "target and display device, giving the target, the attribute name, "
+      "the display device, the attribute type, its value, its valid "
+      "values, whether it is writable and which target types it applies "
+      "to.  Valid values are <'text'> (the default), <'json'> (one JSON "
+      "object per line), <'csv'> (a header line followed by one line per "
+      "record) and <'kv'> (one line of key=value pairs per record).  The "
+      "target type queries (e.g., <'-q gpus'>) are always printed as "
+      "text." },
+
+    { "watch", WATCH_OPTION, NVGETOPT_STRING_ARGUMENT, NULL,
+      "Watch the comma separated list of attributes in ^WATCH> (in the "
+      "same form as the <'--query'> option; e.g., "
+      "<'--watch=GPUCoreTemp,[gpu:0]/GPUCurrentClockFreqs'>) and print a "
+      "timestamped line each time one of them changes, until interrupted.  "
+      "Attributes that can be assigned are reported as the X server "
+      "sends change events for them; the others are sampled every "
+      "<'--watch-interval'> milliseconds.  All of the attributes must be "
+      "on the same X display.  The lines are printed in the format "
+      "given by <'--format'>." },
+
+    { "watch-interval", WATCH_INTERVAL_OPTION, NVGETOPT_INTEGER_ARGUMENT,
+      NULL,
+      "Sample the attributes given to <'--watch'> that do not generate "
+      "change events every ^WATCH-INTERVAL> milliseconds.  The default "
+      "is 1000." },
+
+    { "sample", SAMPLE_OPTION, NVGETOPT_STRING_ARGUMENT, NULL,
+      "Sample GPU telemetry (temperature, clocks, PowerMizer state and PCI "
+      "Express link) on all GPUs of the X display, instead of starting "
+      "the GUI, until interrupted.  Each sample is appended as one "
+      "fixed-size binary record per GPU to a ring of records in the "
+      "memory-mapped file ^SAMPLE>, which other programs can read while "
+      "it is being written, without locking; the file layout is "
+      "described in sampler.h." },
+
+    { "sample-interval", SAMPLE_INTERVAL_OPTION, NVGETOPT_INTEGER_ARGUMENT,
+      NULL,
+      "Take a sample for <'--sample'> every ^SAMPLE-INTERVAL> "
+      "milliseconds.  The default is 1000; the smallest interval is 10." },
+
+    { "sample-attributes", SAMPLE_ATTRIBUTES_OPTION,
+      NVGETOPT_STRING_ARGUMENT, NULL,
+      "Sample the comma separated list of GPU attributes in "
+      "^SAMPLE-ATTRIBUTES> (e.g., <'GPUCoreTemp,GPUCurrentClockFreqs'>) "
+      "for <'--sample'>, instead of the default set.  At most 32 integer "
+      "attributes can be sampled." },
+
+    { "sample-history", SAMPLE_HISTORY_OPTION, NVGETOPT_INTEGER_ARGUMENT,
+      NULL,
+      "Keep the last ^SAMPLE-HISTORY> samples of each GPU in the "
+      "<'--sample'> file.  The default is 3600." },
+
     { "display-device-string", 'd', 0, NULL,
       "When printing attribute values in response to the '--query' option, "
       "if the attribute value is a display device mask, print the value "
       "as a list of display devices (e.g., \"CRT-0, DFP-0\"), rather than "
       "a hexadecimal bit mask (e.g., 0x00010001)." },
 
+    { "jobs", 'j', NVGETOPT_INTEGER_ARGUMENT, NULL,
+      "When the queries and assignments given on the commandline, or the "
+      "attributes in the configuration file, apply to more than one X "
+      "display, process up to ^JOBS> X displays at once, each in its own "
+      "thread with its own connection to the X server.  The output for "
+      "each X display is printed once it is done, in the order in which "
+      "the X displays are first named; for each X display, its queries "
+      "are processed before its assignments.  The default is 1, which "
+      "processes everything in order, one X display at a time." },
+
+    { "display-timeout", DISPLAY_TIMEOUT_OPTION, NVGETOPT_INTEGER_ARGUMENT,
+      NULL,
+      "Give up on an X display if processing its queries, assignments, "
+      "or configuration file attributes takes longer than "
+      "^DISPLAY-TIMEOUT> seconds; the other X displays are still "
+      "processed, and an error is reported for each X display that timed "
+      "out.  The default of 0 waits forever.  Giving a timeout also "
+      "enables the parallel processing described for <'--jobs'>." },
+
     { "glxinfo", 'g', 0, NULL,
       "Print GLX Information for the X display and exit." },
 
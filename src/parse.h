@@ -134,7 +134,7 @@ typedef struct _ParsedAttribute {
 
 
 /*
- * Attribute table; defined in parse.c
+ * Attribute table; defined in attribute-table.c
  */
 
 extern AttributeTableEntry attributeTable[];
@@ -255,6 +255,18 @@ const float * nv_get_sdi_csc_matrix(char *s);
 int nv_parse_attribute_string(const char *, int, ParsedAttribute *);
 
 
+/*
+ * nv_parse_attribute_string_in_place() - like
+ * nv_parse_attribute_string(), for a string that has already had its
+ * white space removed (see remove_spaces()); no memory is allocated.
+ * On success, the display field of the ParsedAttribute points into the
+ * string, which is terminated in place after the display name.  On
+ * failure, the string is left unchanged.
+ */
+
+int nv_parse_attribute_string_in_place(char *, int, ParsedAttribute *);
+
+
 /*
  * nv_assign_default_display() - assigns the display name to the
  * ParsedAttribute struct.  As a side affect, also assigns the screen
@@ -316,6 +328,15 @@ void nv_parsed_attribute_add(ParsedAttribute *head, ParsedAttribute *a);
 void nv_parsed_attribute_free(ParsedAttribute *p);
 void nv_parsed_attribute_clean(ParsedAttribute *p);
 
+/*
+ * nv_get_attribute_entry() - return the attributeTable entry with the
+ * given name (compared case insensitively), or NULL if there is none.
+ */
+
+AttributeTableEntry *nv_get_attribute_entry(const char *name);
+
+unsigned int nv_attribute_name_hash(const char *name, unsigned int seed);
+
 const char *nv_get_attribute_name(const int attr, const int flagsMask,
                                   const int flags);
 
@@ -33,14 +33,26 @@
 #include <stdlib.h>
 #include <string.h>
 #include <inttypes.h>
+#include <errno.h>
+#include <time.h>
+#include <sys/time.h>
+#include <sys/select.h>
+
+#include <X11/Xlib.h>
+
+#include "NVCtrlLib.h"
 
 #include "parse.h"
 #include "msg.h"
 #include "query-assign.h"
+#include "query-format.h"
+#include "fanout.h"
+#include "common-utils.h"
 
 extern int __verbosity;
 extern int __terse;
 extern int __display_device_string;
+extern int __query_format;
 
 /* local prototypes */
 
@@ -48,8 +60,12 @@ static int process_attribute_queries(int, char**, const char *);
 
 static int process_attribute_assignments(int, char**, const char *);
 
-static int query_all(const char *);
-static int query_all_targets(const char *display_name, const int target_index);
+static int process_attribute_transaction(int, char**, const char *);
+
+static int process_display_requests_in_parallel(Options *op);
+
+static int query_all(CtrlHandles *h);
+static int query_all_targets(CtrlHandles *h, const int target_index);
 
 static void print_valid_values(char *, int, uint32, NVCTRLAttributeValidValuesRec);
 
@@ -61,6 +77,35 @@ static void print_additional_info(const char *name,
 static int validate_value(CtrlHandleTarget *t, ParsedAttribute *a, uint32 d,
                           int target_type, char *whence);
 
+/*
+ * A CollectTargetFunc is called by process_parsed_attribute(), in
+ * place of processing the attribute, for each target and display
+ * device that the attribute applies to.
+ */
+
+typedef int (*CollectTargetFunc)(void *data, CtrlHandleTarget *t,
+                                 ParsedAttribute *a, uint32 d,
+                                 int target_type, char *whence,
+                                 NVCTRLAttributeValidValuesRec valid);
+
+static int add_watch_item(void *data, CtrlHandleTarget *t,
+                          ParsedAttribute *a, uint32 d, int target_type,
+                          char *whence, NVCTRLAttributeValidValuesRec valid);
+
+static int add_transaction_item(void *data, CtrlHandleTarget *t,
+                                ParsedAttribute *a, uint32 d,
+                                int target_type, char *whence,
+                                NVCTRLAttributeValidValuesRec valid);
+
+static int add_delta_item(void *data, CtrlHandleTarget *t,
+                          ParsedAttribute *a, uint32 d, int target_type,
+                          char *whence, NVCTRLAttributeValidValuesRec valid);
+
+static int process_parsed_attribute(ParsedAttribute *a, CtrlHandles *h,
+                                    int assign, int verbose,
+                                    CollectTargetFunc collect,
+                                    void *collect_data, char *whence);
+
 /*
  * nv_process_assignments_and_queries() - process any assignments or
  * queries specified on the commandline.  If an error occurs, return
@@ -71,13 +116,26 @@ int nv_process_assignments_and_queries(Options *op)
 {
     int ret;
 
+    if (op->num_queries) {
+        nv_query_format_begin(__query_format, NV_FALSE);
+    }
+
+    if (op->fanout.max_jobs > 1 || op->fanout.timeout > 0) {
+        return process_display_requests_in_parallel(op);
+    }
+
     if (op->num_queries) {
         ret = process_attribute_queries(op->num_queries,
                                         op->queries, op->ctrl_display);
         if (!ret) return NV_FALSE;
     }
 
-    if (op->num_assignments) {
+    if (op->num_assignments && op->transaction) {
+        ret = process_attribute_transaction(op->num_assignments,
+                                            op->assignments,
+                                            op->ctrl_display);
+        if (!ret) return NV_FALSE;
+    } else if (op->num_assignments) {
         ret = process_attribute_assignments(op->num_assignments,
                                             op->assignments,
                                             op->ctrl_display);
@@ -91,20 +149,154 @@ int nv_process_assignments_and_queries(Options *op)
 
 
 /*
- * nv_alloc_ctrl_handles() - allocate a new CtrlHandles structure,
- * connect to the X server identified by display, and initialize an
- * NvCtrlAttributeHandle for each possible target (X screens, gpus,
- * FrameLock devices).
+ * init_ctrl_handle_target() - initialize the NvCtrlAttributeHandle,
+ * name and display device masks of target 'i' of the target type
+ * described by targetTypeTable[j].
  */
 
-CtrlHandles *nv_alloc_ctrl_handles(const char *display)
+static void init_ctrl_handle_target(CtrlHandles *h, int j, int i)
 {
     ReturnStatus status;
-    CtrlHandles *h, *pQueryHandle = NULL;
     NvCtrlAttributeHandle *handle;
-    int target, i, j, val, d, c, len;
+    CtrlHandleTarget *t;
+    int target, d, c, len;
     char *tmp;
 
+    target = targetTypeTable[j].target_index;
+    t = &h->targets[target].t[i];
+
+    t->initialized = NV_TRUE;
+
+    /* allocate the handle */
+    
+    handle = NvCtrlAttributeInit(h->dpy,
+                                 targetTypeTable[j].nvctrl, i,
+                                 NV_CTRL_ATTRIBUTES_ALL_SUBSYSTEMS);
+    
+    t->h = handle;
+    
+    /*
+     * silently fail: this might happen if not all X screens
+     * are NVIDIA X screens
+     */
+    
+    if (!handle) return;
+    
+    /*
+     * get a name for this target; in the case of
+     * X_SCREEN_TARGET targets, just use the string returned
+     * from NvCtrlGetDisplayName(); for other target types,
+     * append a target specification.
+     */
+    
+    tmp = NvCtrlGetDisplayName(handle);
+    
+    if (target == X_SCREEN_TARGET) {
+        t->name = tmp;
+    } else {
+        len = strlen(tmp) + strlen(targetTypeTable[j].parsed_name) +16;
+        t->name = malloc(len);
+
+        if (t->name) {
+            snprintf(t->name, len, "%s[%s:%d]",
+                     tmp, targetTypeTable[j].parsed_name, i);
+            free(tmp);
+        } else {
+            t->name = tmp;
+        }
+    }
+
+    /*
+     * get the enabled display device mask; for X screens and
+     * GPUs we query NV-CONTROL; for anything else
+     * (framelock), we just assign this to 0.
+     */
+
+    if (targetTypeTable[j].uses_display_devices) {
+        
+        status = NvCtrlGetAttribute(handle,
+                                    NV_CTRL_ENABLED_DISPLAYS, &d);
+
+        if (status != NvCtrlSuccess) {
+            nv_error_msg("Error querying enabled displays on "
+                         "%s %d (%s).", targetTypeTable[j].name, i,
+                         NvCtrlAttributesStrError(status));
+            d = 0;
+        }
+        
+        status = NvCtrlGetAttribute(handle,
+                                    NV_CTRL_CONNECTED_DISPLAYS, &c);
+
+        if (status != NvCtrlSuccess) {
+            nv_error_msg("Error querying connected displays on "
+                         "%s %d (%s).", targetTypeTable[j].name, i,
+                         NvCtrlAttributesStrError(status));
+            c = 0;
+        }
+    } else {
+        d = 0;
+        c = 0;
+    }
+     
+    t->d = d;
+    t->c = c;
+
+} /* init_ctrl_handle_target() */
+
+
+
+/*
+ * nv_get_ctrl_handle_target() - return the CtrlHandleTarget for the
+ * given target, initializing it on first use; returns NULL if there is
+ * no such target.  The returned target's handle is NULL if the target
+ * cannot be controlled (e.g., an X screen not driven by NVIDIA).
+ */
+
+CtrlHandleTarget *nv_get_ctrl_handle_target(CtrlHandles *h,
+                                            int target_index, int target_id)
+{
+    CtrlHandleTarget *t;
+    int j;
+
+    if (!h || !h->dpy || target_index < 0 ||
+        target_index >= MAX_TARGET_TYPES ||
+        target_id < 0 || target_id >= h->targets[target_index].n) {
+        return NULL;
+    }
+
+    t = &h->targets[target_index].t[target_id];
+
+    if (!t->initialized) {
+        for (j = 0; targetTypeTable[j].name; j++) {
+            if (targetTypeTable[j].target_index == target_index) {
+                init_ctrl_handle_target(h, j, target_id);
+                break;
+            }
+        }
+    }
+
+    return t;
+
+} /* nv_get_ctrl_handle_target() */
+
+
+
+/*
+ * nv_alloc_ctrl_handles() - allocate a new CtrlHandles structure,
+ * connect to the X server identified by display, and count the
+ * possible targets (X screens, gpus, FrameLock devices).  The
+ * NvCtrlAttributeHandle for each target is only initialized when the
+ * target is first looked up with nv_get_ctrl_handle_target().
+ */
+
+CtrlHandles *nv_alloc_ctrl_handles(const char *display)
+{
+    ReturnStatus status;
+    CtrlHandles *h;
+    CtrlHandleTarget *t;
+    NvCtrlAttributeHandle *pQueryHandle = NULL;
+    int target, i, j, val;
+
     /* allocate the CtrlHandles struct */
     
     h = calloc(1, sizeof(CtrlHandles));
@@ -122,10 +314,11 @@ CtrlHandles *nv_alloc_ctrl_handles(const char *display)
         nv_error_msg("Cannot open display '%s'.", XDisplayName(h->display));
         return h;
     }
+
+    nv_fanout_watch_display(h->dpy);
     
     /*
-     * loop over each target type and setup the appropriate
-     * information
+     * loop over each target type and count the targets of that type
      */
     
     for (j = 0; targetTypeTable[j].name; j++) {
@@ -149,10 +342,17 @@ CtrlHandles *nv_alloc_ctrl_handles(const char *display)
         } else {
     
             /*
-             * note: pQueryHandle should be assigned below by a
-             * previous iteration of this loop; depends on X screen
-             * targets getting handled first
+             * note: the X screen targets must be counted by a
+             * previous iteration of this loop; the handle of the
+             * first X screen that has one is used to count the
+             * other target types
              */
+
+            for (i = 0; !pQueryHandle &&
+                     i < h->targets[X_SCREEN_TARGET].n; i++) {
+                t = nv_get_ctrl_handle_target(h, X_SCREEN_TARGET, i);
+                if (t) pQueryHandle = t->h;
+            }
             
             if (pQueryHandle) {
 
@@ -201,99 +401,13 @@ CtrlHandles *nv_alloc_ctrl_handles(const char *display)
 
         if (h->targets[target].n == 0) continue;
         
-        /* allocate an array of CtrlHandleTarget's */
-
-        h->targets[target].t =
-            calloc(h->targets[target].n, sizeof(CtrlHandleTarget));
-        
         /*
-         * loop over all the targets of this type and setup the
-         * CtrlHandleTarget's
+         * allocate an array of CtrlHandleTarget's; they are set up by
+         * nv_get_ctrl_handle_target()
          */
 
-        for (i = 0; i < h->targets[target].n; i++) {
-        
-            /* allocate the handle */
-            
-            handle = NvCtrlAttributeInit(h->dpy,
-                                         targetTypeTable[j].nvctrl, i,
-                                         NV_CTRL_ATTRIBUTES_ALL_SUBSYSTEMS);
-            
-            h->targets[target].t[i].h = handle;
-            
-            /*
-             * silently fail: this might happen if not all X screens
-             * are NVIDIA X screens
-             */
-            
-            if (!handle) continue;
-            
-            /*
-             * get a name for this target; in the case of
-             * X_SCREEN_TARGET targets, just use the string returned
-             * from NvCtrlGetDisplayName(); for other target types,
-             * append a target specification.
-             */
-            
-            tmp = NvCtrlGetDisplayName(handle);
-            
-            if (target == X_SCREEN_TARGET) {
-                h->targets[target].t[i].name = tmp;
-            } else {
-                len = strlen(tmp) + strlen(targetTypeTable[j].parsed_name) +16;
-                h->targets[target].t[i].name = malloc(len);
-
-                if (h->targets[target].t[i].name) {
-                    snprintf(h->targets[target].t[i].name, len, "%s[%s:%d]",
-                             tmp, targetTypeTable[j].parsed_name, i);
-                    free(tmp);
-                } else {
-                    h->targets[target].t[i].name = tmp;
-                }
-            }
-
-            /*
-             * get the enabled display device mask; for X screens and
-             * GPUs we query NV-CONTROL; for anything else
-             * (framelock), we just assign this to 0.
-             */
-
-            if (targetTypeTable[j].uses_display_devices) {
-                
-                status = NvCtrlGetAttribute(handle,
-                                            NV_CTRL_ENABLED_DISPLAYS, &d);
-        
-                if (status != NvCtrlSuccess) {
-                    nv_error_msg("Error querying enabled displays on "
-                                 "%s %d (%s).", targetTypeTable[j].name, i,
-                                 NvCtrlAttributesStrError(status));
-                    d = 0;
-                }
-                
-                status = NvCtrlGetAttribute(handle,
-                                            NV_CTRL_CONNECTED_DISPLAYS, &c);
-        
-                if (status != NvCtrlSuccess) {
-                    nv_error_msg("Error querying connected displays on "
-                                 "%s %d (%s).", targetTypeTable[j].name, i,
-                                 NvCtrlAttributesStrError(status));
-                    c = 0;
-                }
-            } else {
-                d = 0;
-                c = 0;
-            }
-             
-            h->targets[target].t[i].d = d;
-            h->targets[target].t[i].c = c;
-
-            /*
-             * store this handle so that we can use it to query other
-             * target counts later
-             */
-            
-            if (!pQueryHandle) pQueryHandle = handle;
-        }
+        h->targets[target].t =
+            calloc(h->targets[target].n, sizeof(CtrlHandleTarget));
     }
     
     return h;
@@ -350,6 +464,50 @@ void nv_free_ctrl_handles(CtrlHandles *h)
 
 
 
+/*
+ * TargetListQueries[] - the special queries that list the targets of
+ * one target type (e.g., "-q gpus").
+ */
+
+static const struct {
+    const char *name;
+    int target_index;
+} TargetListQueries[] = {
+    { "screens",        X_SCREEN_TARGET },
+    { "xscreens",       X_SCREEN_TARGET },
+    { "gpus",           GPU_TARGET },
+    { "framelocks",     FRAMELOCK_TARGET },
+    { "vcs",            VCS_TARGET },
+    { "gvis",           GVI_TARGET },
+    { "fans",           COOLER_TARGET },
+    { "thermalsensors", THERMAL_SENSOR_TARGET },
+    { "svps",           NVIDIA_3D_VISION_PRO_TRANSCEIVER_TARGET },
+};
+
+
+
+/*
+ * get_target_list_query() - return the target index listed by the
+ * given special query, or -1 if the query is not a target list query.
+ */
+
+static int get_target_list_query(const char *query)
+{
+    int i;
+
+    for (i = 0; i < sizeof(TargetListQueries) /
+                    sizeof(TargetListQueries[0]); i++) {
+        if (nv_strcasecmp(query, TargetListQueries[i].name)) {
+            return TargetListQueries[i].target_index;
+        }
+    }
+
+    return -1;
+
+} /* get_target_list_query() */
+
+
+
 /*
  * process_attribute_queries() - parse the list of queries, and call
  * nv_ctrl_process_parsed_attribute() to process each query.
@@ -365,7 +523,7 @@ void nv_free_ctrl_handles(CtrlHandles *h)
 static int process_attribute_queries(int num, char **queries,
                                      const char *display_name)
 {
-    int query, ret, val;
+    int query, ret, val, target_index;
     ParsedAttribute a;
     CtrlHandles *h;
     
@@ -373,7 +531,7 @@ static int process_attribute_queries(int num, char **queries,
     
     /* print a newline before we begin */
 
-    if (!__terse) nv_msg(NULL, "");
+    if (!__terse && !__query_format) nv_msg(NULL, "");
 
     /* loop over each requested query */
 
@@ -382,168 +540,1031 @@ static int process_attribute_queries(int num, char **queries,
         /* special case the "all" query */
 
         if (nv_strcasecmp(queries[query], "all")) {
-            query_all(display_name);
+            h = nv_alloc_ctrl_handles(display_name);
+            query_all(h);
+            nv_free_ctrl_handles(h);
             continue;
         }
 
         /* special case the target type queries */
-        
-        if (nv_strcasecmp(queries[query], "screens") ||
-            nv_strcasecmp(queries[query], "xscreens")) {
-            query_all_targets(display_name, X_SCREEN_TARGET);
+
+        target_index = get_target_list_query(queries[query]);
+
+        if (target_index >= 0) {
+            h = nv_alloc_ctrl_handles(display_name);
+            query_all_targets(h, target_index);
+            nv_free_ctrl_handles(h);
             continue;
         }
-        
-        if (nv_strcasecmp(queries[query], "gpus")) {
-            query_all_targets(display_name, GPU_TARGET);
-            continue;
+
+        /* call the parser to parse queries[query] */
+
+        ret = nv_parse_attribute_string(queries[query], NV_PARSER_QUERY, &a);
+        if (ret != NV_PARSER_STATUS_SUCCESS) {
+            nv_error_msg("Error parsing query '%s' (%s).",
+                         queries[query], nv_parse_strerror(ret));
+            goto done;
         }
+        
+        /* make sure we have a display */
 
-        if (nv_strcasecmp(queries[query], "framelocks")) {
-            query_all_targets(display_name, FRAMELOCK_TARGET);
-            continue;
+        nv_assign_default_display(&a, display_name);
+
+        /* allocate the CtrlHandles */
+
+        h = nv_alloc_ctrl_handles(a.display);
+
+        /* call the processing engine to process the parsed query */
+
+        ret = nv_process_parsed_attribute(&a, h, NV_FALSE, NV_FALSE,
+                                          "in query '%s'", queries[query]);
+        /* free the CtrlHandles */
+
+        nv_free_ctrl_handles(h);
+
+        if (ret == NV_FALSE) goto done;
+        
+        /* print a newline at the end */
+        if (!__terse && !__query_format) nv_msg(NULL, "");
+
+    } /* query */
+
+    val = NV_TRUE;
+    
+ done:
+    
+    return val;
+    
+} /* process_attribute_queries() */
+
+
+
+/*
+ * process_attribute_assignments() - parse the list of
+ * assignments, and call nv_process_parsed_attribute() to process
+ * each assignment.
+ *
+ * If any errors are encountered, an error message is printed and
+ * NV_FALSE is returned.  Otherwise, NV_TRUE is returned.
+ *
+ * XXX rather than call nv_alloc_ctrl_handles()/nv_free_ctrl_handles()
+ * for every assignment, we should share the code in
+ * process_config_file_attributes() to collapse the list of handles.
+ */
+
+static int process_attribute_assignments(int num, char **assignments,
+                                         const char *display_name)
+{
+    int assignment, ret, val;
+    ParsedAttribute a;
+    CtrlHandles *h;
+
+    val = NV_FALSE;
+
+    /* print a newline before we begin */
+
+    nv_msg(NULL, "");
+
+    /* loop over each requested assignment */
+
+    for (assignment = 0; assignment < num; assignment++) {
+        
+        /* call the parser to parse assignments[assignment] */
+
+        ret = nv_parse_attribute_string(assignments[assignment],
+                                        NV_PARSER_ASSIGNMENT, &a);
+
+        if (ret != NV_PARSER_STATUS_SUCCESS) {
+            nv_error_msg("Error parsing assignment '%s' (%s).",
+                         assignments[assignment], nv_parse_strerror(ret));
+            goto done;
         }
+        
+        /* make sure we have a display */
 
-        if (nv_strcasecmp(queries[query], "vcs")) {
-            query_all_targets(display_name, VCS_TARGET);
-            continue;
+        nv_assign_default_display(&a, display_name);
+
+        /* allocate the CtrlHandles */
+
+        h = nv_alloc_ctrl_handles(a.display);
+        
+        /* call the processing engine to process the parsed assignment */
+
+        ret = nv_process_parsed_attribute(&a, h, NV_TRUE, NV_TRUE,
+                                          "in assignment '%s'",
+                                          assignments[assignment]);
+        /* free the CtrlHandles */
+
+        nv_free_ctrl_handles(h);
+
+        if (ret == NV_FALSE) goto done;
+
+        /* print a newline at the end */
+
+        nv_msg(NULL, "");
+
+    } /* assignment */
+
+    val = NV_TRUE;
+
+ done:
+
+    return val;
+
+} /* nv_process_attribute_assignments() */
+
+
+
+/*
+ * The assignments of a transaction (see
+ * process_attribute_transaction()) or of a delta-apply (see
+ * nv_delta_apply_add()); each TransactionItem is one target and
+ * display device of one assignment.
+ */
+
+typedef struct {
+    CtrlHandles *h;
+    CtrlHandleTarget *t;
+    const char *name;
+    int attr;
+    uint32 flags;
+    uint32 d;
+    char d_str[64];     /* ", display device: ..." or "" */
+    char *whence;
+    int value;
+    int readable;       /* NV_TRUE if the current value can be queried */
+    int captured;       /* NV_TRUE if old_value was queried */
+    int64_t old_value;  /* value before the transaction */
+    int skip;           /* NV_TRUE if the value need not be sent */
+    ReturnStatus status;
+} TransactionItem;
+
+typedef struct {
+    TransactionItem *items;
+    int num;
+    int alloc;
+    CtrlHandles **handles;  /* one per X display */
+    int num_handles;
+    CtrlHandles *h;         /* of the assignment being added */
+    int delta;              /* capture failures are not errors */
+} Transaction;
+
+struct _NvDeltaApply {
+    Transaction tr;
+    int direct;             /* assignments that could not be deferred */
+};
+
+#define TRANSACTION_CAPTURE  0
+#define TRANSACTION_APPLY    1
+#define TRANSACTION_ROLLBACK 2
+
+
+
+/*
+ * append_transaction_item() - add an item for the given target and
+ * display device of the assignment to the transaction.
+ */
+
+static int append_transaction_item(Transaction *tr, CtrlHandleTarget *t,
+                                   ParsedAttribute *a, uint32 d,
+                                   char *whence,
+                                   NVCTRLAttributeValidValuesRec valid)
+{
+    TransactionItem *item;
+    char *tmp_d_str;
+
+    if (tr->num == tr->alloc) {
+        int alloc = tr->alloc ? (tr->alloc * 2) : 16;
+
+        item = realloc(tr->items, sizeof(TransactionItem) * alloc);
+        if (!item) return NV_FALSE;
+
+        tr->items = item;
+        tr->alloc = alloc;
+    }
+
+    item = &tr->items[tr->num++];
+
+    memset(item, 0, sizeof(TransactionItem));
+
+    item->h = tr->h;
+    item->t = t;
+    item->name = a->name;
+    item->attr = a->attr;
+    item->flags = a->flags;
+    item->d = d;
+    item->whence = strdup(whence);
+    item->value = a->val;
+    item->readable = !!(valid.permissions & ATTRIBUTE_TYPE_READ);
+    item->status = NvCtrlError;
+
+    if (valid.permissions & ATTRIBUTE_TYPE_DISPLAY) {
+        tmp_d_str = display_device_mask_to_display_device_name(d);
+        snprintf(item->d_str, sizeof(item->d_str), ", display device: %s",
+                 tmp_d_str);
+        free(tmp_d_str);
+    }
+
+    return NV_TRUE;
+
+} /* append_transaction_item() */
+
+
+
+/*
+ * add_transaction_item() - called by process_parsed_attribute() for
+ * each target and display device that an assignment applies to;
+ * validate the value, and add it to the transaction.
+ */
+
+static int add_transaction_item(void *data, CtrlHandleTarget *t,
+                                ParsedAttribute *a, uint32 d,
+                                int target_type, char *whence,
+                                NVCTRLAttributeValidValuesRec valid)
+{
+    Transaction *tr = data;
+
+    if (!validate_value(t, a, d, target_type, whence)) return NV_FALSE;
+
+    if (!(valid.permissions & ATTRIBUTE_TYPE_READ)) {
+        nv_error_msg("The attribute '%s' specified %s cannot be assigned "
+                     "in a transaction (its current value cannot be "
+                     "queried, so it could not be restored).",
+                     a->name, whence);
+        return NV_FALSE;
+    }
+
+    return append_transaction_item(tr, t, a, d, whence, valid);
+
+} /* add_transaction_item() */
+
+
+
+/*
+ * add_delta_item() - called by process_parsed_attribute() for each
+ * target and display device that a delta-applied assignment applies
+ * to; validate the value, and add it to the list.  Values that cannot
+ * be queried are added too; they are always sent.
+ */
+
+static int add_delta_item(void *data, CtrlHandleTarget *t,
+                          ParsedAttribute *a, uint32 d, int target_type,
+                          char *whence, NVCTRLAttributeValidValuesRec valid)
+{
+    Transaction *tr = data;
+
+    if (!validate_value(t, a, d, target_type, whence)) return NV_FALSE;
+
+    return append_transaction_item(tr, t, a, d, whence, valid);
+
+} /* add_delta_item() */
+
+
+
+/*
+ * run_transaction_batch() - capture the current values of all items,
+ * apply the new values, or restore the captured values of the items
+ * that were applied, depending on 'phase'.  This is done with one
+ * NvCtrlQueryBatch() per X display, so the sets for each X display go
+ * out in one pipelined burst, and their statuses come back together.
+ * Rollback undoes the assignments in reverse order.
+ *
+ * Items that cannot be queried are not captured, and items marked
+ * 'skip' are not applied.
+ *
+ * Returns NV_FALSE if any capture or restore failed; the statuses of
+ * the applied values are left in each item.  For a delta-apply, a
+ * failed capture is not an error: the item is just not captured.
+ */
+
+static int run_transaction_batch(Transaction *tr, int phase)
+{
+    NvCtrlBatchQuery *q;
+    TransactionItem *item;
+    int *index;
+    int g, i, j, k, n, ret = NV_TRUE;
+
+    q = calloc(tr->num, sizeof(NvCtrlBatchQuery));
+    index = calloc(tr->num, sizeof(int));
+
+    if (!q || !index) {
+        free(q);
+        free(index);
+        nv_error_msg("Unable to allocate memory for %d assignments.",
+                     tr->num);
+        return NV_FALSE;
+    }
+
+    for (g = 0; g < tr->num_handles; g++) {
+
+        n = 0;
+
+        for (k = 0; k < tr->num; k++) {
+            i = (phase == TRANSACTION_ROLLBACK) ? (tr->num - 1 - k) : k;
+            item = &tr->items[i];
+
+            if (item->h != tr->handles[g]) continue;
+            if (phase == TRANSACTION_CAPTURE && !item->readable) continue;
+            if (phase == TRANSACTION_APPLY && item->skip) continue;
+            if (phase == TRANSACTION_ROLLBACK &&
+                item->status != NvCtrlSuccess) continue;
+
+            memset(&q[n], 0, sizeof(NvCtrlBatchQuery));
+            q[n].handle = item->t->h;
+            q[n].display_mask = item->d;
+            q[n].attr = item->attr;
+            q[n].status = NvCtrlError;
+
+            switch (phase) {
+            case TRANSACTION_CAPTURE:
+                q[n].query_type = NV_CTRL_BATCH_GET_ATTRIBUTE;
+                break;
+            case TRANSACTION_APPLY:
+                q[n].query_type = NV_CTRL_BATCH_SET_ATTRIBUTE;
+                q[n].value = item->value;
+                break;
+            case TRANSACTION_ROLLBACK:
+                q[n].query_type = NV_CTRL_BATCH_SET_ATTRIBUTE;
+                q[n].value = item->old_value;
+                break;
+            }
+
+            index[n++] = i;
+        }
+
+        if (n == 0) continue;
+
+        NvCtrlQueryBatch(q, n);
+
+        for (j = 0; j < n; j++) {
+            item = &tr->items[index[j]];
+
+            switch (phase) {
+            case TRANSACTION_CAPTURE:
+                item->captured = (q[j].status == NvCtrlSuccess);
+                if (q[j].status != NvCtrlSuccess && !tr->delta) {
+                    nv_error_msg("Error querying the current value of "
+                                 "attribute '%s' (%s%s) specified %s (%s).",
+                                 item->name, item->t->name, item->d_str,
+                                 item->whence,
+                                 NvCtrlAttributesStrError(q[j].status));
+                    ret = NV_FALSE;
+                }
+                item->old_value = q[j].value;
+                break;
+            case TRANSACTION_APPLY:
+                item->status = q[j].status;
+                break;
+            case TRANSACTION_ROLLBACK:
+                if (q[j].status != NvCtrlSuccess) {
+                    nv_error_msg("Error restoring value %" PRId64 " of "
+                                 "attribute '%s' (%s%s) (%s).",
+                                 item->old_value, item->name,
+                                 item->t->name, item->d_str,
+                                 NvCtrlAttributesStrError(q[j].status));
+                    ret = NV_FALSE;
+                }
+                break;
+            }
+        }
+    }
+
+    free(q);
+    free(index);
+
+    return ret;
+
+} /* run_transaction_batch() */
+
+
+
+/*
+ * process_attribute_transaction() - process the list of assignments
+ * as one transaction: every assignment is parsed and validated, and
+ * the current values are captured, before anything is assigned.  The
+ * assignments are then sent together; if any of them fails, the ones
+ * that were applied are restored to their captured values.
+ *
+ * If any errors are encountered, an error message is printed and
+ * NV_FALSE is returned.  Otherwise, NV_TRUE is returned.
+ */
+
+static int process_attribute_transaction(int num, char **assignments,
+                                         const char *display_name)
+{
+    Transaction tr;
+    TransactionItem *item;
+    ParsedAttribute a;
+    CtrlHandles *h;
+    char *whence;
+    int assignment, ret, i, failed, val;
+
+    val = NV_FALSE;
+    memset(&tr, 0, sizeof(tr));
+
+    /* print a newline before we begin */
+
+    nv_msg(NULL, "");
+
+    /* parse and validate every assignment */
+
+    for (assignment = 0; assignment < num; assignment++) {
+
+        ret = nv_parse_attribute_string(assignments[assignment],
+                                        NV_PARSER_ASSIGNMENT, &a);
+
+        if (ret != NV_PARSER_STATUS_SUCCESS) {
+            nv_error_msg("Error parsing assignment '%s' (%s).",
+                         assignments[assignment], nv_parse_strerror(ret));
+            goto done;
+        }
+
+        if (a.flags & (NV_PARSER_TYPE_COLOR_ATTRIBUTE |
+                       NV_PARSER_TYPE_SDI_CSC)) {
+            nv_error_msg("The attribute '%s' in assignment '%s' cannot be "
+                         "assigned in a transaction.", a.name,
+                         assignments[assignment]);
+            free(a.display);
+            goto done;
+        }
+
+        /* make sure we have a display, and share its CtrlHandles */
+
+        nv_assign_default_display(&a, display_name);
+
+        h = NULL;
+        for (i = 0; i < tr.num_handles; i++) {
+            if (nv_strcasecmp(tr.handles[i]->display ?
+                              tr.handles[i]->display : "",
+                              a.display ? a.display : "")) {
+                h = tr.handles[i];
+                break;
+            }
+        }
+
+        if (!h) {
+            tr.handles = realloc(tr.handles,
+                                 sizeof(CtrlHandles *) * (tr.num_handles + 1));
+            h = nv_alloc_ctrl_handles(a.display);
+            tr.handles[tr.num_handles++] = h;
+        }
+
+        tr.h = h;
+
+        free(a.display);
+
+        whence = nvstrcat("in assignment '", assignments[assignment], "'",
+                          NULL);
+        ret = process_parsed_attribute(&a, h, NV_TRUE, NV_TRUE,
+                                       add_transaction_item, &tr, whence);
+        nvfree(whence);
+
+        if (!ret) goto done;
+    }
+
+    /* capture the current values, and apply the new ones */
+
+    if (!run_transaction_batch(&tr, TRANSACTION_CAPTURE)) goto done;
+
+    run_transaction_batch(&tr, TRANSACTION_APPLY);
+
+    failed = 0;
+
+    for (i = 0; i < tr.num; i++) {
+        item = &tr.items[i];
+        if (item->status != NvCtrlSuccess) {
+            nv_error_msg("Error assigning value %d to attribute '%s' "
+                         "(%s%s) as specified %s (%s).",
+                         item->value, item->name, item->t->name,
+                         item->d_str, item->whence,
+                         NvCtrlAttributesStrError(item->status));
+            failed++;
+        }
+    }
+
+    if (failed) {
+        if (run_transaction_batch(&tr, TRANSACTION_ROLLBACK)) {
+            nv_error_msg("%d of %d assignments failed; the other "
+                         "assignments have been rolled back.",
+                         failed, tr.num);
+        } else {
+            nv_error_msg("%d of %d assignments failed, and some of the "
+                         "other assignments could not be rolled back.",
+                         failed, tr.num);
+        }
+        goto done;
+    }
+
+    for (i = 0; i < tr.num; i++) {
+        item = &tr.items[i];
+        if (item->flags & NV_PARSER_TYPE_PACKED_ATTRIBUTE) {
+            nv_msg("  ", "Attribute '%s' (%s%s) assigned value %d,%d.",
+                   item->name, item->t->name, item->d_str,
+                   item->value >> 16, item->value & 0xffff);
+        } else {
+            nv_msg("  ", "Attribute '%s' (%s%s) assigned value %d.",
+                   item->name, item->t->name, item->d_str, item->value);
+        }
+    }
+
+    /* print a newline at the end */
+
+    nv_msg(NULL, "");
+
+    val = NV_TRUE;
+
+ done:
+    for (i = 0; i < tr.num; i++) {
+        free(tr.items[i].whence);
+    }
+    free(tr.items);
+
+    for (i = 0; i < tr.num_handles; i++) {
+        nv_free_ctrl_handles(tr.handles[i]);
+    }
+    free(tr.handles);
+
+    return val;
+
+} /* process_attribute_transaction() */
+
+
+
+/*
+ * nv_delta_apply_init() - start a delta-apply of assignments on the X
+ * display of 'h'; see query-assign.h.
+ */
+
+NvDeltaApply *nv_delta_apply_init(CtrlHandles *h)
+{
+    NvDeltaApply *delta = calloc(1, sizeof(NvDeltaApply));
+
+    if (!delta) return NULL;
+
+    delta->tr.handles = malloc(sizeof(CtrlHandles *));
+    if (!delta->tr.handles) {
+        free(delta);
+        return NULL;
+    }
+
+    delta->tr.handles[0] = h;
+    delta->tr.num_handles = 1;
+    delta->tr.h = h;
+    delta->tr.delta = NV_TRUE;
+
+    return delta;
+
+} /* nv_delta_apply_init() */
+
+
+
+/*
+ * nv_delta_apply_add() - validate the assignment, and add it to the
+ * delta-apply.  Color and SDI color space conversion attributes cannot
+ * be queried as integers, so they are assigned right away.  Returns
+ * NV_FALSE if the assignment could not be processed (an error message
+ * is printed in that case).
+ */
+
+int nv_delta_apply_add(NvDeltaApply *delta, ParsedAttribute *a,
+                       char *whence_fmt, ...)
+{
+    char *whence;
+    int ret;
+
+    NV_VSNPRINTF(whence, whence_fmt);
+
+    if (!whence) whence = strdup("\0");
+
+    if (a->flags & (NV_PARSER_TYPE_COLOR_ATTRIBUTE |
+                    NV_PARSER_TYPE_SDI_CSC)) {
+        ret = process_parsed_attribute(a, delta->tr.h, NV_TRUE, NV_FALSE,
+                                       NULL, NULL, whence);
+        if (ret) delta->direct++;
+    } else {
+        ret = process_parsed_attribute(a, delta->tr.h, NV_TRUE, NV_FALSE,
+                                       add_delta_item, &delta->tr, whence);
+    }
+
+    free(whence);
+
+    return ret;
+
+} /* nv_delta_apply_add() */
+
+
+
+/*
+ * nv_delta_apply_finish() - query the current values of all the added
+ * assignments in one batch, and send, in one batch, only the
+ * assignments that would change a value.  The number of assignments
+ * sent and skipped is returned in 'sent' and 'skipped'; assignments
+ * made by nv_delta_apply_add() count as sent.  The NvDeltaApply is
+ * freed.
+ *
+ * Returns NV_FALSE if any assignment failed (an error message is
+ * printed for each).
+ */
+
+int nv_delta_apply_finish(NvDeltaApply *delta, int *sent, int *skipped)
+{
+    Transaction *tr = &delta->tr;
+    TransactionItem *item;
+    int i, ret = NV_TRUE;
+
+    *sent = delta->direct;
+    *skipped = 0;
+
+    if (tr->num > 0) {
+
+        run_transaction_batch(tr, TRANSACTION_CAPTURE);
+
+        for (i = 0; i < tr->num; i++) {
+            item = &tr->items[i];
+            if (item->captured && (item->old_value == item->value)) {
+                item->skip = NV_TRUE;
+                (*skipped)++;
+            } else {
+                (*sent)++;
+            }
+        }
+
+        if (*skipped < tr->num) {
+            run_transaction_batch(tr, TRANSACTION_APPLY);
+        }
+
+        for (i = 0; i < tr->num; i++) {
+            item = &tr->items[i];
+            if (item->skip || item->status == NvCtrlSuccess) continue;
+
+            nv_error_msg("Error assigning value %d to attribute '%s' "
+                         "(%s%s) as specified %s (%s).",
+                         item->value, item->name, item->t->name,
+                         item->d_str, item->whence,
+                         NvCtrlAttributesStrError(item->status));
+            ret = NV_FALSE;
+        }
+    }
+
+    for (i = 0; i < tr->num; i++) {
+        free(tr->items[i].whence);
+    }
+    free(tr->items);
+    free(tr->handles);
+    free(delta);
+
+    return ret;
+
+} /* nv_delta_apply_finish() */
+
+
+
+/*
+ * The queries and assignments given on the commandline for one X
+ * display; processed by one fan-out job.
+ */
+
+typedef struct {
+    char *display;
+    char **queries;
+    int num_queries;
+    char **assignments;
+    int num_assignments;
+    int transaction;
+} DisplayRequests;
+
+
+
+/*
+ * get_request_display() - return the display that the given query or
+ * assignment string applies to, or NULL if the string cannot be
+ * parsed (an error message is printed in that case).
+ */
+
+static char *get_request_display(char *str, int query,
+                                 const char *display_name)
+{
+    ParsedAttribute a;
+    int ret;
+
+    if (query && (nv_strcasecmp(str, "all") ||
+                  get_target_list_query(str) >= 0)) {
+        return strdup(display_name);
+    }
+
+    ret = nv_parse_attribute_string(str, query ? NV_PARSER_QUERY :
+                                    NV_PARSER_ASSIGNMENT, &a);
+    if (ret != NV_PARSER_STATUS_SUCCESS) {
+        nv_error_msg("Error parsing %s '%s' (%s).",
+                     query ? "query" : "assignment", str,
+                     nv_parse_strerror(ret));
+        return NULL;
+    }
+
+    nv_assign_default_display(&a, display_name);
+
+    return a.display;
+
+} /* get_request_display() */
+
+
+
+/*
+ * add_display_request() - add the query or assignment string to the
+ * requests for its display, creating a new entry in the list of
+ * displays as needed.
+ */
+
+static int add_display_request(DisplayRequests **requests, int *num,
+                               char *str, int query,
+                               const char *display_name)
+{
+    DisplayRequests *r = NULL;
+    char *display;
+    int i;
+
+    display = get_request_display(str, query, display_name);
+    if (!display) return NV_FALSE;
+
+    for (i = 0; i < *num; i++) {
+        if (nv_strcasecmp((*requests)[i].display, display)) {
+            r = &(*requests)[i];
+            free(display);
+            break;
+        }
+    }
+
+    if (!r) {
+        *requests = realloc(*requests, sizeof(DisplayRequests) * (*num + 1));
+        r = &(*requests)[*num];
+        memset(r, 0, sizeof(DisplayRequests));
+        r->display = display;
+        (*num)++;
+    }
+
+    if (query) {
+        r->queries = realloc(r->queries,
+                             sizeof(char *) * (r->num_queries + 1));
+        r->queries[r->num_queries++] = str;
+    } else {
+        r->assignments = realloc(r->assignments,
+                                 sizeof(char *) * (r->num_assignments + 1));
+        r->assignments[r->num_assignments++] = str;
+    }
+
+    return NV_TRUE;
+
+} /* add_display_request() */
+
+
+
+/*
+ * process_display_requests() - process the queries, and then the
+ * assignments, for one display; run by a fan-out job.
+ */
+
+static int process_display_requests(void *data)
+{
+    DisplayRequests *r = data;
+    int ret;
+
+    if (r->num_queries) {
+        ret = process_attribute_queries(r->num_queries, r->queries,
+                                        r->display);
+        if (!ret) return NV_FALSE;
+    }
+
+    if (r->num_assignments && r->transaction) {
+        ret = process_attribute_transaction(r->num_assignments,
+                                            r->assignments, r->display);
+        if (!ret) return NV_FALSE;
+    } else if (r->num_assignments) {
+        ret = process_attribute_assignments(r->num_assignments,
+                                            r->assignments, r->display);
+        if (!ret) return NV_FALSE;
+    }
+
+    return NV_TRUE;
+
+} /* process_display_requests() */
+
+
+
+/*
+ * process_display_requests_in_parallel() - group the commandline
+ * queries and assignments by X display, and process the displays in
+ * parallel (see fanout.h).  The output for each display is printed in
+ * the order in which the displays first appear on the commandline;
+ * for each display, its queries are processed before its assignments.
+ *
+ * All strings are parsed up front, so that a typo does not leave
+ * some displays configured and others not.
+ */
+
+static int process_display_requests_in_parallel(Options *op)
+{
+    DisplayRequests *requests = NULL;
+    NvFanoutJob *jobs;
+    int num = 0, i, ret;
+
+    for (i = 0; i < op->num_queries; i++) {
+        if (!add_display_request(&requests, &num, op->queries[i], NV_TRUE,
+                                 op->ctrl_display)) {
+            return NV_FALSE;
+        }
+    }
+
+    for (i = 0; i < op->num_assignments; i++) {
+        if (!add_display_request(&requests, &num, op->assignments[i],
+                                 NV_FALSE, op->ctrl_display)) {
+            return NV_FALSE;
         }
+    }
 
-        if (nv_strcasecmp(queries[query], "gvis")) {
-            query_all_targets(display_name, GVI_TARGET);
-            continue;
-        }
+    jobs = calloc(num, sizeof(NvFanoutJob));
+    if (!jobs) return NV_FALSE;
 
-        if (nv_strcasecmp(queries[query], "fans")) {
-            query_all_targets(display_name, COOLER_TARGET);
-            continue;
-        }
+    for (i = 0; i < num; i++) {
+        requests[i].transaction = op->transaction;
+        jobs[i].display = requests[i].display;
+        jobs[i].func = process_display_requests;
+        jobs[i].data = &requests[i];
+    }
 
-        if (nv_strcasecmp(queries[query], "thermalsensors")) {
-            query_all_targets(display_name, THERMAL_SENSOR_TARGET);
-            continue;
-        }
+    ret = nv_fanout_run(jobs, num, &op->fanout);
 
-        if (nv_strcasecmp(queries[query], "svps")) {
-            query_all_targets(display_name, NVIDIA_3D_VISION_PRO_TRANSCEIVER_TARGET);
-            continue;
-        }
+    for (i = 0; i < num; i++) {
+        if (!jobs[i].ret) ret = NV_FALSE;
+    }
 
-        /* call the parser to parse queries[query] */
+    /*
+     * the requests of a job that timed out are still in use by its
+     * thread; we are about to exit, so just leave them be
+     */
 
-        ret = nv_parse_attribute_string(queries[query], NV_PARSER_QUERY, &a);
-        if (ret != NV_PARSER_STATUS_SUCCESS) {
-            nv_error_msg("Error parsing query '%s' (%s).",
-                         queries[query], nv_parse_strerror(ret));
-            goto done;
-        }
-        
-        /* make sure we have a display */
+    free(jobs);
 
-        nv_assign_default_display(&a, display_name);
+    return ret;
 
-        /* allocate the CtrlHandles */
+} /* process_display_requests_in_parallel() */
 
-        h = nv_alloc_ctrl_handles(a.display);
 
-        /* call the processing engine to process the parsed query */
 
-        ret = nv_process_parsed_attribute(&a, h, NV_FALSE, NV_FALSE,
-                                          "in query '%s'", queries[query]);
-        /* free the CtrlHandles */
+/*
+ * get_batch_handles() - return the CtrlHandles for the given display,
+ * opening the display the first time it is used in the batch.
+ */
 
-        nv_free_ctrl_handles(h);
+static CtrlHandles *get_batch_handles(CtrlHandles ***handles, int *num,
+                                      const char *display)
+{
+    CtrlHandles **tmp;
+    int i;
+
+    for (i = 0; i < *num; i++) {
+        if (nv_strcasecmp((*handles)[i]->display ?
+                          (*handles)[i]->display : "",
+                          display ? display : "")) {
+            return (*handles)[i];
+        }
+    }
 
-        if (ret == NV_FALSE) goto done;
-        
-        /* print a newline at the end */
-        if (!__terse) nv_msg(NULL, "");
+    tmp = realloc(*handles, sizeof(CtrlHandles *) * (*num + 1));
+    if (!tmp) return NULL;
 
-    } /* query */
+    *handles = tmp;
+    (*handles)[*num] = nv_alloc_ctrl_handles(display);
 
-    val = NV_TRUE;
-    
- done:
-    
-    return val;
-    
-} /* process_attribute_queries() */
+    return (*handles)[(*num)++];
+
+} /* get_batch_handles() */
 
 
 
 /*
- * process_attribute_assignments() - parse the list of
- * assignments, and call nv_process_parsed_attribute() to process
- * each assignment.
- *
- * If any errors are encountered, an error message is printed and
- * NV_FALSE is returned.  Otherwise, NV_TRUE is returned.
- *
- * XXX rather than call nv_alloc_ctrl_handles()/nv_free_ctrl_handles()
- * for every assignment, we should share the code in
- * process_config_file_attributes() to collapse the list of handles.
+ * process_batch_line() - process one line of a batch file: a query,
+ * or (if the line contains an '=') an assignment, in the same form as
+ * the --query and --assign options.
  */
 
-static int process_attribute_assignments(int num, char **assignments,
-                                         const char *display_name)
+static int process_batch_line(char *line, CtrlHandles ***handles,
+                              int *num_handles, const char *display_name,
+                              int line_num, const char *filename)
 {
-    int assignment, ret, val;
     ParsedAttribute a;
     CtrlHandles *h;
+    int ret, assign, target_index;
 
-    val = NV_FALSE;
-
-    /* print a newline before we begin */
+    assign = (strchr(line, '=') != NULL);
 
-    nv_msg(NULL, "");
+    if (!assign) {
 
-    /* loop over each requested assignment */
+        /* special case the "all" and target type queries */
 
-    for (assignment = 0; assignment < num; assignment++) {
-        
-        /* call the parser to parse assignments[assignment] */
+        target_index = get_target_list_query(line);
 
-        ret = nv_parse_attribute_string(assignments[assignment],
-                                        NV_PARSER_ASSIGNMENT, &a);
+        if (nv_strcasecmp(line, "all") || target_index >= 0) {
+            h = get_batch_handles(handles, num_handles, display_name);
+            if (!h) return NV_FALSE;
 
-        if (ret != NV_PARSER_STATUS_SUCCESS) {
-            nv_error_msg("Error parsing assignment '%s' (%s).",
-                         assignments[assignment], nv_parse_strerror(ret));
-            goto done;
+            if (target_index >= 0) {
+                return query_all_targets(h, target_index);
+            }
+            return query_all(h);
         }
-        
-        /* make sure we have a display */
+    }
 
-        nv_assign_default_display(&a, display_name);
+    ret = nv_parse_attribute_string(line, assign ? NV_PARSER_ASSIGNMENT :
+                                    NV_PARSER_QUERY, &a);
+    if (ret != NV_PARSER_STATUS_SUCCESS) {
+        nv_error_msg("Error parsing %s '%s' on line %d of batch file "
+                     "'%s' (%s).", assign ? "assignment" : "query", line,
+                     line_num, filename, nv_parse_strerror(ret));
+        return NV_FALSE;
+    }
 
-        /* allocate the CtrlHandles */
+    nv_assign_default_display(&a, display_name);
 
-        h = nv_alloc_ctrl_handles(a.display);
-        
-        /* call the processing engine to process the parsed assignment */
+    h = get_batch_handles(handles, num_handles, a.display);
 
-        ret = nv_process_parsed_attribute(&a, h, NV_TRUE, NV_TRUE,
-                                          "in assignment '%s'",
-                                          assignments[assignment]);
-        /* free the CtrlHandles */
+    free(a.display);
 
-        nv_free_ctrl_handles(h);
+    if (!h) return NV_FALSE;
 
-        if (ret == NV_FALSE) goto done;
+    return nv_process_parsed_attribute(&a, h, assign, assign,
+                                       "on line %d of batch file '%s'",
+                                       line_num, filename);
 
-        /* print a newline at the end */
+} /* process_batch_line() */
 
-        nv_msg(NULL, "");
 
-    } /* assignment */
 
-    val = NV_TRUE;
+/*
+ * nv_process_batch_file() - read queries and assignments, one per
+ * line, from the file op->batch ("-" is stdin), and process them in
+ * order.  Each X display is only opened once, and its CtrlHandles are
+ * reused for all the lines that refer to it; the output of each line
+ * is flushed before the next line is read, so that the batch can be
+ * driven interactively through a pipe.
+ *
+ * Blank lines and lines starting with '#' are ignored.  An error on
+ * one line does not stop the batch; NV_FALSE is returned if any line
+ * failed.
+ */
 
- done:
+int nv_process_batch_file(Options *op)
+{
+    CtrlHandles **handles = NULL;
+    FILE *stream;
+    const char *filename;
+    char *buf = NULL, *line;
+    size_t len = 0;
+    int i, line_num, num_handles = 0, ret = NV_TRUE;
+
+    if (strcmp(op->batch, "-") == 0) {
+        stream = stdin;
+        filename = "stdin";
+    } else {
+        stream = fopen(op->batch, "r");
+        filename = op->batch;
+        if (!stream) {
+            nv_error_msg("Unable to open batch file '%s' for reading (%s).",
+                         op->batch, strerror(errno));
+            return NV_FALSE;
+        }
+    }
 
-    return val;
+    if (__query_format) nv_query_format_begin(__query_format, NV_FALSE);
+    fflush(nv_msg_output_stream());
 
-} /* nv_process_attribute_assignments() */
+    for (line_num = 1; getline(&buf, &len, stream) != -1; line_num++) {
+
+        line = (char *) parse_skip_whitespace(buf);
+        parse_chop_whitespace(line);
+
+        if (line[0] == '\0' || line[0] == '#') continue;
+
+        if (!process_batch_line(line, &handles, &num_handles,
+                                op->ctrl_display, line_num, filename)) {
+            ret = NV_FALSE;
+        }
+
+        fflush(nv_msg_output_stream());
+        fflush(stderr);
+    }
+
+    free(buf);
+
+    if (stream != stdin) fclose(stream);
+
+    for (i = 0; i < num_handles; i++) {
+        nv_free_ctrl_handles(handles[i]);
+    }
+    free(handles);
+
+    return ret;
+
+} /* nv_process_batch_file() */
 
 
 
@@ -938,47 +1959,289 @@ static void print_additional_info(const char *name,
 
 
 
+/*
+ * QueryAllSnapshot - the results gathered by query_all(): one row per
+ * (target, attribute, display mask) queried, in the order the rows
+ * are printed.  Each row's value (or string) query is queries[row->q];
+ * for integer attributes, the valid values query is queries[row->q + 1].
+ * The rows for a display device attribute's other display devices
+ * follow the row for its first display device.
+ */
+
+typedef struct {
+    CtrlHandleTarget *t;
+    AttributeTableEntry *a;
+    uint32 mask;
+    int q;                                 /* index into queries[] */
+    ReturnStatus string_valid_status;      /* string attributes only */
+    NVCTRLAttributeValidValuesRec string_valid;
+    int num_display_rows;                  /* rows for the other masks */
+} QueryAllRow;
+
+typedef struct {
+    QueryAllRow *rows;
+    int num_rows;
+    NvCtrlBatchQuery *queries;
+    int num_queries;
+} QueryAllSnapshot;
+
+
+
+/*
+ * query_all_add_row() - append a row (and its queries) to the
+ * snapshot; returns NV_FALSE if out of memory.
+ */
+
+static int query_all_add_row(QueryAllSnapshot *s, CtrlHandleTarget *t,
+                             AttributeTableEntry *a, uint32 mask)
+{
+    QueryAllRow *row;
+    NvCtrlBatchQuery *q;
+    int n = (a->flags & NV_PARSER_TYPE_STRING_ATTRIBUTE) ? 1 : 2;
+    int i;
+
+    row = realloc(s->rows, (s->num_rows + 1) * sizeof(QueryAllRow));
+    if (!row) return NV_FALSE;
+    s->rows = row;
+
+    q = realloc(s->queries, (s->num_queries + n) * sizeof(NvCtrlBatchQuery));
+    if (!q) return NV_FALSE;
+    s->queries = q;
+
+    row = &s->rows[s->num_rows++];
+    memset(row, 0, sizeof(QueryAllRow));
+    row->t = t;
+    row->a = a;
+    row->mask = mask;
+    row->q = s->num_queries;
+
+    for (i = 0; i < n; i++) {
+        q = &s->queries[s->num_queries++];
+        memset(q, 0, sizeof(NvCtrlBatchQuery));
+        q->handle = t->h;
+        q->display_mask = mask;
+        q->attr = a->attr;
+    }
+
+    q = &s->queries[row->q];
+    if (n == 1) {
+        q[0].query_type = NV_CTRL_BATCH_GET_STRING_ATTRIBUTE;
+    } else {
+        q[0].query_type = NV_CTRL_BATCH_GET_ATTRIBUTE;
+        q[1].query_type = NV_CTRL_BATCH_GET_VALID_VALUES;
+    }
+
+    return NV_TRUE;
+
+} /* query_all_add_row() */
+
+
+
+/*
+ * query_all_run() - run the queries of rows [first, num_rows) as one
+ * batch; the valid values of string attributes are not part of the
+ * batch, and are only queried for the strings that exist.
+ */
+
+static void query_all_run(QueryAllSnapshot *s, int first)
+{
+    QueryAllRow *row;
+    int i, q;
+
+    if (first >= s->num_rows) return;
+
+    q = s->rows[first].q;
+    NvCtrlQueryBatch(&s->queries[q], s->num_queries - q);
+
+    for (i = first; i < s->num_rows; i++) {
+        row = &s->rows[i];
+        if (!(row->a->flags & NV_PARSER_TYPE_STRING_ATTRIBUTE)) continue;
+        if (s->queries[row->q].status != NvCtrlSuccess) continue;
+
+        row->string_valid_status =
+            NvCtrlGetValidStringDisplayAttributeValues(row->t->h, row->mask,
+                                                       row->a->attr,
+                                                       &row->string_valid);
+    }
+
+} /* query_all_run() */
+
+
+
+/*
+ * query_all_print_row() - print one row of the snapshot; returns
+ * NV_TRUE if the rows for the attribute's other display devices
+ * should be printed as well.
+ */
+
+static int query_all_print_row(QueryAllSnapshot *s, QueryAllRow *row)
+{
+    NvCtrlBatchQuery *value = &s->queries[row->q];
+    NVCTRLAttributeValidValuesRec valid;
+    AttributeTableEntry *a = row->a;
+    CtrlHandleTarget *t = row->t;
+    ReturnStatus status;
+
+#define INDENT "  "
+
+    if (a->flags & NV_PARSER_TYPE_STRING_ATTRIBUTE) {
+
+        if (value->status == NvCtrlAttributeNotAvailable) return NV_FALSE;
+
+        if (value->status != NvCtrlSuccess) {
+            nv_error_msg("Error while querying attribute '%s' "
+                         "on %s (%s).", a->name, t->name,
+                         NvCtrlAttributesStrError(value->status));
+            return NV_FALSE;
+        }
+
+        status = row->string_valid_status;
+        valid = row->string_valid;
+
+        if (status == NvCtrlAttributeNotAvailable) return NV_FALSE;
+
+        if (status != NvCtrlSuccess) {
+            nv_error_msg("Error while querying valid values for "
+                         "attribute '%s' on %s (%s).",
+                         a->name, t->name,
+                         NvCtrlAttributesStrError(status));
+            return NV_FALSE;
+        }
+
+        if (__query_format) {
+            goto record;
+        }
+
+        if (__terse) {
+            nv_msg("  ", "%s: %s", a->name, value->string);
+        } else {
+            nv_msg("  ",  "Attribute '%s' (%s%s): %s ",
+                   a->name, t->name, "", value->string);
+        }
+
+    } else {
+
+        if (value->status == NvCtrlAttributeNotAvailable) return NV_FALSE;
+
+        if (value->status != NvCtrlSuccess) {
+            nv_error_msg("Error while querying attribute '%s' "
+                         "on %s (%s).", a->name, t->name,
+                         NvCtrlAttributesStrError(value->status));
+            return NV_FALSE;
+        }
+
+        status = value[1].status;
+        valid = value[1].valid_values;
+
+        if (status == NvCtrlAttributeNotAvailable) return NV_FALSE;
+
+        if (status != NvCtrlSuccess) {
+            nv_error_msg("Error while querying valid values for "
+                         "attribute '%s' on %s (%s).",
+                         a->name, t->name,
+                         NvCtrlAttributesStrError(status));
+            return NV_FALSE;
+        }
+
+        if (__query_format) {
+            goto record;
+        }
+
+        print_queried_value(t, &valid, (int) value->value, a->flags,
+                            a->name, row->mask, INDENT, __terse ?
+                            VerboseLevelAbbreviated :
+                            VerboseLevelVerbose);
+    }
+
+    print_valid_values(a->name, a->attr, a->flags, valid);
+
+    if (!__terse) nv_msg(NULL,"");
+
+#undef INDENT
+
+    return (valid.permissions & ATTRIBUTE_TYPE_DISPLAY) ? NV_TRUE : NV_FALSE;
+
+ record:
+
+    nv_query_format_record(__query_format, NULL, t->name, a->name, a->flags,
+                           (valid.permissions & ATTRIBUTE_TYPE_DISPLAY) ?
+                           row->mask : 0, &valid, value->value,
+                           value->string);
+
+    return (valid.permissions & ATTRIBUTE_TYPE_DISPLAY) ? NV_TRUE : NV_FALSE;
+
+} /* query_all_print_row() */
+
+
+
+/*
+ * query_all_next_mask() - return the next display device mask after
+ * 'mask' to query for a target with enabled display device mask 'd':
+ * the next set bit of 'd', or, if the target has no enabled display
+ * devices, simply the next of the 24 display device bits.  Returns 0
+ * when there are no more masks; pass a mask of 0 to get the
+ * first mask.
+ */
+
+static uint32 query_all_next_mask(uint32 d, uint32 mask)
+{
+    uint32 all = (d) ? d : ((1 << 24) - 1);
+
+    /*
+     * clear 'mask' and all the bits below it; a mask of 0 asks for
+     * the first mask
+     */
+
+    all &= mask ? ~((mask << 1) - 1) : ~0U;
+
+    return all & -all; /* lowest remaining bit */
+
+} /* query_all_next_mask() */
+
+
+
 /*
  * query_all() - loop through all target types, and query all attributes
  * for those targets.  The current attribute values for all display
  * devices on all targets are printed, along with the valid values for
  * each attribute.
  *
+ * This is done in two passes: first, every attribute is queried on
+ * every target for the target's first display device, with all
+ * NV-CONTROL queries pipelined in one batch; then, the display device
+ * attributes found by the first pass are queried, in a second batch,
+ * for the remaining enabled display devices.  The output is printed
+ * from the resulting snapshot.
+ *
  * If an error occurs, an error message is printed and NV_FALSE is
  * returned; if successful, NV_TRUE is returned.
  */
 
-static int query_all(const char *display_name)
+static int query_all(CtrlHandles *h)
 {
-    int bit, entry, target_id, val;
-    int target_type;
+    int entry, target_id, target_type, i, k, num_first_rows, first;
     uint32 mask;
-    ReturnStatus status;
     AttributeTableEntry *a;
-    NVCTRLAttributeValidValuesRec valid;
-    CtrlHandles *h;
     CtrlHandleTarget *t;
-    
-    h = nv_alloc_ctrl_handles(display_name);
+    QueryAllSnapshot s;
+    QueryAllRow *row;
+    int ret = NV_FALSE;
+
+    memset(&s, 0, sizeof(s));
 
-#define INDENT "  "
-    
     /*
-     * Loop through all target types.
+     * First pass: all attributes on all targets, for the first
+     * display device of each target.
      */
 
     for (target_type = 0; target_type < MAX_TARGET_TYPES; target_type++) {
         
         for (target_id = 0; target_id < h->targets[target_type].n; target_id++) {
 
-            t = &h->targets[target_type].t[target_id];
+            t = nv_get_ctrl_handle_target(h, target_type, target_id);
 
             if (!t->h) continue;
 
-            nv_msg(NULL, "Attributes queryable via %s:", t->name);
-
-            if (!__terse) nv_msg(NULL, "");
-
             for (entry = 0; attributeTable[entry].name; entry++) {
 
                 a = &attributeTable[entry];
@@ -987,114 +2250,109 @@ static int query_all(const char *display_name)
 
                 if (a->flags & NV_PARSER_TYPE_COLOR_ATTRIBUTE) continue;
 
-                /* skip attributes that shouldn't be queried here */
+                /* skip attributes that shouldn't be queried here */
+
+                if (a->flags & NV_PARSER_TYPE_NO_QUERY_ALL) continue;
+
+                if (!query_all_add_row(&s, t, a,
+                                       query_all_next_mask(t->d, 0))) {
+                    goto done;
+                }
+            }
+        }
+    }
+
+    num_first_rows = s.num_rows;
+    query_all_run(&s, 0);
+
+    /*
+     * Second pass: display device attributes, for the remaining
+     * display devices.
+     */
+
+    first = s.num_rows;
+
+    for (i = 0; i < num_first_rows; i++) {
+        NVCTRLAttributeValidValuesRec *valid;
+
+        row = &s.rows[i];
+
+        if (s.queries[row->q].status != NvCtrlSuccess) continue;
+
+        if (row->a->flags & NV_PARSER_TYPE_STRING_ATTRIBUTE) {
+            if (row->string_valid_status != NvCtrlSuccess) continue;
+            valid = &row->string_valid;
+        } else {
+            valid = &s.queries[row->q + 1].valid_values;
+        }
+        if (!(valid->permissions & ATTRIBUTE_TYPE_DISPLAY)) continue;
+
+        /*
+         * query_all_add_row() may move s.rows, so don't hold on to
+         * 'row' while adding to it
+         */
+
+        t = row->t;
+        a = row->a;
+
+        for (mask = query_all_next_mask(t->d, row->mask); mask;
+             mask = query_all_next_mask(t->d, mask)) {
+            if (!query_all_add_row(&s, t, a, mask)) {
+                goto done;
+            }
+            s.rows[i].num_display_rows++;
+        }
+    }
 
-                if (a->flags & NV_PARSER_TYPE_NO_QUERY_ALL) continue;
+    query_all_run(&s, first);
 
-                for (bit = 0; bit < 24; bit++) {
-                    mask = 1 << bit;
-
-                    /*
-                     * if this bit is not present in the screens's enabled
-                     * display device mask (and the X screen has enabled
-                     * display devices), skip to the next bit
-                     */
-
-                    if (((t->d & mask) == 0x0) && (t->d)) continue;
-
-                    if (a->flags & NV_PARSER_TYPE_STRING_ATTRIBUTE) {
-                        char *tmp_str = NULL;
-
-                        status = NvCtrlGetValidStringDisplayAttributeValues(t->h, mask,
-                                                                            a->attr, &valid);
-                        if (status == NvCtrlAttributeNotAvailable) goto exit_bit_loop;
-
-                        if (status != NvCtrlSuccess) {
-                            nv_error_msg("Error while querying valid values for "
-                                         "attribute '%s' on %s (%s).",
-                                         a->name, t->name,
-                                         NvCtrlAttributesStrError(status));
-                            goto exit_bit_loop;
-                        }
-                        
-                        status = NvCtrlGetStringDisplayAttribute(t->h, mask, a->attr, &tmp_str);
-
-                        if (status == NvCtrlAttributeNotAvailable) goto exit_bit_loop;
-
-                        if (status != NvCtrlSuccess) {
-                            nv_error_msg("Error while querying attribute '%s' "
-                                         "on %s (%s).", a->name, t->name,
-                                         NvCtrlAttributesStrError(status));
-                            goto exit_bit_loop;
-                        }
-
-                        if (__terse) {
-                            nv_msg("  ", "%s: %s", a->name, tmp_str);
-                        } else {
-                            nv_msg("  ",  "Attribute '%s' (%s%s): %s ",
-                                   a->name, t->name, "", tmp_str);
-                        }
-                        free(tmp_str);
-                        tmp_str = NULL;
-
-                    } else {
-                        
-                        status = NvCtrlGetValidDisplayAttributeValues(t->h, mask, a->attr, &valid);
-
-                        if (status == NvCtrlAttributeNotAvailable) goto exit_bit_loop;
-
-                        if (status != NvCtrlSuccess) {
-                            nv_error_msg("Error while querying valid values for "
-                                         "attribute '%s' on %s (%s).",
-                                         a->name, t->name,
-                                         NvCtrlAttributesStrError(status));
-                            goto exit_bit_loop;
-                        }
-
-                        status = NvCtrlGetDisplayAttribute(t->h, mask, a->attr, &val);
-
-                        if (status == NvCtrlAttributeNotAvailable) goto exit_bit_loop;
-
-                        if (status != NvCtrlSuccess) {
-                            nv_error_msg("Error while querying attribute '%s' "
-                                         "on %s (%s).", a->name, t->name,
-                                         NvCtrlAttributesStrError(status));
-                            goto exit_bit_loop;
-                        }
-
-                        print_queried_value(t, &valid, val, a->flags, a->name,
-                                            mask, INDENT, __terse ?
-                                            VerboseLevelAbbreviated :
-                                            VerboseLevelVerbose);
+    /*
+     * Print the snapshot
+     */
 
-                    }
-                    print_valid_values(a->name, a->attr, a->flags, valid);
+    i = 0;
+    k = first;
 
-                    if (!__terse) nv_msg(NULL,"");
+    for (target_type = 0; target_type < MAX_TARGET_TYPES; target_type++) {
+        
+        for (target_id = 0; target_id < h->targets[target_type].n; target_id++) {
 
-                    if (valid.permissions & ATTRIBUTE_TYPE_DISPLAY) {
-                        continue;
-                    }
+            t = nv_get_ctrl_handle_target(h, target_type, target_id);
 
-                    /* fall through to exit_bit_loop */
+            if (!t->h) continue;
 
-exit_bit_loop:
+            if (!__query_format) {
+                nv_msg(NULL, "Attributes queryable via %s:", t->name);
 
-                    bit = 25; /* XXX force us out of the display device loop */
+                if (!__terse) nv_msg(NULL, "");
+            }
 
-                } /* bit */
+            for (; i < num_first_rows && s.rows[i].t == t; i++) {
+                int print = query_all_print_row(&s, &s.rows[i]);
+                int n;
 
-            } /* entry */
+                for (n = 0; n < s.rows[i].num_display_rows; n++, k++) {
+                    if (print) print = query_all_print_row(&s, &s.rows[k]);
+                }
+            }
+        }
+    }
 
-        } /* target_id */
+    ret = NV_TRUE;
 
-    } /* target_type */
+ done:
 
-#undef INDENT
+    if (!ret) {
+        nv_error_msg("Out of memory while querying all attributes.");
+    }
 
-    nv_free_ctrl_handles(h);
+    for (i = 0; i < s.num_queries; i++) {
+        free(s.queries[i].string);
+    }
+    free(s.queries);
+    free(s.rows);
 
-    return NV_TRUE;
+    return ret;
 
 } /* query_all() */
 
@@ -1235,17 +2493,18 @@ static int print_target_connections(CtrlHandles *h,
         if (pData[i] >= 0 &&
             pData[i] < h->targets[target_index].n) {
 
-            target_name = h->targets[target_index].t[ pData[i] ].name;
+            CtrlHandleTarget *c =
+                nv_get_ctrl_handle_target(h, target_index, pData[i]);
+
+            target_name = c->name;
 
             switch (target_index) {
             case GPU_TARGET:
-                product_name =
-                    get_gpu_name(h->targets[target_index].t[ pData[i] ].h);
+                product_name = get_gpu_name(c->h);
                 break;
                 
             case VCS_TARGET:
-                product_name =
-                    get_vcs_name(h->targets[target_index].t[ pData[i] ].h);
+                product_name = get_vcs_name(c->h);
                 break;
 
             case NVIDIA_3D_VISION_PRO_TRANSCEIVER_TARGET:
@@ -1295,9 +2554,8 @@ static int print_target_connections(CtrlHandles *h,
  * specified type) accessible via the Display connection.
  */
 
-static int query_all_targets(const char *display_name, const int target_index)
+static int query_all_targets(CtrlHandles *h, const int target_index)
 {
-    CtrlHandles *h;
     CtrlHandleTarget *t;
     ReturnStatus status;
     int i, table_index;
@@ -1316,10 +2574,6 @@ static int query_all_targets(const char *display_name, const int target_index)
 
     if (table_index == -1) return NV_FALSE;
 
-    /* create handles */
-
-    h = nv_alloc_ctrl_handles(display_name);
-    
     /* build the standard X server name */
     
     str = nv_standardize_screen_name(XDisplayName(h->display), -2);
@@ -1332,7 +2586,6 @@ static int query_all_targets(const char *display_name, const int target_index)
                        targetTypeTable[table_index].name, str);
         
         free(str);
-        nv_free_ctrl_handles(h);
         return NV_FALSE;
     }
     
@@ -1351,7 +2604,7 @@ static int query_all_targets(const char *display_name, const int target_index)
 
     for (i = 0; i < h->targets[target_index].n; i++) {
         
-        t = &h->targets[target_index].t[i];
+        t = nv_get_ctrl_handle_target(h, target_index, i);
         
         str = NULL;
         if (target_index == NVIDIA_3D_VISION_PRO_TRANSCEIVER_TARGET) {
@@ -1482,8 +2735,6 @@ static int query_all_targets(const char *display_name, const int target_index)
         }
     }
     
-    nv_free_ctrl_handles(h);
-    
     return NV_TRUE;
     
 } /* query_all_targets() */
@@ -1509,6 +2760,8 @@ static int process_parsed_attribute_internal(CtrlHandleTarget *t,
     char str[32], *tmp_d_str;
     int ret;
     
+    /* str is only set for display device specific attributes */
+
     if (valid.permissions & ATTRIBUTE_TYPE_DISPLAY) {
         tmp_d_str = display_device_mask_to_display_device_name(d);
         sprintf(str, ", display device: %s", tmp_d_str);
@@ -1560,7 +2813,11 @@ static int process_parsed_attribute_internal(CtrlHandleTarget *t,
                 return NV_FALSE;
             } else {
 
-                if (__terse) {
+                if (__query_format) {
+                    nv_query_format_record(__query_format, NULL, t->name, a->name,
+                                           a->flags, str[0] ? d : 0,
+                                           &valid, 0, tmp_str);
+                } else if (__terse) {
                     nv_msg(NULL, "%s", tmp_str);
                 } else {
                     nv_msg("  ",  "Attribute '%s' (%s%s): %s",
@@ -1583,6 +2840,10 @@ static int process_parsed_attribute_internal(CtrlHandleTarget *t,
                              a->name, t->name, str, whence,
                              NvCtrlAttributesStrError(status));
                 return NV_FALSE;
+            } else if (__query_format) {
+                nv_query_format_record(__query_format, NULL, t->name, a->name,
+                                       a->flags, str[0] ? d : 0,
+                                       &valid, a->val, NULL);
             } else {
                 print_queried_value(t, &valid, a->val, a->flags, a->name, d,
                                     "  ", __terse ?
@@ -1599,7 +2860,7 @@ static int process_parsed_attribute_internal(CtrlHandleTarget *t,
 
 
 /*
- * nv_process_parsed_attribute() - this is the processing engine for
+ * process_parsed_attribute() - this is the processing engine for
  * all parsed attributes.
  *
  * A parsed attribute may or may not specify a target (X screen, GPU,
@@ -1637,23 +2898,30 @@ static int process_parsed_attribute_internal(CtrlHandleTarget *t,
  * well as the number of targets, an array of enabled display devices
  * for each target, and a string description of each target.
  *
- * The whence_fmt and following varargs are used by the callee to
- * describe where the attribute came from.  A whence string should be
+ * The whence string (built by nv_process_parsed_attribute() from
+ * whence_fmt and the following varargs) describes where the
+ * attribute came from.  A whence string should be
  * something like "on line 12 of config file ~/.nvidia-settings-rc" or
  * "in query ':0.0/fsaa'".  Whence is used in the case of an error to
  * indicate where the error came from.
  *
+ * If 'collect' is non-NULL, nothing is queried or assigned; instead,
+ * 'collect' is called with 'collect_data' for each target and display
+ * device that would have been processed (see nv_watch_attributes()
+ * and process_attribute_transaction()).
+ *
  * If successful, the processing determined by 'assign' and 'verbose'
  * will be done and NV_TRUE will be returned.  If an error occurs, an
  * error message will be printed and NV_FALSE will be returned.
  */
 
-int nv_process_parsed_attribute(ParsedAttribute *a, CtrlHandles *h,
-                                int assign, int verbose,
-                                char *whence_fmt, ...)
+static int process_parsed_attribute(ParsedAttribute *a, CtrlHandles *h,
+                                    int assign, int verbose,
+                                    CollectTargetFunc collect,
+                                    void *collect_data, char *whence)
 {
     int i, target, start, end, bit, ret, val, target_type_index;
-    char *whence, *tmp_d_str0, *tmp_d_str1, *target_type_name;
+    char *tmp_d_str0, *tmp_d_str1, *target_type_name;
     uint32 display_devices, mask;
     ReturnStatus status;
     NVCTRLAttributeValidValuesRec valid;
@@ -1661,12 +2929,6 @@ int nv_process_parsed_attribute(ParsedAttribute *a, CtrlHandles *h,
 
     val = NV_FALSE;
 
-    /* build the whence string */
-
-    NV_VSNPRINTF(whence, whence_fmt);
-    
-    if (!whence) whence = strdup("\0");
-
     /* if we don't have a Display connection, abort now */
 
     if (!h->dpy) {
@@ -1730,7 +2992,7 @@ int nv_process_parsed_attribute(ParsedAttribute *a, CtrlHandles *h,
          * screens will be controlled by NVIDIA
          */
 
-        if (!h->targets[target].t[a->target_id].h) {
+        if (!nv_get_ctrl_handle_target(h, target, a->target_id)->h) {
             nv_warning_msg("Invalid %s %d specified %s (NV-CONTROL extension "
                          "not supported on %s %d).",
                          target_type_name,
@@ -1776,7 +3038,7 @@ int nv_process_parsed_attribute(ParsedAttribute *a, CtrlHandles *h,
     
     for (i = start; i < end; i++) {
         
-        t = &h->targets[target].t[i];
+        t = nv_get_ctrl_handle_target(h, target, i);
 
         if (!t->h) continue; /* no handle on this target; silently skip */
 
@@ -2167,8 +3429,14 @@ int nv_process_parsed_attribute(ParsedAttribute *a, CtrlHandles *h,
                 goto done;
             }
             
-            ret = process_parsed_attribute_internal(t, a, mask, target, assign,
-                                                    verbose, whence, valid);
+            if (collect) {
+                ret = collect(collect_data, t, a, mask, target, whence,
+                              valid);
+            } else {
+                ret = process_parsed_attribute_internal(t, a, mask, target,
+                                                        assign, verbose,
+                                                        whence, valid);
+            }
             if (ret == NV_FALSE) goto done;
             
             /*
@@ -2191,7 +3459,492 @@ int nv_process_parsed_attribute(ParsedAttribute *a, CtrlHandles *h,
     val = NV_TRUE;
     
  done:
-    if (whence) free(whence);
     return val;
 
+} /* process_parsed_attribute() */
+
+
+
+/*
+ * nv_process_parsed_attribute() - build the whence string from
+ * whence_fmt, and process the parsed attribute; see
+ * process_parsed_attribute().
+ */
+
+int nv_process_parsed_attribute(ParsedAttribute *a, CtrlHandles *h,
+                                int assign, int verbose,
+                                char *whence_fmt, ...)
+{
+    char *whence;
+    int ret;
+
+    /* build the whence string */
+
+    NV_VSNPRINTF(whence, whence_fmt);
+    
+    if (!whence) whence = strdup("\0");
+
+    ret = process_parsed_attribute(a, h, assign, verbose, NULL, NULL,
+                                   whence);
+
+    free(whence);
+
+    return ret;
+
 } /* nv_process_parsed_attribute() */
+
+
+
+/*
+ * The attributes given to --watch; see nv_watch_attributes().  Each
+ * WatchItem is one target and display device of one attribute.
+ */
+
+typedef struct {
+    CtrlHandleTarget *t;
+    const char *name;
+    int attr;
+    uint32 flags;
+    uint32 mask;        /* display device mask used to query the value */
+    NVCTRLAttributeValidValuesRec valid;
+    int poll;           /* NV_TRUE if no events are sent for this item */
+    int have_value;
+    int value;
+    char *string;
+} WatchItem;
+
+typedef struct {
+    WatchItem *items;
+    int num;
+} WatchList;
+
+
+
+/*
+ * add_watch_item() - called by process_parsed_attribute() for each
+ * target and display device that the attribute 'a' applies to.
+ *
+ * The X server only sends attribute changed events when an attribute
+ * is assigned by a client, so only writable attributes are watched
+ * through events; all others have to be polled.  String attribute
+ * values are always polled: their events do not carry the new value.
+ */
+
+static int add_watch_item(void *data, CtrlHandleTarget *t,
+                          ParsedAttribute *a, uint32 d, int target_type,
+                          char *whence, NVCTRLAttributeValidValuesRec valid)
+{
+    WatchList *watch = data;
+    WatchItem *w;
+
+    w = realloc(watch->items, sizeof(WatchItem) * (watch->num + 1));
+    if (!w) {
+        nv_error_msg("Unable to allocate memory to watch attribute '%s'.",
+                     a->name);
+        return NV_FALSE;
+    }
+
+    watch->items = w;
+    w = &watch->items[watch->num++];
+
+    memset(w, 0, sizeof(WatchItem));
+
+    w->t = t;
+    w->name = a->name;
+    w->attr = a->attr;
+    w->flags = a->flags;
+    w->mask = d;
+    w->valid = valid;
+    w->poll = !(valid.permissions & ATTRIBUTE_TYPE_WRITE) ||
+        (a->flags & NV_PARSER_TYPE_STRING_ATTRIBUTE);
+
+    return NV_TRUE;
+
+} /* add_watch_item() */
+
+
+
+/*
+ * split_watch_list() - split the --watch argument at the commas that
+ * are not within brackets (target and display device specifications
+ * may contain commas).  Returns a NULL terminated array of strings,
+ * all allocated in one block; the caller frees the array.
+ */
+
+static char **split_watch_list(const char *str, int *num)
+{
+    char **list, *s, *p;
+    int n, depth;
+
+    /* count the items, to size the array */
+
+    n = 1;
+    for (depth = 0, p = (char *) str; *p; p++) {
+        if (*p == '[') depth++;
+        if (*p == ']' && depth > 0) depth--;
+        if (*p == ',' && depth == 0) n++;
+    }
+
+    list = malloc(sizeof(char *) * (n + 1) + strlen(str) + 1);
+    if (!list) return NULL;
+
+    s = (char *) (list + n + 1);
+    strcpy(s, str);
+
+    n = 0;
+    list[n++] = s;
+
+    for (depth = 0, p = s; *p; p++) {
+        if (*p == '[') depth++;
+        if (*p == ']' && depth > 0) depth--;
+        if (*p == ',' && depth == 0) {
+            *p = '\0';
+            list[n++] = p + 1;
+        }
+    }
+
+    list[n] = NULL;
+    *num = n;
+
+    return list;
+
+} /* split_watch_list() */
+
+
+
+/*
+ * get_watch_timestamp() - write the current local time, with
+ * milliseconds, in ISO 8601 form.
+ */
+
+static void get_watch_timestamp(char *buf, size_t len)
+{
+    struct timeval tv;
+    struct tm tm;
+    size_t n;
+
+    gettimeofday(&tv, NULL);
+    localtime_r(&tv.tv_sec, &tm);
+
+    n = strftime(buf, len, "%Y-%m-%dT%H:%M:%S", &tm);
+    snprintf(buf + n, len - n, ".%03d", (int) (tv.tv_usec / 1000));
+
+} /* get_watch_timestamp() */
+
+
+
+/*
+ * print_watch_item() - print the current value of the watched item,
+ * as one timestamped line.
+ */
+
+static void print_watch_item(WatchItem *w)
+{
+    char stamp[64], indent[80], *tmp_d_str;
+    uint32 display_mask;
+
+    get_watch_timestamp(stamp, sizeof(stamp));
+
+    display_mask = (w->valid.permissions & ATTRIBUTE_TYPE_DISPLAY) ?
+        w->mask : 0;
+
+    if (__query_format) {
+        nv_query_format_record(__query_format, stamp, w->t->name, w->name,
+                               w->flags, display_mask, &w->valid, w->value,
+                               w->string);
+    } else if (w->string) {
+        snprintf(indent, sizeof(indent), "[%s] ", stamp);
+        if (display_mask) {
+            tmp_d_str = display_device_mask_to_display_device_name(w->mask);
+            nv_msg(indent, "Attribute '%s' (%s; display device: %s): %s.",
+                   w->name, w->t->name, tmp_d_str, w->string);
+            free(tmp_d_str);
+        } else {
+            nv_msg(indent, "Attribute '%s' (%s): %s.",
+                   w->name, w->t->name, w->string);
+        }
+    } else {
+        snprintf(indent, sizeof(indent), "[%s] ", stamp);
+        print_queried_value(w->t, &w->valid, w->value, w->flags,
+                            (char *) w->name, w->mask, indent,
+                            __terse ? VerboseLevelAbbreviated :
+                            VerboseLevelVerbose);
+    }
+
+    fflush(nv_msg_output_stream());
+
+} /* print_watch_item() */
+
+
+
+/*
+ * update_watch_item() - query the current value of the watched item,
+ * and print it if it changed.  Errors are only reported the first
+ * time the item is queried; after that, the item keeps its last
+ * value until it can be queried again.
+ */
+
+static int update_watch_item(WatchItem *w)
+{
+    ReturnStatus status;
+    char *str = NULL;
+    int val = 0;
+
+    if (w->flags & NV_PARSER_TYPE_STRING_ATTRIBUTE) {
+        status = NvCtrlGetStringDisplayAttribute(w->t->h, w->mask, w->attr,
+                                                 &str);
+    } else {
+        status = NvCtrlGetDisplayAttribute(w->t->h, w->mask, w->attr, &val);
+    }
+
+    if (status != NvCtrlSuccess) {
+        if (!w->have_value) {
+            nv_error_msg("Error while querying attribute '%s' on %s (%s).",
+                         w->name, w->t->name,
+                         NvCtrlAttributesStrError(status));
+            return NV_FALSE;
+        }
+        return NV_TRUE;
+    }
+
+    if (w->have_value &&
+        ((str && w->string && strcmp(str, w->string) == 0) ||
+         (!str && val == w->value))) {
+        free(str);
+        return NV_TRUE;
+    }
+
+    free(w->string);
+    w->string = str;
+    w->value = val;
+    w->have_value = NV_TRUE;
+
+    print_watch_item(w);
+
+    return NV_TRUE;
+
+} /* update_watch_item() */
+
+
+
+/*
+ * handle_watch_event() - update the watched items that the NV-CONTROL
+ * event is about.
+ */
+
+static void handle_watch_event(WatchList *watch, XEvent *event,
+                               int event_base)
+{
+    XNVCtrlAttributeChangedEventTarget *e;
+    XNVCtrlStringAttributeChangedEventTarget *s;
+    WatchItem *w;
+    int i, target_type, target_id, attr;
+    unsigned int display_mask;
+
+    if (event->type == event_base + TARGET_ATTRIBUTE_CHANGED_EVENT) {
+        e = (XNVCtrlAttributeChangedEventTarget *) event;
+        target_type = e->target_type;
+        target_id = e->target_id;
+        display_mask = e->display_mask;
+        attr = e->attribute;
+    } else if (event->type ==
+               event_base + TARGET_STRING_ATTRIBUTE_CHANGED_EVENT) {
+        s = (XNVCtrlStringAttributeChangedEventTarget *) event;
+        target_type = s->target_type;
+        target_id = s->target_id;
+        display_mask = s->display_mask;
+        attr = s->attribute;
+    } else {
+        return;
+    }
+
+    for (i = 0; i < watch->num; i++) {
+        w = &watch->items[i];
+
+        if (w->attr != attr ||
+            NvCtrlGetTargetType(w->t->h) != target_type ||
+            NvCtrlGetTargetId(w->t->h) != target_id) {
+            continue;
+        }
+
+        if ((w->valid.permissions & ATTRIBUTE_TYPE_DISPLAY) &&
+            display_mask && !(display_mask & w->mask)) {
+            continue;
+        }
+
+        if (((w->flags & NV_PARSER_TYPE_STRING_ATTRIBUTE) != 0) !=
+            (event->type ==
+             event_base + TARGET_STRING_ATTRIBUTE_CHANGED_EVENT)) {
+            continue;
+        }
+
+        /*
+         * the event carries the new integer value, but query it
+         * anyway: the event may be for several display devices
+         */
+
+        update_watch_item(w);
+    }
+
+} /* handle_watch_event() */
+
+
+
+/*
+ * nv_watch_attributes() - watch the attributes given with --watch,
+ * printing a timestamped line whenever one of them changes, until the
+ * connection to the X server is lost.
+ *
+ * All of the attributes are watched over a single connection to the
+ * X server.  The handles subscribe to the NV-CONTROL attribute changed
+ * events when they are created, so writable attributes are updated as
+ * their events arrive; the others are sampled every
+ * op->watch_interval milliseconds.  Only changed values are printed,
+ * after the initial value of each attribute.
+ *
+ * Returns NV_FALSE if an attribute could not be watched.
+ */
+
+int nv_watch_attributes(Options *op)
+{
+    WatchList watch = { NULL, 0 };
+    ParsedAttribute a;
+    CtrlHandles *h = NULL;
+    char **list, *whence, *display = NULL;
+    XEvent event;
+    struct timeval now, next_poll, tv;
+    fd_set fds;
+    int i, num, ret, fd, event_base, have_poll, val = NV_FALSE;
+
+    list = split_watch_list(op->watch, &num);
+    if (!list) {
+        nv_error_msg("Unable to allocate memory for the watched attributes.");
+        return NV_FALSE;
+    }
+
+    /* parse each attribute, and collect the items to watch */
+
+    for (i = 0; i < num; i++) {
+
+        ret = nv_parse_attribute_string(list[i], NV_PARSER_QUERY, &a);
+        if (ret != NV_PARSER_STATUS_SUCCESS) {
+            nv_error_msg("Error parsing watched attribute '%s' (%s).",
+                         list[i], nv_parse_strerror(ret));
+            goto done;
+        }
+
+        if (a.flags & (NV_PARSER_TYPE_COLOR_ATTRIBUTE |
+                       NV_PARSER_TYPE_SDI_CSC)) {
+            nv_error_msg("The attribute '%s' cannot be watched.", a.name);
+            free(a.display);
+            goto done;
+        }
+
+        nv_assign_default_display(&a, op->ctrl_display);
+
+        /* all of the attributes share one connection */
+
+        if (!h) {
+            display = a.display ? strdup(a.display) : NULL;
+            h = nv_alloc_ctrl_handles(display);
+        } else if (!nv_strcasecmp(a.display ? a.display : "",
+                                  display ? display : "")) {
+            nv_error_msg("The watched attribute '%s' is not on X display "
+                         "'%s'; all watched attributes must be on the same "
+                         "X display.", list[i], display ? display : "");
+            free(a.display);
+            goto done;
+        }
+
+        free(a.display);
+
+        whence = nvstrcat("in watched attribute '", list[i], "'", NULL);
+        ret = process_parsed_attribute(&a, h, NV_FALSE, NV_FALSE,
+                                       add_watch_item, &watch, whence);
+        nvfree(whence);
+
+        if (!ret) goto done;
+    }
+
+    if (watch.num == 0) {
+        nv_error_msg("None of the watched attributes are available.");
+        goto done;
+    }
+
+    /* print the initial values */
+
+    if (__query_format) nv_query_format_begin(__query_format, NV_TRUE);
+
+    have_poll = NV_FALSE;
+
+    for (i = 0; i < watch.num; i++) {
+        if (!update_watch_item(&watch.items[i])) goto done;
+        if (watch.items[i].poll) have_poll = NV_TRUE;
+    }
+
+    fd = ConnectionNumber(h->dpy);
+    event_base = NvCtrlGetEventBase(watch.items[0].t->h);
+
+    gettimeofday(&next_poll, NULL);
+
+    while (1) {
+
+        /* handle the events that have already arrived */
+
+        while (XPending(h->dpy)) {
+            XNextEvent(h->dpy, &event);
+            handle_watch_event(&watch, &event, event_base);
+        }
+
+        /* sample the attributes that do not generate events */
+
+        if (have_poll) {
+            gettimeofday(&now, NULL);
+
+            if (!timercmp(&now, &next_poll, <)) {
+                for (i = 0; i < watch.num; i++) {
+                    if (watch.items[i].poll) {
+                        update_watch_item(&watch.items[i]);
+                    }
+                }
+
+                tv.tv_sec = op->watch_interval / 1000;
+                tv.tv_usec = (op->watch_interval % 1000) * 1000;
+                timeradd(&next_poll, &tv, &next_poll);
+
+                /* don't try to catch up after falling behind */
+
+                if (timercmp(&next_poll, &now, <)) {
+                    timeradd(&now, &tv, &next_poll);
+                }
+            }
+
+            timersub(&next_poll, &now, &tv);
+        }
+
+        /* wait for the next event, or the next sample */
+
+        FD_ZERO(&fds);
+        FD_SET(fd, &fds);
+
+        ret = select(fd + 1, &fds, NULL, NULL, have_poll ? &tv : NULL);
+        if (ret < 0 && errno != EINTR) {
+            nv_error_msg("Error while waiting for events from X display "
+                         "'%s' (%s).", XDisplayName(display),
+                         strerror(errno));
+            goto done;
+        }
+    }
+
+ done:
+    for (i = 0; i < watch.num; i++) {
+        free(watch.items[i].string);
+    }
+    free(watch.items);
+    free(list);
+    free(display);
+    nv_free_ctrl_handles(h);
+
+    return val;
+
+} /* nv_watch_attributes() */
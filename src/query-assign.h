@@ -49,6 +49,7 @@ typedef struct {
     uint32 d;                 /* display device mask for this target */
     uint32 c;                 /* Connected display device mask for target */
     char *name;               /* name for this target */
+    int initialized;          /* set up by nv_get_ctrl_handle_target() */
 } CtrlHandleTarget;
 
 typedef struct {
@@ -67,8 +68,28 @@ int nv_process_assignments_and_queries(Options *op);
 
 CtrlHandles *nv_alloc_ctrl_handles(const char *display);
 void nv_free_ctrl_handles(CtrlHandles *h);
+CtrlHandleTarget *nv_get_ctrl_handle_target(CtrlHandles *h,
+                                            int target_index, int target_id);
 
 int nv_process_parsed_attribute(ParsedAttribute*, CtrlHandles *h,
                                 int, int, char*, ...);
 
+/*
+ * Delta-apply: assignments added to an NvDeltaApply are validated, but
+ * not sent.  nv_delta_apply_finish() queries all of their current
+ * values in one batch, and sends only the assignments that change a
+ * value, in one pipelined batch.
+ */
+
+typedef struct _NvDeltaApply NvDeltaApply;
+
+NvDeltaApply *nv_delta_apply_init(CtrlHandles *h);
+int nv_delta_apply_add(NvDeltaApply *delta, ParsedAttribute *a,
+                       char *whence_fmt, ...);
+int nv_delta_apply_finish(NvDeltaApply *delta, int *sent, int *skipped);
+
+int nv_watch_attributes(Options *op);
+
+int nv_process_batch_file(Options *op);
+
 #endif /* __QUERY_ASSIGN_H__ */
@@ -0,0 +1,439 @@
+/*
+ * nvidia-settings: A tool for configuring the NVIDIA X driver on Unix
+ * and Linux systems.
+ *
+ * Copyright (C) 2004 NVIDIA Corporation.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of Version 2 of the GNU General Public
+ * License as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See Version 2
+ * of the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the:
+ *
+ *           Free Software Foundation, Inc.
+ *           59 Temple Place - Suite 330
+ *           Boston, MA 02111-1307, USA
+ *
+ */
+
+/*
+ * query-format.c - this source file contains the writers for the
+ * machine-readable query output formats; see query-format.h.
+ *
+ * Each record is built in a RecordBuffer, and written to the output
+ * stream with a single fwrite(3), so that records from parallel
+ * queries are never interleaved and no per-line allocations are
+ * needed.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdarg.h>
+#include <inttypes.h>
+
+#include "query-format.h"
+#include "msg.h"
+
+
+typedef struct {
+    char *buf;
+    size_t len;
+    size_t size;
+    char storage[1024];
+} RecordBuffer;
+
+
+/*
+ * The record fields, in CSV column order.
+ */
+
+static const char *csv_columns =
+    "target,attribute,display_device,display_mask,type,value,min,max,"
+    "valid_values,writable,display_specific,target_types\n";
+
+
+
+static void buf_init(RecordBuffer *b)
+{
+    b->buf = b->storage;
+    b->len = 0;
+    b->size = sizeof(b->storage);
+}
+
+
+static void buf_putn(RecordBuffer *b, const char *s, size_t n)
+{
+    char *buf;
+    size_t size;
+
+    if (b->len + n > b->size) {
+        size = b->size * 2;
+        while (b->len + n > size) size *= 2;
+
+        if (b->buf == b->storage) {
+            buf = malloc(size);
+            if (buf) memcpy(buf, b->buf, b->len);
+        } else {
+            buf = realloc(b->buf, size);
+        }
+        if (!buf) return;
+
+        b->buf = buf;
+        b->size = size;
+    }
+
+    memcpy(b->buf + b->len, s, n);
+    b->len += n;
+}
+
+
+static void buf_puts(RecordBuffer *b, const char *s)
+{
+    buf_putn(b, s, strlen(s));
+}
+
+
+static void buf_printf(RecordBuffer *b, const char *fmt, ...)
+{
+    char tmp[64];
+    va_list ap;
+    int n;
+
+    va_start(ap, fmt);
+    n = vsnprintf(tmp, sizeof(tmp), fmt, ap);
+    va_end(ap);
+
+    if (n < 0) return;
+    if (n >= sizeof(tmp)) n = sizeof(tmp) - 1;
+
+    buf_putn(b, tmp, n);
+}
+
+
+static void buf_write(RecordBuffer *b)
+{
+    fwrite(b->buf, 1, b->len, nv_msg_output_stream());
+
+    if (b->buf != b->storage) free(b->buf);
+    buf_init(b);
+}
+
+
+
+/*
+ * put_quoted() - append 'str', quoted as needed for the format: JSON
+ * strings are always quoted and escaped; CSV fields and KV values are
+ * only quoted if they contain a separator or quote.
+ */
+
+static void put_quoted(RecordBuffer *b, int format, const char *str)
+{
+    const char *c;
+
+    switch (format) {
+
+    case NV_QUERY_FORMAT_JSON:
+        buf_putn(b, "\"", 1);
+        for (c = str; *c; c++) {
+            switch (*c) {
+            case '"':  buf_puts(b, "\\\""); break;
+            case '\\': buf_puts(b, "\\\\"); break;
+            case '\n': buf_puts(b, "\\n"); break;
+            case '\r': buf_puts(b, "\\r"); break;
+            case '\t': buf_puts(b, "\\t"); break;
+            default:
+                if ((unsigned char) *c < 0x20) {
+                    buf_printf(b, "\\u%04x", (unsigned char) *c);
+                } else {
+                    buf_putn(b, c, 1);
+                }
+                break;
+            }
+        }
+        buf_putn(b, "\"", 1);
+        break;
+
+    case NV_QUERY_FORMAT_CSV:
+        if (!strpbrk(str, ",\"\r\n")) {
+            buf_puts(b, str);
+            break;
+        }
+        buf_putn(b, "\"", 1);
+        for (c = str; *c; c++) {
+            if (*c == '"') buf_putn(b, "\"", 1);
+            buf_putn(b, c, 1);
+        }
+        buf_putn(b, "\"", 1);
+        break;
+
+    case NV_QUERY_FORMAT_KV:
+        if (*str && !strpbrk(str, " =\"\\\t\r\n")) {
+            buf_puts(b, str);
+            break;
+        }
+        buf_putn(b, "\"", 1);
+        for (c = str; *c; c++) {
+            if (*c == '"' || *c == '\\') buf_putn(b, "\\", 1);
+            if (*c == '\n') {
+                buf_puts(b, "\\n");
+            } else {
+                buf_putn(b, c, 1);
+            }
+        }
+        buf_putn(b, "\"", 1);
+        break;
+    }
+
+} /* put_quoted() */
+
+
+
+/*
+ * put_key() - start a field; in the KV format, fields without a value
+ * ('present' is NV_FALSE) are left out entirely.  Returns NV_FALSE if
+ * the value should not be appended.
+ */
+
+static int put_key(RecordBuffer *b, int format, const char *key,
+                   int *first, int present)
+{
+    switch (format) {
+
+    case NV_QUERY_FORMAT_JSON:
+        buf_puts(b, *first ? "{\"" : ",\"");
+        buf_puts(b, key);
+        buf_puts(b, "\":");
+        if (!present) buf_puts(b, "null");
+        break;
+
+    case NV_QUERY_FORMAT_CSV:
+        if (!*first) buf_putn(b, ",", 1);
+        break;
+
+    case NV_QUERY_FORMAT_KV:
+        if (!present) return NV_FALSE;
+        if (!*first) buf_putn(b, " ", 1);
+        buf_puts(b, key);
+        buf_putn(b, "=", 1);
+        break;
+    }
+
+    *first = NV_FALSE;
+
+    return present;
+
+} /* put_key() */
+
+
+static void put_string(RecordBuffer *b, int format, const char *key,
+                       int *first, const char *str)
+{
+    if (put_key(b, format, key, first, str != NULL)) {
+        put_quoted(b, format, str);
+    }
+}
+
+
+static void put_int(RecordBuffer *b, int format, const char *key,
+                    int *first, int present, int64_t value)
+{
+    if (put_key(b, format, key, first, present)) {
+        buf_printf(b, "%" PRId64, value);
+    }
+}
+
+
+static void put_bool(RecordBuffer *b, int format, const char *key,
+                     int *first, int value)
+{
+    if (put_key(b, format, key, first, NV_TRUE)) {
+        buf_puts(b, value ? "true" : "false");
+    }
+}
+
+
+/*
+ * put_list() - append a list of 'n' items; in the JSON format this is
+ * an array (of strings if 'strings' is given, else of 'ints'), in the
+ * other formats the items are joined with ','.
+ */
+
+static void put_list(RecordBuffer *b, int format, const char *key,
+                     int *first, const char **strings, const int *ints,
+                     int n)
+{
+    char item[16], joined[512];
+    const char *s;
+    int i, len = 0;
+
+    if (!put_key(b, format, key, first, n > 0)) return;
+
+    if (format == NV_QUERY_FORMAT_JSON) {
+        buf_putn(b, "[", 1);
+        for (i = 0; i < n; i++) {
+            if (i > 0) buf_putn(b, ",", 1);
+            if (strings) {
+                put_quoted(b, format, strings[i]);
+            } else {
+                buf_printf(b, "%d", ints[i]);
+            }
+        }
+        buf_putn(b, "]", 1);
+        return;
+    }
+
+    joined[0] = '\0';
+    for (i = 0; i < n; i++) {
+        if (strings) {
+            s = strings[i];
+        } else {
+            snprintf(item, sizeof(item), "%d", ints[i]);
+            s = item;
+        }
+        len += snprintf(joined + len, sizeof(joined) - len, "%s%s",
+                        (i > 0) ? "," : "", s);
+        if (len >= sizeof(joined)) break;
+    }
+
+    put_quoted(b, format, joined);
+
+} /* put_list() */
+
+
+
+static const char *get_type_name(const NVCTRLAttributeValidValuesRec *valid,
+                                 uint32 attr_flags)
+{
+    int packed = (attr_flags & NV_PARSER_TYPE_PACKED_ATTRIBUTE);
+
+    switch (valid->type) {
+    case ATTRIBUTE_TYPE_INTEGER:       return packed ? "packed" : "integer";
+    case ATTRIBUTE_TYPE_BITMASK:       return "bitmask";
+    case ATTRIBUTE_TYPE_BOOL:          return "bool";
+    case ATTRIBUTE_TYPE_RANGE:         return packed ? "packed_range" : "range";
+    case ATTRIBUTE_TYPE_INT_BITS:      return "int_bits";
+    case ATTRIBUTE_TYPE_64BIT_INTEGER: return "int64";
+    case ATTRIBUTE_TYPE_STRING:        return "string";
+    default:                           return "unknown";
+    }
+}
+
+
+
+/*
+ * nv_query_format_from_string() - return the NvQueryFormat named by
+ * 'str', or -1 if there is no such format.
+ */
+
+int nv_query_format_from_string(const char *str)
+{
+    if (nv_strcasecmp(str, "text")) return NV_QUERY_FORMAT_TEXT;
+    if (nv_strcasecmp(str, "json")) return NV_QUERY_FORMAT_JSON;
+    if (nv_strcasecmp(str, "csv"))  return NV_QUERY_FORMAT_CSV;
+    if (nv_strcasecmp(str, "kv"))   return NV_QUERY_FORMAT_KV;
+
+    return -1;
+
+} /* nv_query_format_from_string() */
+
+
+
+/*
+ * nv_query_format_begin() - write anything that precedes the records;
+ * i.e., the CSV header line.  If 'timestamps' is NV_TRUE, each record
+ * will start with a "time" field.
+ */
+
+void nv_query_format_begin(int format, int timestamps)
+{
+    if (format == NV_QUERY_FORMAT_CSV) {
+        if (timestamps) fputs("time,", nv_msg_output_stream());
+        fputs(csv_columns, nv_msg_output_stream());
+    }
+
+} /* nv_query_format_begin() */
+
+
+
+/*
+ * nv_query_format_record() - write one record.  'time' is NULL unless
+ * timestamps were requested from nv_query_format_begin();
+ * 'display_mask' is 0 for attributes that are not display device
+ * specific; 'string' is the value of string attributes, else 'value'
+ * is used.
+ */
+
+void nv_query_format_record(int format, const char *time,
+                            const char *target,
+                            const char *attribute, uint32 attr_flags,
+                            uint32 display_mask,
+                            const NVCTRLAttributeValidValuesRec *valid,
+                            int64_t value, const char *string)
+{
+    RecordBuffer b;
+    const char *target_types[16];
+    char *display_device = NULL;
+    int valid_values[32];
+    int first = NV_TRUE, range, n, i;
+
+    if (format == NV_QUERY_FORMAT_TEXT) return;
+
+    buf_init(&b);
+
+    if (display_mask) {
+        display_device = display_device_mask_to_display_device_name(display_mask);
+    }
+
+    if (time) put_string(&b, format, "time", &first, time);
+    put_string(&b, format, "target", &first, target);
+    put_string(&b, format, "attribute", &first, attribute);
+    put_string(&b, format, "display_device", &first, display_device);
+    put_int(&b, format, "display_mask", &first, display_mask != 0,
+            display_mask);
+    put_string(&b, format, "type", &first, get_type_name(valid, attr_flags));
+
+    if (valid->type == ATTRIBUTE_TYPE_STRING) {
+        put_string(&b, format, "value", &first, string ? string : "");
+    } else {
+        put_int(&b, format, "value", &first, NV_TRUE, value);
+    }
+
+    range = (valid->type == ATTRIBUTE_TYPE_RANGE);
+    put_int(&b, format, "min", &first, range, range ? valid->u.range.min : 0);
+    put_int(&b, format, "max", &first, range, range ? valid->u.range.max : 0);
+
+    n = 0;
+    if (valid->type == ATTRIBUTE_TYPE_INT_BITS) {
+        for (i = 0; i < 32; i++) {
+            if (valid->u.bits.ints & (1 << i)) valid_values[n++] = i;
+        }
+    }
+    put_list(&b, format, "valid_values", &first, NULL, valid_values, n);
+
+    put_bool(&b, format, "writable", &first,
+             valid->permissions & ATTRIBUTE_TYPE_WRITE);
+    put_bool(&b, format, "display_specific", &first,
+             valid->permissions & ATTRIBUTE_TYPE_DISPLAY);
+
+    n = 0;
+    for (i = 0; targetTypeTable[i].name && n < 16; i++) {
+        if (valid->permissions & targetTypeTable[i].permission_bit) {
+            target_types[n++] = targetTypeTable[i].parsed_name;
+        }
+    }
+    put_list(&b, format, "target_types", &first, target_types, NULL, n);
+
+    buf_puts(&b, (format == NV_QUERY_FORMAT_JSON) ? "}\n" : "\n");
+
+    buf_write(&b);
+
+    free(display_device);
+
+} /* nv_query_format_record() */
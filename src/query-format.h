@@ -0,0 +1,63 @@
+/*
+ * nvidia-settings: A tool for configuring the NVIDIA X driver on Unix
+ * and Linux systems.
+ *
+ * Copyright (C) 2004 NVIDIA Corporation.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of Version 2 of the GNU General Public
+ * License as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See Version 2
+ * of the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the:
+ *
+ *           Free Software Foundation, Inc.
+ *           59 Temple Place - Suite 330
+ *           Boston, MA 02111-1307, USA
+ *
+ */
+
+#ifndef __QUERY_FORMAT_H__
+#define __QUERY_FORMAT_H__
+
+#include <stdint.h>
+
+#include "NvCtrlAttributes.h"
+#include "parse.h"
+
+/*
+ * Machine-readable output for attribute queries (see the '--format'
+ * commandline option).  Each queried (target, display device,
+ * attribute) becomes one record, written in one piece to the message
+ * output stream (see nv_msg_set_thread_streams()), without going
+ * through the word wrapping done for messages:
+ *
+ *   json - one JSON object per line
+ *   csv  - a header line, followed by one line per record
+ *   kv   - one line of space-separated key=value pairs per record
+ */
+
+typedef enum {
+    NV_QUERY_FORMAT_TEXT = 0,
+    NV_QUERY_FORMAT_JSON,
+    NV_QUERY_FORMAT_CSV,
+    NV_QUERY_FORMAT_KV,
+} NvQueryFormat;
+
+int nv_query_format_from_string(const char *str);
+
+void nv_query_format_begin(int format, int timestamps);
+
+void nv_query_format_record(int format, const char *time,
+                            const char *target,
+                            const char *attribute, uint32 attr_flags,
+                            uint32 display_mask,
+                            const NVCTRLAttributeValidValuesRec *valid,
+                            int64_t value, const char *string);
+
+#endif /* __QUERY_FORMAT_H__ */
@@ -0,0 +1,453 @@
+/*
+ * nvidia-settings: A tool for configuring the NVIDIA X driver on Unix
+ * and Linux systems.
+ *
+ * Copyright (C) 2004 NVIDIA Corporation.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of Version 2 of the GNU General Public
+ * License as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See Version 2
+ * of the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the:
+ *
+ *           Free Software Foundation, Inc.
+ *           59 Temple Place - Suite 330
+ *           Boston, MA 02111-1307, USA
+ *
+ */
+
+/*
+ * sampler.c - this source file contains the headless telemetry
+ * sampler (the --sample option); see sampler.h for the layout of the
+ * ring file it writes.
+ *
+ * Each tick costs one NvCtrlQueryBatch() round trip to the X server
+ * for all GPUs and attributes, and a few stores into the mapped file;
+ * no memory is allocated and no system calls are made besides the
+ * query and the sleep until the next tick.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <signal.h>
+#include <time.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/time.h>
+
+#include "NvCtrlAttributes.h"
+
+#include "sampler.h"
+#include "query-assign.h"
+#include "parse.h"
+#include "msg.h"
+
+
+#define MAX_SAMPLED_GPUS 64
+
+/*
+ * The attributes sampled by default: the ones shown, and updated
+ * periodically, by the thermal, PowerMizer and GPU (PCI Express)
+ * pages of the GUI.
+ */
+
+static const char *default_attributes[] = {
+    "GPUCoreTemp",
+    "GPUCurrentClockFreqs",
+    "GPUCurrentProcessorClockFreqs",
+    "GPUCurrentPerfLevel",
+    "GPUAdaptiveClockState",
+    "GPUPowerSource",
+    "GPUPowerMizerMode",
+    "PCIEGen",
+    "BusRate",
+    "PCIEMaxLinkSpeed",
+    NULL
+};
+
+typedef struct {
+    NvSampleFileHeader *header;
+    char *records;
+    size_t size;
+
+    int num_gpus;
+    uint32_t gpus[MAX_SAMPLED_GPUS];
+
+    NvCtrlBatchQuery *batch;    /* num_gpus * num_attributes queries */
+} Sampler;
+
+static volatile sig_atomic_t stop_sampling = 0;
+
+
+
+static void stop_handler(int sig)
+{
+    stop_sampling = 1;
+}
+
+
+
+static uint64_t get_time_us(void)
+{
+    struct timeval tv;
+
+    gettimeofday(&tv, NULL);
+
+    return (uint64_t) tv.tv_sec * 1000000 + tv.tv_usec;
+
+} /* get_time_us() */
+
+
+
+/*
+ * add_attribute() - look up the named attribute, and add it to the
+ * header; only integer attributes can be sampled.
+ */
+
+static int add_attribute(NvSampleFileHeader *header, const char *name)
+{
+    AttributeTableEntry *a = nv_get_attribute_entry(name);
+    int n = header->num_attributes;
+
+    if (!a) {
+        nv_error_msg("Unknown attribute '%s' given to --sample-attributes.",
+                     name);
+        return NV_FALSE;
+    }
+
+    if (a->flags & (NV_PARSER_TYPE_STRING_ATTRIBUTE |
+                    NV_PARSER_TYPE_COLOR_ATTRIBUTE |
+                    NV_PARSER_TYPE_SDI_CSC |
+                    NV_PARSER_TYPE_GUI_ATTRIBUTE |
+                    NV_PARSER_TYPE_XVIDEO_ATTRIBUTE)) {
+        nv_error_msg("The attribute '%s' cannot be sampled.", a->name);
+        return NV_FALSE;
+    }
+
+    if (n >= NV_SAMPLE_MAX_ATTRIBUTES) {
+        nv_error_msg("Too many attributes to sample; at most %d can be "
+                     "sampled.", NV_SAMPLE_MAX_ATTRIBUTES);
+        return NV_FALSE;
+    }
+
+    header->attributes[n] = a->attr;
+    strncpy(header->names[n], a->name, NV_SAMPLE_NAME_LEN - 1);
+    header->num_attributes++;
+
+    return NV_TRUE;
+
+} /* add_attribute() */
+
+
+
+/*
+ * init_attributes() - fill in the attributes of the header, from the
+ * comma separated list of attribute names (or the default list).
+ */
+
+static int init_attributes(NvSampleFileHeader *header, const char *list)
+{
+    char *str, *name, *next;
+    int i, ret = NV_TRUE;
+
+    if (!list) {
+        for (i = 0; default_attributes[i]; i++) {
+            if (!add_attribute(header, default_attributes[i])) return NV_FALSE;
+        }
+        return NV_TRUE;
+    }
+
+    str = strdup(list);
+    if (!str) return NV_FALSE;
+
+    for (name = str; name && ret; name = next) {
+        next = strchr(name, ',');
+        if (next) *next++ = '\0';
+
+        name = (char *) parse_skip_whitespace(name);
+        parse_chop_whitespace(name);
+        if (*name == '\0') continue;
+
+        ret = add_attribute(header, name);
+    }
+
+    free(str);
+
+    if (ret && header->num_attributes == 0) {
+        nv_error_msg("No attributes given to --sample-attributes.");
+        ret = NV_FALSE;
+    }
+
+    return ret;
+
+} /* init_attributes() */
+
+
+
+/*
+ * map_ring_file() - create (or reuse) the ring file, size it for the
+ * header and records, and map it.  The header is written last, so
+ * that a reader never sees a valid magic number with a stale layout.
+ */
+
+static int map_ring_file(Sampler *s, const char *filename,
+                         const NvSampleFileHeader *header)
+{
+    int fd;
+    void *p;
+
+    s->size = header->header_size +
+        (size_t) header->record_size * header->num_records;
+
+    fd = open(filename, O_RDWR | O_CREAT, 0644);
+    if (fd < 0) {
+        nv_error_msg("Unable to open sample file '%s' (%s).",
+                     filename, strerror(errno));
+        return NV_FALSE;
+    }
+
+    if (ftruncate(fd, s->size) != 0) {
+        nv_error_msg("Unable to set the size of sample file '%s' (%s).",
+                     filename, strerror(errno));
+        close(fd);
+        return NV_FALSE;
+    }
+
+    p = mmap(NULL, s->size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    close(fd);
+
+    if (p == MAP_FAILED) {
+        nv_error_msg("Unable to map sample file '%s' (%s).",
+                     filename, strerror(errno));
+        return NV_FALSE;
+    }
+
+    s->header = p;
+    s->records = (char *) p + header->header_size;
+
+    s->header->magic = 0;
+    __sync_synchronize();
+
+    memset(s->records, 0, s->size - header->header_size);
+    memcpy(s->header, header, sizeof(NvSampleFileHeader));
+    __sync_synchronize();
+
+    s->header->magic = NV_SAMPLE_FILE_MAGIC;
+
+    return NV_TRUE;
+
+} /* map_ring_file() */
+
+
+
+/*
+ * write_tick() - append the results of the batch to the ring; one
+ * record per GPU.
+ */
+
+static void write_tick(Sampler *s, uint64_t time_us)
+{
+    NvSampleFileHeader *header = s->header;
+    NvSampleRecord *rec;
+    NvCtrlBatchQuery *q;
+    int64_t *values;
+    uint64_t seq = header->sequence;
+    int g, i;
+
+    for (g = 0; g < s->num_gpus; g++) {
+
+        seq++;
+
+        rec = (NvSampleRecord *)
+            (s->records + ((seq - 1) % header->num_records) *
+             header->record_size);
+        values = (int64_t *) (rec + 1);
+
+        rec->sequence = 0;
+        __sync_synchronize();
+
+        rec->time_us = time_us;
+        rec->gpu = s->gpus[g];
+        rec->valid = 0;
+
+        for (i = 0; i < header->num_attributes; i++) {
+            q = &s->batch[g * header->num_attributes + i];
+            if (q->status == NvCtrlSuccess) {
+                values[i] = q->value;
+                rec->valid |= (1U << i);
+            } else {
+                values[i] = 0;
+            }
+        }
+
+        __sync_synchronize();
+        rec->sequence = seq;
+    }
+
+    __sync_synchronize();
+    header->sequence = seq;
+
+} /* write_tick() */
+
+
+
+/*
+ * wait_until() - sleep until the given time, or until we are asked
+ * to stop.
+ */
+
+static void wait_until(uint64_t time_us)
+{
+    struct timespec ts;
+    uint64_t now;
+
+    while (!stop_sampling) {
+        now = get_time_us();
+        if (now >= time_us) break;
+
+        ts.tv_sec = (time_us - now) / 1000000;
+        ts.tv_nsec = ((time_us - now) % 1000000) * 1000;
+
+        nanosleep(&ts, NULL);
+    }
+
+} /* wait_until() */
+
+
+
+/*
+ * nv_sampler_run() - sample the attributes on all GPUs of the display
+ * into the ring file, every options->interval milliseconds, until
+ * interrupted (SIGINT or SIGTERM).  Returns NV_FALSE if sampling
+ * could not be started.
+ */
+
+int nv_sampler_run(const char *display, const NvSamplerOptions *options)
+{
+    Sampler s;
+    NvSampleFileHeader header;
+    CtrlHandles *h;
+    CtrlHandleTarget *t;
+    NvCtrlBatchQuery *q;
+    struct sigaction sa, old_int, old_term;
+    uint64_t next;
+    int i, g, n, ret = NV_FALSE;
+
+    memset(&s, 0, sizeof(s));
+    memset(&header, 0, sizeof(header));
+
+    if (!init_attributes(&header, options->attributes)) return NV_FALSE;
+
+    h = nv_alloc_ctrl_handles(display);
+
+    if (!h || !h->dpy) {
+        nv_error_msg("Unable to sample attributes on X display '%s'.",
+                     XDisplayName(display));
+        goto done;
+    }
+
+    /* collect the GPUs we can talk to */
+
+    for (i = 0; i < h->targets[GPU_TARGET].n; i++) {
+        t = nv_get_ctrl_handle_target(h, GPU_TARGET, i);
+        if (!t->h) continue;
+        if (s.num_gpus == MAX_SAMPLED_GPUS) {
+            nv_warning_msg("Only the first %d GPUs are sampled.",
+                           MAX_SAMPLED_GPUS);
+            break;
+        }
+        s.gpus[s.num_gpus++] = i;
+    }
+
+    if (s.num_gpus == 0) {
+        nv_error_msg("No GPUs to sample on X display '%s'.",
+                     XDisplayName(display));
+        goto done;
+    }
+
+    /* set up the batch, which is reused for every tick */
+
+    n = s.num_gpus * header.num_attributes;
+
+    s.batch = calloc(n, sizeof(NvCtrlBatchQuery));
+    if (!s.batch) {
+        nv_error_msg("Unable to allocate memory for %d queries.", n);
+        goto done;
+    }
+
+    for (g = 0; g < s.num_gpus; g++) {
+        t = nv_get_ctrl_handle_target(h, GPU_TARGET, s.gpus[g]);
+        for (i = 0; i < header.num_attributes; i++) {
+            q = &s.batch[g * header.num_attributes + i];
+            q->handle = t->h;
+            q->query_type = NV_CTRL_BATCH_GET_ATTRIBUTE;
+            q->display_mask = 0;
+            q->attr = header.attributes[i];
+        }
+    }
+
+    /* lay out and map the ring file */
+
+    header.magic = 0; /* set once the file is ready */
+    header.version = NV_SAMPLE_FILE_VERSION;
+    header.header_size = (sizeof(NvSampleFileHeader) + 63) & ~63;
+    header.record_size = (sizeof(NvSampleRecord) +
+                          sizeof(int64_t) * header.num_attributes + 7) & ~7;
+    header.num_records = options->history * s.num_gpus;
+    header.num_gpus = s.num_gpus;
+    header.interval_ms = options->interval;
+    header.start_time_us = get_time_us();
+    header.sequence = 0;
+
+    if (!map_ring_file(&s, options->file, &header)) goto done;
+
+    nv_info_msg(NULL, "Sampling %d attributes on %d GPUs every %d ms into "
+                "'%s'.", header.num_attributes, s.num_gpus,
+                options->interval, options->file);
+
+    /* sample until interrupted */
+
+    memset(&sa, 0, sizeof(sa));
+    sa.sa_handler = stop_handler;
+    sigemptyset(&sa.sa_mask);
+    sigaction(SIGINT, &sa, &old_int);
+    sigaction(SIGTERM, &sa, &old_term);
+
+    next = get_time_us();
+
+    while (!stop_sampling) {
+        NvCtrlQueryBatch(s.batch, n);
+        write_tick(&s, get_time_us());
+
+        /* don't try to catch up after falling behind */
+
+        next += (uint64_t) options->interval * 1000;
+        if (next < get_time_us()) {
+            next = get_time_us() + (uint64_t) options->interval * 1000;
+        }
+
+        wait_until(next);
+    }
+
+    sigaction(SIGINT, &old_int, NULL);
+    sigaction(SIGTERM, &old_term, NULL);
+
+    ret = NV_TRUE;
+
+ done:
+    if (s.header) munmap(s.header, s.size);
+    free(s.batch);
+    nv_free_ctrl_handles(h);
+
+    return ret;
+
+} /* nv_sampler_run() */
@@ -0,0 +1,92 @@
+/*
+ * nvidia-settings: A tool for configuring the NVIDIA X driver on Unix
+ * and Linux systems.
+ *
+ * Copyright (C) 2004 NVIDIA Corporation.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of Version 2 of the GNU General Public
+ * License as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See Version 2
+ * of the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the:
+ *
+ *           Free Software Foundation, Inc.
+ *           59 Temple Place - Suite 330
+ *           Boston, MA 02111-1307, USA
+ *
+ */
+
+#ifndef __SAMPLER_H__
+#define __SAMPLER_H__
+
+#include <stdint.h>
+
+/*
+ * Headless telemetry sampler: every tick, a fixed set of GPU
+ * attributes is queried on all GPUs of an X display (with one
+ * NvCtrlQueryBatch() round trip), and one record per GPU is appended
+ * to a ring of fixed-size records in a memory-mapped file.
+ *
+ * The file is laid out as an NvSampleFileHeader, followed by
+ * 'num_records' records of 'record_size' bytes each: an
+ * NvSampleRecord, followed by 'num_attributes' int64_t values in the
+ * order given by 'attributes'.  All fields are in host byte order.
+ *
+ * Readers do not take any lock.  Records are numbered from 1; record
+ * 'seq' is stored in slot ((seq - 1) % num_records).  The writer sets
+ * the record's 'sequence' to 0 while it fills the record in, then to
+ * 'seq', and advances the header's 'sequence' to the last record
+ * written once all GPUs of a tick are written.  A reader copies a
+ * record, and keeps the copy only if the record's 'sequence' was
+ * 'seq' both before and after the copy.
+ */
+
+#define NV_SAMPLE_FILE_MAGIC    0x5253564e /* "NVSR" */
+#define NV_SAMPLE_FILE_VERSION  1
+
+#define NV_SAMPLE_MAX_ATTRIBUTES 32
+#define NV_SAMPLE_NAME_LEN       32
+
+typedef struct {
+    uint32_t magic;             /* NV_SAMPLE_FILE_MAGIC */
+    uint32_t version;           /* NV_SAMPLE_FILE_VERSION */
+    uint32_t header_size;       /* offset of the first record */
+    uint32_t record_size;       /* size of each record, in bytes */
+    uint32_t num_records;       /* number of records in the ring */
+    uint32_t num_gpus;          /* number of records per tick */
+    uint32_t num_attributes;    /* number of values per record */
+    uint32_t interval_ms;       /* time between ticks */
+    uint64_t start_time_us;     /* when the sampler started */
+    volatile uint64_t sequence; /* last record written; 0 if none */
+
+    int32_t attributes[NV_SAMPLE_MAX_ATTRIBUTES];       /* NV-CONTROL ids */
+    char names[NV_SAMPLE_MAX_ATTRIBUTES][NV_SAMPLE_NAME_LEN];
+} NvSampleFileHeader;
+
+typedef struct {
+    volatile uint64_t sequence; /* see above */
+    uint64_t time_us;           /* time of the tick, since the Epoch */
+    uint32_t gpu;               /* GPU target id */
+    uint32_t valid;             /* bit n is set if value n was queried */
+    /* int64_t values[num_attributes] follows */
+} NvSampleRecord;
+
+typedef struct {
+    char *file;         /* ring file to write; NULL if not sampling */
+    char *attributes;   /* comma separated attribute names; NULL: default */
+    int interval;       /* milliseconds between ticks */
+    int history;        /* number of ticks kept in the ring */
+} NvSamplerOptions;
+
+#define NV_SAMPLE_DEFAULT_INTERVAL 1000
+#define NV_SAMPLE_DEFAULT_HISTORY  3600
+
+int nv_sampler_run(const char *display, const NvSamplerOptions *options);
+
+#endif /* __SAMPLER_H__ */
@@ -55,6 +55,7 @@ endif
 
 INSTALL               ?= install
 INSTALL_BIN_ARGS      ?= -m 755
+INSTALL_LIB_ARGS      ?= -m 644
 INSTALL_DOC_ARGS      ?= -m 644
 
 M4                    ?= m4
@@ -119,6 +120,7 @@ prefix = /usr/local
 
 exec_prefix = $(prefix)
 bindir = $(exec_prefix)/bin
+libdir = $(exec_prefix)/lib
 mandir = $(exec_prefix)/share/man/man1
 
 